@@ -24,7 +24,26 @@ typedef struct {
 	int index;
 } detexBlock128;
 
-uint32_t detexBlock128ExtractBits(detexBlock128 *block, int nu_bits);
+/* Return nu_bits (at most 63) bits starting at bit index of a 128-bit bitstring, */
+/* extracting the field with shifts across the boundary between data0 and data1. */
+static DETEX_INLINE_ONLY uint64_t detexBlock128GetBits(const detexBlock128 *block, int index, int nu_bits) {
+	uint64_t value;
+	if (index >= 64)
+		value = block->data1 >> (index - 64);
+	else if (index == 0)
+		value = block->data0;
+	else
+		value = (block->data0 >> index) | (block->data1 << (64 - index));
+	return value & (((uint64_t)1 << nu_bits) - 1);
+}
+
+/* Extract nu_bits (at most 32) bits at the current index of a 128-bit bitstring and */
+/* advance the index. */
+static DETEX_INLINE_ONLY uint32_t detexBlock128ExtractBits(detexBlock128 *block, int nu_bits) {
+	uint32_t value = detexBlock128GetBits(block, block->index, nu_bits);
+	block->index += nu_bits;
+	return value;
+}
 
 /* Return bitfield from bit0 to bit1 from 64-bit bitstring. */
 static DETEX_INLINE_ONLY uint32_t detexGetBits64(uint64_t data, int bit0, int bit1) {
@@ -19,11 +19,15 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <fenv.h>
+#include <pthread.h>
 
 #include "detex.h"
 #include "half-float.h"
 #include "hdr.h"
 #include "misc.h"
+#include "simd.h"
 
 // Conversion functions. For conversions where the pixel size is unchanged,
 // the conversion is performed in-place and target_pixel_buffer will be NULL.
@@ -372,36 +376,21 @@ int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 
 static void ConvertPixel32RGBX8ToPixel64RGBX16(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
-	uint32_t *source_pixel32_buffer = (uint32_t *)source_pixel_buffer;
-	uint64_t *target_pixel64_buffer = (uint64_t *)target_pixel_buffer;
+	uint16_t *target_pixel16_buffer = (uint16_t *)target_pixel_buffer;
 	for (int i = 0; i < nu_pixels; i++) {
-		uint32_t pixel = *source_pixel32_buffer;
-		*target_pixel64_buffer = detexPack64RGBA16(
-			detexPixel32GetR8(pixel) * 65535 / 255,
-			detexPixel32GetG8(pixel) * 65535 / 255,
-			detexPixel32GetB8(pixel) * 65535 / 255,
-			0xFFFF
-			);
-		source_pixel32_buffer++;
-		target_pixel64_buffer++;
+		target_pixel16_buffer[i * 4] = source_pixel_buffer[i * 4] * 257;
+		target_pixel16_buffer[i * 4 + 1] = source_pixel_buffer[i * 4 + 1] * 257;
+		target_pixel16_buffer[i * 4 + 2] = source_pixel_buffer[i * 4 + 2] * 257;
+		target_pixel16_buffer[i * 4 + 3] = 0xFFFF;
 	}
 }
 
 static void ConvertPixel32RGBA8ToPixel64RGBA16(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
-	uint32_t *source_pixel32_buffer = (uint32_t *)source_pixel_buffer;
-	uint64_t *target_pixel64_buffer = (uint64_t *)target_pixel_buffer;
-	for (int i = 0; i < nu_pixels; i++) {
-		uint32_t pixel = *source_pixel32_buffer;
-		*target_pixel64_buffer = detexPack64RGBA16(
-			detexPixel32GetR8(pixel) * 65535 / 255,
-			detexPixel32GetG8(pixel) * 65535 / 255,
-			detexPixel32GetB8(pixel) * 65535 / 255,
-			detexPixel32GetA8(pixel) * 65535 / 255
-			);
-		source_pixel32_buffer++;
-		target_pixel64_buffer++;
-	}
+	// Multiplying an 8-bit component by 257 is identical to multiplying by 65535 / 255.
+	uint16_t *target_pixel16_buffer = (uint16_t *)target_pixel_buffer;
+	for (int i = 0; i < nu_pixels * 4; i++)
+		target_pixel16_buffer[i] = source_pixel_buffer[i] * 257;
 }
 
 // Float to half-float conversion.
@@ -612,19 +601,19 @@ int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 static void ConvertPixel16FloatR16HDRToPixel16R16(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 	uint16_t *source_pixel16_buffer = (uint16_t *)source_pixel_buffer;
-	detexConvertHDRHalfFloatToUInt16(source_pixel16_buffer, nu_pixels);
+	detexConvertHDRHalfFloatToUInt16(source_pixel16_buffer, nu_pixels, detexGetHDRParameters());
 }
 
 static void ConvertPixel32FloatRG16HDRToPixel32RG16(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 	uint16_t *source_pixel16_buffer = (uint16_t *)source_pixel_buffer;
-	detexConvertHDRHalfFloatToUInt16(source_pixel16_buffer, nu_pixels * 2);
+	detexConvertHDRHalfFloatToUInt16(source_pixel16_buffer, nu_pixels * 2, detexGetHDRParameters());
 }
 
 static void ConvertPixel64FloatRGBX16HDRToPixel64RGBX16(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 	uint16_t *source_pixel16_buffer = (uint16_t *)source_pixel_buffer;
-	detexConvertHDRHalfFloatToUInt16(source_pixel16_buffer, nu_pixels * 4);
+	detexConvertHDRHalfFloatToUInt16(source_pixel16_buffer, nu_pixels * 4, detexGetHDRParameters());
 }
 
 // Conversion HDR float to float (in_place).
@@ -632,25 +621,25 @@ int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 static void ConvertPixel32FloatR32HDRToPixel32FloatR32(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 	float *source_pixelf_buffer = (float *)source_pixel_buffer;
-	detexConvertHDRFloatToFloat(source_pixelf_buffer, nu_pixels);
+	detexConvertHDRFloatToFloat(source_pixelf_buffer, nu_pixels, detexGetHDRParameters());
 }
 
 static void ConvertPixel64FloatRG32HDRToPixel64FloatRG32(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 	float *source_pixelf_buffer = (float *)source_pixel_buffer;
-	detexConvertHDRFloatToFloat(source_pixelf_buffer, nu_pixels * 2);
+	detexConvertHDRFloatToFloat(source_pixelf_buffer, nu_pixels * 2, detexGetHDRParameters());
 }
 
 static void ConvertPixel96FloatRGB32HDRToPixel96FloatRGB32(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 	float *source_pixelf_buffer = (float *)source_pixel_buffer;
-	detexConvertHDRFloatToFloat(source_pixelf_buffer, nu_pixels * 3);
+	detexConvertHDRFloatToFloat(source_pixelf_buffer, nu_pixels * 3, detexGetHDRParameters());
 }
 
 static void ConvertPixel128FloatRGBX32HDRToPixel128FloatRGBX32(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 	float *source_pixelf_buffer = (float *)source_pixel_buffer;
-	detexConvertHDRFloatToFloat(source_pixelf_buffer, nu_pixels * 4);
+	detexConvertHDRFloatToFloat(source_pixelf_buffer, nu_pixels * 4, detexGetHDRParameters());
 }
 
 // Conversion between packed RGB8 and RGBX8 and vice-versa.
@@ -704,7 +693,7 @@ uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 static void ConvertPixel64RGBX16ToPixel48RGB16(uint8_t * DETEX_RESTRICT source_pixel_buffer, int nu_pixels,
 uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 	uint64_t *source_pixel64_buffer = (uint64_t *)source_pixel_buffer;
-	uint16_t *target_pixel16_buffer = (uint16_t *)target_pixel16_buffer;
+	uint16_t *target_pixel16_buffer = (uint16_t *)target_pixel_buffer;
 	for (int i = 0; i < nu_pixels; i++) {
 		uint64_t pixel = *source_pixel64_buffer;
 		target_pixel16_buffer[0] = detexPixel64GetR16(pixel);
@@ -751,6 +740,380 @@ uint8_t * DETEX_RESTRICT target_pixel_buffer) {
 }
 
 
+// SIMD versions of the conversions between 8-bit and 16-bit component formats. Each of
+// these conversions is described by a byte shuffle that produces the target pixels of a
+// group of source pixels stored in 16 bytes, optionally preceded by the conversion of
+// 16-bit components to 8 bits and followed by OR and XOR masks (used for constant
+// components and the signed/unsigned conversions). The shuffles are performed with SSSE3
+// or, two groups at a time, with AVX2. The remaining pixels are converted by the scalar
+// functions above, and the results are identical.
+
+typedef struct {
+	int source_pixel_size;
+	int target_pixel_size;
+	// Number of pixels converted per group.
+	int nu_pixels;
+	// Whether 16-bit source components are converted to 8 bits (stored in the low byte of
+	// each component) before the shuffle.
+	bool narrow;
+	// Shuffle control for each target byte; 0x80 selects zero.
+	uint8_t shuffle[16];
+	uint8_t or_mask[16];
+	uint8_t xor_mask[16];
+} ShuffleConversion;
+
+#ifdef DETEX_USE_AVX2
+
+static DETEX_INLINE_ONLY DETEX_TARGET_SSSE3 __m128i ApplyShuffleConversionSSSE3(const ShuffleConversion *c,
+__m128i v) {
+	if (c->narrow)
+		// (x + 127) * 255 / 65535 is equal to min(x + 127, 65535) / 257, which is
+		// calculated exactly as (y * 0xFF01) >> 24.
+		v = _mm_srli_epi16(_mm_mulhi_epu16(_mm_adds_epu16(v, _mm_set1_epi16(127)),
+			_mm_set1_epi16((short)0xFF01)), 8);
+	v = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)c->shuffle));
+	v = _mm_or_si128(v, _mm_loadu_si128((const __m128i *)c->or_mask));
+	return _mm_xor_si128(v, _mm_loadu_si128((const __m128i *)c->xor_mask));
+}
+
+static DETEX_INLINE_ONLY DETEX_TARGET_AVX2 __m256i ApplyShuffleConversionAVX2(const ShuffleConversion *c,
+__m256i v) {
+	if (c->narrow)
+		v = _mm256_srli_epi16(_mm256_mulhi_epu16(_mm256_adds_epu16(v, _mm256_set1_epi16(127)),
+			_mm256_set1_epi16((short)0xFF01)), 8);
+	v = _mm256_shuffle_epi8(v, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)c->shuffle)));
+	v = _mm256_or_si256(v, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)c->or_mask)));
+	return _mm256_xor_si256(v, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)c->xor_mask)));
+}
+
+// Store the first n bytes of a vector. The target need not be aligned, so the partial
+// stores go through memcpy.
+static DETEX_INLINE_ONLY void StoreBytesSSE2(uint8_t *p, __m128i v, int n) {
+	uint32_t word;
+	uint16_t half_word;
+	switch (n) {
+	case 16 :
+		_mm_storeu_si128((__m128i *)p, v);
+		break;
+	case 12 :
+		_mm_storel_epi64((__m128i *)p, v);
+		word = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+		memcpy(p + 8, &word, 4);
+		break;
+	case 8 :
+		_mm_storel_epi64((__m128i *)p, v);
+		break;
+	case 6 :
+		word = _mm_cvtsi128_si32(v);
+		half_word = _mm_extract_epi16(v, 2);
+		memcpy(p, &word, 4);
+		memcpy(p + 4, &half_word, 2);
+		break;
+	case 4 :
+		word = _mm_cvtsi128_si32(v);
+		memcpy(p, &word, 4);
+		break;
+	}
+}
+
+// Convert groups of pixels, returning the number of pixels converted. The 16 bytes loaded
+// for each group must lie within the source buffer, so the last few pixels are left to
+// the scalar code. For in-place conversions target_pixel_buffer is equal to
+// source_pixel_buffer.
+static DETEX_INLINE_ONLY DETEX_TARGET_SSSE3 int ConvertPixelsShuffleSSSE3(const ShuffleConversion *c,
+const uint8_t *source_pixel_buffer, int nu_pixels, uint8_t *target_pixel_buffer) {
+	int source_size = c->source_pixel_size;
+	int target_size = c->target_pixel_size;
+	int i;
+	for (i = 0; (size_t)i * source_size + 16 <= (size_t)nu_pixels * source_size; i += c->nu_pixels) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(source_pixel_buffer + i * source_size));
+		StoreBytesSSE2(target_pixel_buffer + i * target_size, ApplyShuffleConversionSSSE3(c, v),
+			c->nu_pixels * target_size);
+	}
+	return i;
+}
+
+static DETEX_INLINE_ONLY DETEX_TARGET_AVX2 int ConvertPixelsShuffleAVX2(const ShuffleConversion *c,
+const uint8_t *source_pixel_buffer, int nu_pixels, uint8_t *target_pixel_buffer) {
+	int source_size = c->source_pixel_size;
+	int target_size = c->target_pixel_size;
+	int n = c->nu_pixels;
+	int i;
+	for (i = 0; (size_t)(i + n) * source_size + 16 <= (size_t)nu_pixels * source_size; i += n * 2) {
+		// Load two groups into the two 128-bit lanes.
+		__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(
+			_mm_loadu_si128((const __m128i *)(source_pixel_buffer + i * source_size))),
+			_mm_loadu_si128((const __m128i *)(source_pixel_buffer + (i + n) * source_size)), 1);
+		v = ApplyShuffleConversionAVX2(c, v);
+		if (n * target_size == 16)
+			_mm256_storeu_si256((__m256i *)(target_pixel_buffer + i * target_size), v);
+		else {
+			StoreBytesSSE2(target_pixel_buffer + i * target_size, _mm256_castsi256_si128(v),
+				n * target_size);
+			StoreBytesSSE2(target_pixel_buffer + (i + n) * target_size,
+				_mm256_extracti128_si256(v, 1), n * target_size);
+		}
+	}
+	return i;
+}
+
+// Define func##SIMD, which converts pixels with the SIMD code paths and the remaining
+// pixels with func.
+#define SHUFFLE_CONVERSION_FUNCTION(func, conversion) \
+	static DETEX_TARGET_SSSE3 int func##SSSE3(const uint8_t *source_pixel_buffer, int nu_pixels, \
+	uint8_t *target_pixel_buffer) { \
+		return ConvertPixelsShuffleSSSE3(&conversion, source_pixel_buffer, nu_pixels, \
+			target_pixel_buffer); \
+	} \
+	static DETEX_TARGET_AVX2 int func##AVX2(const uint8_t *source_pixel_buffer, int nu_pixels, \
+	uint8_t *target_pixel_buffer) { \
+		return ConvertPixelsShuffleAVX2(&conversion, source_pixel_buffer, nu_pixels, \
+			target_pixel_buffer); \
+	} \
+	DETEX_DEFINE_KERNEL(func##Kernel, int, (const uint8_t *source_pixel_buffer, int nu_pixels, \
+		uint8_t *target_pixel_buffer), (source_pixel_buffer, nu_pixels, target_pixel_buffer)) \
+	static void func##SIMD(uint8_t * DETEX_RESTRICT source_pixel_buffer, int nu_pixels, \
+	uint8_t * DETEX_RESTRICT target_pixel_buffer) { \
+		uint8_t *target = target_pixel_buffer != NULL ? target_pixel_buffer : source_pixel_buffer; \
+		int i = DETEX_GET_KERNEL(func##Kernel)(source_pixel_buffer, nu_pixels, target); \
+		func(source_pixel_buffer + i * conversion.source_pixel_size, nu_pixels - i, \
+			target_pixel_buffer != NULL ? target_pixel_buffer + i * conversion.target_pixel_size : NULL); \
+	}
+
+// Without SSSE3, all pixels are converted by the scalar code.
+static int ConvertPixelsShuffleNone(const uint8_t *source_pixel_buffer, int nu_pixels,
+uint8_t *target_pixel_buffer) {
+	return 0;
+}
+
+// Select the kernel of a function defined with SHUFFLE_CONVERSION_FUNCTION.
+#define SELECT_SHUFFLE_KERNEL(func, level) \
+	DETEX_SET_KERNEL(func##Kernel, (level) >= DETEX_SIMD_LEVEL_AVX2 ? func##AVX2 : \
+		(level) >= DETEX_SIMD_LEVEL_SSSE3 ? func##SSSE3 : ConvertPixelsShuffleNone)
+
+#else
+
+#define SHUFFLE_CONVERSION_FUNCTION(func, conversion) \
+	static void func##SIMD(uint8_t * DETEX_RESTRICT source_pixel_buffer, int nu_pixels, \
+	uint8_t * DETEX_RESTRICT target_pixel_buffer) { \
+		(void)conversion; \
+		func(source_pixel_buffer, nu_pixels, target_pixel_buffer); \
+	}
+
+#define SELECT_SHUFFLE_KERNEL(func, level)
+
+#endif
+
+static const ShuffleConversion shuffle_conversion_rgba8_to_bgra8 = {
+	4, 4, 4, false,
+	{ 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32RGBA8ToPixel32BGRA8, shuffle_conversion_rgba8_to_bgra8)
+
+static const ShuffleConversion shuffle_conversion_rgbx16_to_bgrx16 = {
+	8, 8, 2, false,
+	{ 4, 5, 2, 3, 0, 1, 6, 7, 12, 13, 10, 11, 8, 9, 14, 15 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel64RGBX16ToPixel64BGRX16, shuffle_conversion_rgbx16_to_bgrx16)
+
+static const ShuffleConversion shuffle_conversion_rgb8_to_bgrx8 = {
+	3, 4, 4, false,
+	{ 2, 1, 0, 0x80, 5, 4, 3, 0x80, 8, 7, 6, 0x80, 11, 10, 9, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel24RGB8ToPixel32BGRX8, shuffle_conversion_rgb8_to_bgrx8)
+
+static const ShuffleConversion shuffle_conversion_r8_to_signed_r8 = {
+	1, 1, 16, false,
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel8R8ToPixel8SignedR8, shuffle_conversion_r8_to_signed_r8)
+
+static const ShuffleConversion shuffle_conversion_rg8_to_signed_rg8 = {
+	2, 2, 8, false,
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel16RG8ToPixel16SignedRG8, shuffle_conversion_rg8_to_signed_rg8)
+
+static const ShuffleConversion shuffle_conversion_signed_r8_to_r8 = {
+	1, 1, 16, false,
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel8SignedR8ToPixel8R8, shuffle_conversion_signed_r8_to_r8)
+
+static const ShuffleConversion shuffle_conversion_signed_rg8_to_rg8 = {
+	2, 2, 8, false,
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel16SignedRG8ToPixel16RG8, shuffle_conversion_signed_rg8_to_rg8)
+
+static const ShuffleConversion shuffle_conversion_r16_to_signed_r16 = {
+	2, 2, 8, false,
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel16R16ToPixel16SignedR16, shuffle_conversion_r16_to_signed_r16)
+
+static const ShuffleConversion shuffle_conversion_rg16_to_signed_rg16 = {
+	4, 4, 4, false,
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32RG16ToPixel32SignedRG16, shuffle_conversion_rg16_to_signed_rg16)
+
+static const ShuffleConversion shuffle_conversion_signed_r16_to_r16 = {
+	2, 2, 8, false,
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel16SignedR16ToPixel16R16, shuffle_conversion_signed_r16_to_r16)
+
+static const ShuffleConversion shuffle_conversion_signed_rg16_to_rg16 = {
+	4, 4, 4, false,
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32SignedRG16ToPixel32RG16, shuffle_conversion_signed_rg16_to_rg16)
+
+static const ShuffleConversion shuffle_conversion_rgba8_to_r8 = {
+	4, 1, 4, false,
+	{ 0, 4, 8, 12, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32RGBA8ToPixel8R8, shuffle_conversion_rgba8_to_r8)
+
+static const ShuffleConversion shuffle_conversion_rgba8_to_rg8 = {
+	4, 2, 4, false,
+	{ 0, 1, 4, 5, 8, 9, 12, 13, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32RGBA8ToPixel16RG8, shuffle_conversion_rgba8_to_rg8)
+
+static const ShuffleConversion shuffle_conversion_rgb8_to_r8 = {
+	3, 1, 4, false,
+	{ 0, 3, 6, 9, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel24RGB8ToPixel8R8, shuffle_conversion_rgb8_to_r8)
+
+static const ShuffleConversion shuffle_conversion_rgb8_to_rg8 = {
+	3, 2, 4, false,
+	{ 0, 1, 3, 4, 6, 7, 9, 10, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel24RGB8ToPixel16RG8, shuffle_conversion_rgb8_to_rg8)
+
+static const ShuffleConversion shuffle_conversion_r8_to_rgbx8 = {
+	1, 4, 4, false,
+	{ 0, 0x80, 0x80, 0x80, 1, 0x80, 0x80, 0x80, 2, 0x80, 0x80, 0x80, 3, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel8R8ToPixel32RGBX8, shuffle_conversion_r8_to_rgbx8)
+
+static const ShuffleConversion shuffle_conversion_rg8_to_rgbx8 = {
+	2, 4, 4, false,
+	{ 0, 1, 0x80, 0x80, 2, 3, 0x80, 0x80, 4, 5, 0x80, 0x80, 6, 7, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel16RG8ToPixel32RGBX8, shuffle_conversion_rg8_to_rgbx8)
+
+static const ShuffleConversion shuffle_conversion_r16_to_r8 = {
+	2, 1, 8, true,
+	{ 0, 2, 4, 6, 8, 10, 12, 14, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel16R16ToPixel8R8, shuffle_conversion_r16_to_r8)
+
+static const ShuffleConversion shuffle_conversion_rg16_to_rg8 = {
+	4, 2, 4, true,
+	{ 0, 2, 4, 6, 8, 10, 12, 14, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32RG16ToPixel16RG8, shuffle_conversion_rg16_to_rg8)
+
+static const ShuffleConversion shuffle_conversion_rgb16_to_rgb8 = {
+	6, 3, 2, true,
+	{ 0, 2, 4, 6, 8, 10, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel48RGB16ToPixel24RGB8, shuffle_conversion_rgb16_to_rgb8)
+
+static const ShuffleConversion shuffle_conversion_rgbx16_to_rgbx8 = {
+	8, 4, 2, true,
+	{ 0, 2, 4, 0x80, 8, 10, 12, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel64RGBX16ToPixel32RGBX8, shuffle_conversion_rgbx16_to_rgbx8)
+
+static const ShuffleConversion shuffle_conversion_rgba16_to_rgba8 = {
+	8, 4, 2, true,
+	{ 0, 2, 4, 6, 8, 10, 12, 14, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel64RGBA16ToPixel32RGBA8, shuffle_conversion_rgba16_to_rgba8)
+
+static const ShuffleConversion shuffle_conversion_r8_to_r16 = {
+	1, 2, 8, false,
+	{ 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel8R8ToPixel16R16, shuffle_conversion_r8_to_r16)
+
+static const ShuffleConversion shuffle_conversion_rg8_to_rg16 = {
+	2, 4, 4, false,
+	{ 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel16RG8ToPixel32RG16, shuffle_conversion_rg8_to_rg16)
+
+static const ShuffleConversion shuffle_conversion_rgb8_to_rgb16 = {
+	3, 6, 2, false,
+	{ 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel24RGB8ToPixel48RGB16, shuffle_conversion_rgb8_to_rgb16)
+
+static const ShuffleConversion shuffle_conversion_rgbx8_to_rgbx16 = {
+	4, 8, 2, false,
+	{ 0, 0, 1, 1, 2, 2, 0x80, 0x80, 4, 4, 5, 5, 6, 6, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32RGBX8ToPixel64RGBX16, shuffle_conversion_rgbx8_to_rgbx16)
+
+static const ShuffleConversion shuffle_conversion_rgba8_to_rgba16 = {
+	4, 8, 2, false,
+	{ 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32RGBA8ToPixel64RGBA16, shuffle_conversion_rgba8_to_rgba16)
+
+static const ShuffleConversion shuffle_conversion_rgb8_to_rgbx8 = {
+	3, 4, 4, false,
+	{ 0, 1, 2, 0x80, 3, 4, 5, 0x80, 6, 7, 8, 0x80, 9, 10, 11, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel24RGB8ToPixel32RGBX8, shuffle_conversion_rgb8_to_rgbx8)
+
+static const ShuffleConversion shuffle_conversion_rgbx8_to_rgb8 = {
+	4, 3, 4, false,
+	{ 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel32RGBX8ToPixel24RGB8, shuffle_conversion_rgbx8_to_rgb8)
+
+static const ShuffleConversion shuffle_conversion_rgb16_to_rgbx16 = {
+	6, 8, 2, false,
+	{ 0, 1, 2, 3, 4, 5, 0x80, 0x80, 6, 7, 8, 9, 10, 11, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3C }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel48RGB16ToPixel64RGBX16, shuffle_conversion_rgb16_to_rgbx16)
+
+static const ShuffleConversion shuffle_conversion_rgbx16_to_rgb16 = {
+	8, 6, 2, false,
+	{ 0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, 0x80, 0x80, 0x80, 0x80 }
+};
+SHUFFLE_CONVERSION_FUNCTION(ConvertPixel64RGBX16ToPixel48RGB16, shuffle_conversion_rgbx16_to_rgb16)
+
+
 typedef void (*detexConversionFunc)(uint8_t *source_pixel_buffer, int nu_pixels,
 	uint8_t *target_pixel_buffer);
 
@@ -770,44 +1133,44 @@ detexConversionType detex_conversion_table[] = {
 	{ DETEX_PIXEL_FORMAT_BGRX8, DETEX_PIXEL_FORMAT_BGRA8, ConvertNoop },
 	{ DETEX_PIXEL_FORMAT_BGRA8, DETEX_PIXEL_FORMAT_BGRX8, ConvertNoop },
 	// Swapping red and blue (in-place).
-	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_BGRX8, ConvertPixel32RGBA8ToPixel32BGRA8 },
-	{ DETEX_PIXEL_FORMAT_BGRX8, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel32RGBA8ToPixel32BGRA8 },
-	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_BGRA8, ConvertPixel32RGBA8ToPixel32BGRA8 },
-	{ DETEX_PIXEL_FORMAT_BGRA8, DETEX_PIXEL_FORMAT_RGBA8, ConvertPixel32RGBA8ToPixel32BGRA8 },
-	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_FLOAT_BGRX16, ConvertPixel64RGBX16ToPixel64BGRX16 },
-	{ DETEX_PIXEL_FORMAT_FLOAT_BGRX16, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, ConvertPixel64RGBX16ToPixel64BGRX16 },
+	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_BGRX8, ConvertPixel32RGBA8ToPixel32BGRA8SIMD },
+	{ DETEX_PIXEL_FORMAT_BGRX8, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel32RGBA8ToPixel32BGRA8SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_BGRA8, ConvertPixel32RGBA8ToPixel32BGRA8SIMD },
+	{ DETEX_PIXEL_FORMAT_BGRA8, DETEX_PIXEL_FORMAT_RGBA8, ConvertPixel32RGBA8ToPixel32BGRA8SIMD },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_FLOAT_BGRX16, ConvertPixel64RGBX16ToPixel64BGRX16SIMD },
+	{ DETEX_PIXEL_FORMAT_FLOAT_BGRX16, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, ConvertPixel64RGBX16ToPixel64BGRX16SIMD },
 	// Swapping red and blue (not in-place)
-	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_BGRX8, ConvertPixel24RGB8ToPixel32BGRX8 },
+	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_BGRX8, ConvertPixel24RGB8ToPixel32BGRX8SIMD },
 	// Signed integer conversions (in-place).
 	// 11
-	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_SIGNED_R8, ConvertPixel8R8ToPixel8SignedR8 },
-	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_SIGNED_RG8, ConvertPixel16RG8ToPixel16SignedRG8 },
-	{ DETEX_PIXEL_FORMAT_SIGNED_R8, DETEX_PIXEL_FORMAT_R8, ConvertPixel8SignedR8ToPixel8R8 },
-	{ DETEX_PIXEL_FORMAT_SIGNED_RG8, DETEX_PIXEL_FORMAT_RG8, ConvertPixel16SignedRG8ToPixel16RG8 },
-	{ DETEX_PIXEL_FORMAT_R16, DETEX_PIXEL_FORMAT_SIGNED_R16, ConvertPixel16R16ToPixel16SignedR16 },
-	{ DETEX_PIXEL_FORMAT_RG16, DETEX_PIXEL_FORMAT_SIGNED_RG16, ConvertPixel32RG16ToPixel32SignedRG16 },
-	{ DETEX_PIXEL_FORMAT_SIGNED_R16, DETEX_PIXEL_FORMAT_R16, ConvertPixel16SignedR16ToPixel16R16 },
-	{ DETEX_PIXEL_FORMAT_SIGNED_RG16, DETEX_PIXEL_FORMAT_RG16, ConvertPixel32SignedRG16ToPixel32RG16 },
+	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_SIGNED_R8, ConvertPixel8R8ToPixel8SignedR8SIMD },
+	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_SIGNED_RG8, ConvertPixel16RG8ToPixel16SignedRG8SIMD },
+	{ DETEX_PIXEL_FORMAT_SIGNED_R8, DETEX_PIXEL_FORMAT_R8, ConvertPixel8SignedR8ToPixel8R8SIMD },
+	{ DETEX_PIXEL_FORMAT_SIGNED_RG8, DETEX_PIXEL_FORMAT_RG8, ConvertPixel16SignedRG8ToPixel16RG8SIMD },
+	{ DETEX_PIXEL_FORMAT_R16, DETEX_PIXEL_FORMAT_SIGNED_R16, ConvertPixel16R16ToPixel16SignedR16SIMD },
+	{ DETEX_PIXEL_FORMAT_RG16, DETEX_PIXEL_FORMAT_SIGNED_RG16, ConvertPixel32RG16ToPixel32SignedRG16SIMD },
+	{ DETEX_PIXEL_FORMAT_SIGNED_R16, DETEX_PIXEL_FORMAT_R16, ConvertPixel16SignedR16ToPixel16R16SIMD },
+	{ DETEX_PIXEL_FORMAT_SIGNED_RG16, DETEX_PIXEL_FORMAT_RG16, ConvertPixel32SignedRG16ToPixel32RG16SIMD },
 	// Reducing the number of components.
-	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_R8, ConvertPixel32RGBA8ToPixel8R8 },
-	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_RG8, ConvertPixel32RGBA8ToPixel16RG8 },
-	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_R8, ConvertPixel24RGB8ToPixel8R8 },
-	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_RG8, ConvertPixel24RGB8ToPixel16RG8 },
+	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_R8, ConvertPixel32RGBA8ToPixel8R8SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_RG8, ConvertPixel32RGBA8ToPixel16RG8SIMD },
+	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_R8, ConvertPixel24RGB8ToPixel8R8SIMD },
+	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_RG8, ConvertPixel24RGB8ToPixel16RG8SIMD },
 	// Increasing the number of components.
 	// 23
-	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel8R8ToPixel32RGBX8 },
-	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel16RG8ToPixel32RGBX8 },
+	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel8R8ToPixel32RGBX8SIMD },
+	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel16RG8ToPixel32RGBX8SIMD },
 	// Conversion to component of different size.
-	{ DETEX_PIXEL_FORMAT_R16, DETEX_PIXEL_FORMAT_R8, ConvertPixel16R16ToPixel8R8 },
-	{ DETEX_PIXEL_FORMAT_RG16, DETEX_PIXEL_FORMAT_RG8, ConvertPixel32RG16ToPixel16RG8 },
-	{ DETEX_PIXEL_FORMAT_RGB16, DETEX_PIXEL_FORMAT_RGB8, ConvertPixel48RGB16ToPixel24RGB8 },
-	{ DETEX_PIXEL_FORMAT_RGBX16, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel64RGBX16ToPixel32RGBX8 },
-	{ DETEX_PIXEL_FORMAT_RGBA16, DETEX_PIXEL_FORMAT_RGBA8, ConvertPixel64RGBA16ToPixel32RGBA8 },
-	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_R16, ConvertPixel8R8ToPixel16R16 },
-	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_RG16, ConvertPixel16RG8ToPixel32RG16 },
-	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_RGB16, ConvertPixel24RGB8ToPixel48RGB16 },
-	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_RGBX16, ConvertPixel32RGBX8ToPixel64RGBX16 },
-	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_RGBA16, ConvertPixel32RGBA8ToPixel64RGBA16 },
+	{ DETEX_PIXEL_FORMAT_R16, DETEX_PIXEL_FORMAT_R8, ConvertPixel16R16ToPixel8R8SIMD },
+	{ DETEX_PIXEL_FORMAT_RG16, DETEX_PIXEL_FORMAT_RG8, ConvertPixel32RG16ToPixel16RG8SIMD },
+	{ DETEX_PIXEL_FORMAT_RGB16, DETEX_PIXEL_FORMAT_RGB8, ConvertPixel48RGB16ToPixel24RGB8SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBX16, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel64RGBX16ToPixel32RGBX8SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBA16, DETEX_PIXEL_FORMAT_RGBA8, ConvertPixel64RGBA16ToPixel32RGBA8SIMD },
+	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_R16, ConvertPixel8R8ToPixel16R16SIMD },
+	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_RG16, ConvertPixel16RG8ToPixel32RG16SIMD },
+	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_RGB16, ConvertPixel24RGB8ToPixel48RGB16SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_RGBX16, ConvertPixel32RGBX8ToPixel64RGBX16SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_RGBA16, ConvertPixel32RGBA8ToPixel64RGBA16SIMD },
 	// Integer to half-float conversion (in-place).
 	// 35
 	{ DETEX_PIXEL_FORMAT_R16, DETEX_PIXEL_FORMAT_FLOAT_R16, ConvertPixel16R16ToPixel16FloatR16 },
@@ -849,13 +1212,13 @@ detexConversionType detex_conversion_table[] = {
 		ConvertPixel128FloatRGBX32HDRToPixel128FloatRGBX32 },
 	// Conversion between packed RGB8 and RGBX8.
 	// 62
-	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel24RGB8ToPixel32RGBX8 },
-	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_RGB8, ConvertPixel32RGBX8ToPixel24RGB8 },
+	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_RGBX8, ConvertPixel24RGB8ToPixel32RGBX8SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_RGB8, ConvertPixel32RGBX8ToPixel24RGB8SIMD },
 	// Conversion between packed half-float RGB16 and half-float RGBX16.
-	{ DETEX_PIXEL_FORMAT_FLOAT_RGB16, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, ConvertPixel48RGB16ToPixel64RGBX16 },
-	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_FLOAT_RGB16, ConvertPixel64RGBX16ToPixel48RGB16 },
-	{ DETEX_PIXEL_FORMAT_FLOAT_RGB16_HDR, DETEX_PIXEL_FORMAT_FLOAT_RGBX16_HDR, ConvertPixel48RGB16ToPixel64RGBX16 },
-	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16_HDR, DETEX_PIXEL_FORMAT_FLOAT_RGB16_HDR, ConvertPixel64RGBX16ToPixel48RGB16 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGB16, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, ConvertPixel48RGB16ToPixel64RGBX16SIMD },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_FLOAT_RGB16, ConvertPixel64RGBX16ToPixel48RGB16SIMD },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGB16_HDR, DETEX_PIXEL_FORMAT_FLOAT_RGBX16_HDR, ConvertPixel48RGB16ToPixel64RGBX16SIMD },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16_HDR, DETEX_PIXEL_FORMAT_FLOAT_RGB16_HDR, ConvertPixel64RGBX16ToPixel48RGB16SIMD },
 	// Conversion between packed float RGB32 and float RGBX32.
 	{ DETEX_PIXEL_FORMAT_FLOAT_RGB32, DETEX_PIXEL_FORMAT_FLOAT_RGBX32, ConvertPixel96RGB32ToPixel128RGBX32 },
 	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX32, DETEX_PIXEL_FORMAT_FLOAT_RGB32, ConvertPixel128RGBX32ToPixel96RGB32 },
@@ -865,47 +1228,637 @@ detexConversionType detex_conversion_table[] = {
 
 #define NU_CONVERSION_TYPES (sizeof(detex_conversion_table) / sizeof(detex_conversion_table[0]))
 
-// #define TRACE_MATCH_CONVERSION
+// Fused conversions. These perform a multi-step conversion chain from the table above in a
+// single pass over the pixels, producing results identical to the chain. Conversions
+// between 8-bit and 16-bit integer formats use the SIMD byte shuffles above, with the
+// scalar functions below converting the remaining pixels (the signed 16-bit sources, which
+// are offset before they are narrowed, are only converted by the scalar functions).
+// Conversions between 8-bit components and half-float or float formats are performed
+// with the SSE2 functions further below.
+
+enum {
+	FUSED_SOURCE_R8,
+	FUSED_SOURCE_RG8,
+	FUSED_SOURCE_RGB8,
+	FUSED_SOURCE_SIGNED_R8,
+	FUSED_SOURCE_SIGNED_RG8,
+	FUSED_SOURCE_R16,
+	FUSED_SOURCE_RG16,
+	FUSED_SOURCE_SIGNED_R16,
+	FUSED_SOURCE_SIGNED_RG16
+};
+
+// Convert a 16-bit component to 8 bits as the 16-bit to 8-bit conversion functions do.
+static DETEX_INLINE_ONLY uint32_t Convert16To8(uint32_t v) {
+	return (v + 127) * 255 / 65535;
+}
+
+// Fetch the red, green and blue components of pixel i of a source format, converted to 8 bits.
+static DETEX_INLINE_ONLY void FetchRGB8(const uint8_t * DETEX_RESTRICT source_pixel_buffer, int i,
+int source_type, uint32_t *red, uint32_t *green, uint32_t *blue) {
+	const uint16_t *source_pixel16_buffer = (const uint16_t *)source_pixel_buffer;
+	const int8_t *source_signed_pixel8_buffer = (const int8_t *)source_pixel_buffer;
+	const int16_t *source_signed_pixel16_buffer = (const int16_t *)source_pixel_buffer;
+	*green = 0;
+	*blue = 0;
+	switch (source_type) {
+	case FUSED_SOURCE_R8 :
+		*red = source_pixel_buffer[i];
+		break;
+	case FUSED_SOURCE_RG8 :
+		*red = source_pixel_buffer[i * 2];
+		*green = source_pixel_buffer[i * 2 + 1];
+		break;
+	case FUSED_SOURCE_RGB8 :
+		*red = source_pixel_buffer[i * 3];
+		*green = source_pixel_buffer[i * 3 + 1];
+		*blue = source_pixel_buffer[i * 3 + 2];
+		break;
+	case FUSED_SOURCE_SIGNED_R8 :
+		*red = (uint8_t)(source_signed_pixel8_buffer[i] + 128);
+		break;
+	case FUSED_SOURCE_SIGNED_RG8 :
+		*red = (uint8_t)(source_signed_pixel8_buffer[i * 2] + 128);
+		*green = (uint8_t)(source_signed_pixel8_buffer[i * 2 + 1] + 128);
+		break;
+	case FUSED_SOURCE_R16 :
+		*red = Convert16To8(source_pixel16_buffer[i]);
+		break;
+	case FUSED_SOURCE_RG16 :
+		*red = Convert16To8(source_pixel16_buffer[i * 2]);
+		*green = Convert16To8(source_pixel16_buffer[i * 2 + 1]);
+		break;
+	case FUSED_SOURCE_SIGNED_R16 :
+		*red = Convert16To8((uint16_t)(source_signed_pixel16_buffer[i] + 32768));
+		break;
+	case FUSED_SOURCE_SIGNED_RG16 :
+		*red = Convert16To8((uint16_t)(source_signed_pixel16_buffer[i * 2] + 32768));
+		*green = Convert16To8((uint16_t)(source_signed_pixel16_buffer[i * 2 + 1] + 32768));
+		break;
+	}
+}
 
-static __thread uint32_t cached_source_format = -1;
-static __thread uint32_t cached_target_format = -1;
-static __thread int cached_nu_conversions = - 1;
-static __thread uint32_t cached_conversion[4];
+static DETEX_INLINE_ONLY void FusedConvertToRGBX8(const uint8_t * DETEX_RESTRICT source_pixel_buffer,
+int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer, int source_type, bool swap_red_blue) {
+	uint32_t *target_pixel32_buffer = (uint32_t *)target_pixel_buffer;
+	for (int i = 0; i < nu_pixels; i++) {
+		uint32_t red, green, blue;
+		FetchRGB8(source_pixel_buffer, i, source_type, &red, &green, &blue);
+		if (swap_red_blue)
+			target_pixel32_buffer[i] = detexPack32RGB8Alpha0xFF(blue, green, red);
+		else
+			target_pixel32_buffer[i] = detexPack32RGB8Alpha0xFF(red, green, blue);
+	}
+}
 
-static void CacheResult(uint32_t source_format, uint32_t target_format, int n, uint32_t *conversion) {
-	cached_source_format = source_format;
-	cached_target_format = target_format;
-	cached_nu_conversions = n;
-//	printf("Caching conversion ( ");
-	for (int i = 0; i < n; i++) {
-		cached_conversion[i] = conversion[i];
-//		printf("%d ", conversion[i]);
+static DETEX_INLINE_ONLY void FusedConvertToRGBX16(const uint8_t * DETEX_RESTRICT source_pixel_buffer,
+int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer, int source_type) {
+	uint64_t *target_pixel64_buffer = (uint64_t *)target_pixel_buffer;
+	for (int i = 0; i < nu_pixels; i++) {
+		uint32_t red, green, blue;
+		FetchRGB8(source_pixel_buffer, i, source_type, &red, &green, &blue);
+		// Multiplying an 8-bit component by 257 is identical to multiplying by 65535 / 255.
+		target_pixel64_buffer[i] = detexPack64RGBA16(red * 257, green * 257, blue * 257, 0xFFFF);
 	}
-//	printf(")\n");
 }
 
-// Match conversion. Returns number of conversion steps, -1 if not succesful.
-static int detexMatchConversion(uint32_t source_pixel_format, uint32_t target_pixel_format,
-uint32_t *conversion) {
-	// Immediately return if the formats are identical.
-	if (source_pixel_format == target_pixel_format)
-		return 0;
+#define FUSED_CONVERSIONS_TO_8(source) \
+	static void FusedConvert##source##ToRGBX8(uint8_t * DETEX_RESTRICT source_pixel_buffer, \
+	int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) { \
+		FusedConvertToRGBX8(source_pixel_buffer, nu_pixels, target_pixel_buffer, \
+			FUSED_SOURCE_##source, false); \
+	} \
+	static void FusedConvert##source##ToBGRX8(uint8_t * DETEX_RESTRICT source_pixel_buffer, \
+	int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) { \
+		FusedConvertToRGBX8(source_pixel_buffer, nu_pixels, target_pixel_buffer, \
+			FUSED_SOURCE_##source, true); \
+	}
+
+#define FUSED_CONVERSION_TO_16(source) \
+	static void FusedConvert##source##ToRGBX16(uint8_t * DETEX_RESTRICT source_pixel_buffer, \
+	int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer) { \
+		FusedConvertToRGBX16(source_pixel_buffer, nu_pixels, target_pixel_buffer, \
+			FUSED_SOURCE_##source); \
+	}
+
+FUSED_CONVERSIONS_TO_8(R8)
+FUSED_CONVERSIONS_TO_8(RG8)
+FUSED_CONVERSIONS_TO_8(SIGNED_R8)
+FUSED_CONVERSIONS_TO_8(SIGNED_RG8)
+FUSED_CONVERSIONS_TO_8(R16)
+FUSED_CONVERSIONS_TO_8(RG16)
+FUSED_CONVERSIONS_TO_8(SIGNED_R16)
+FUSED_CONVERSIONS_TO_8(SIGNED_RG16)
+FUSED_CONVERSION_TO_16(R8)
+FUSED_CONVERSION_TO_16(RG8)
+FUSED_CONVERSION_TO_16(RGB8)
+
+// Swap red and blue while copying, preserving alpha.
+static void FusedConvertSwapRedBlue32(uint8_t * DETEX_RESTRICT source_pixel_buffer, int nu_pixels,
+uint8_t * DETEX_RESTRICT target_pixel_buffer) {
+	const uint32_t *source_pixel32_buffer = (const uint32_t *)source_pixel_buffer;
+	uint32_t *target_pixel32_buffer = (uint32_t *)target_pixel_buffer;
+	for (int i = 0; i < nu_pixels; i++) {
+		uint32_t pixel = source_pixel32_buffer[i];
+		target_pixel32_buffer[i] = (pixel & 0xFF00FF00) | ((pixel & 0xFF) << 16) |
+			((pixel >> 16) & 0xFF);
+	}
+}
+
+// Byte shuffles for the fused conversions. The conversions to RGBX8 from R8 and RG8 are
+// the same as the elementary ones.
+
+static const ShuffleConversion shuffle_conversion_r8_to_bgrx8 = {
+	1, 4, 4, false,
+	{ 0x80, 0x80, 0, 0x80, 0x80, 0x80, 1, 0x80, 0x80, 0x80, 2, 0x80, 0x80, 0x80, 3, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+
+static const ShuffleConversion shuffle_conversion_rg8_to_bgrx8 = {
+	2, 4, 4, false,
+	{ 0x80, 1, 0, 0x80, 0x80, 3, 2, 0x80, 0x80, 5, 4, 0x80, 0x80, 7, 6, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+
+static const ShuffleConversion shuffle_conversion_signed_r8_to_rgbx8 = {
+	1, 4, 4, false,
+	{ 0, 0x80, 0x80, 0x80, 1, 0x80, 0x80, 0x80, 2, 0x80, 0x80, 0x80, 3, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF },
+	{ 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00 }
+};
+
+static const ShuffleConversion shuffle_conversion_signed_r8_to_bgrx8 = {
+	1, 4, 4, false,
+	{ 0x80, 0x80, 0, 0x80, 0x80, 0x80, 1, 0x80, 0x80, 0x80, 2, 0x80, 0x80, 0x80, 3, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF },
+	{ 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00 }
+};
+
+static const ShuffleConversion shuffle_conversion_signed_rg8_to_rgbx8 = {
+	2, 4, 4, false,
+	{ 0, 1, 0x80, 0x80, 2, 3, 0x80, 0x80, 4, 5, 0x80, 0x80, 6, 7, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF },
+	{ 0x80, 0x80, 0x00, 0x00, 0x80, 0x80, 0x00, 0x00, 0x80, 0x80, 0x00, 0x00, 0x80, 0x80, 0x00, 0x00 }
+};
+
+static const ShuffleConversion shuffle_conversion_signed_rg8_to_bgrx8 = {
+	2, 4, 4, false,
+	{ 0x80, 1, 0, 0x80, 0x80, 3, 2, 0x80, 0x80, 5, 4, 0x80, 0x80, 7, 6, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF },
+	{ 0x00, 0x80, 0x80, 0x00, 0x00, 0x80, 0x80, 0x00, 0x00, 0x80, 0x80, 0x00, 0x00, 0x80, 0x80, 0x00 }
+};
+
+static const ShuffleConversion shuffle_conversion_r16_to_rgbx8 = {
+	2, 4, 4, true,
+	{ 0, 0x80, 0x80, 0x80, 2, 0x80, 0x80, 0x80, 4, 0x80, 0x80, 0x80, 6, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+
+static const ShuffleConversion shuffle_conversion_r16_to_bgrx8 = {
+	2, 4, 4, true,
+	{ 0x80, 0x80, 0, 0x80, 0x80, 0x80, 2, 0x80, 0x80, 0x80, 4, 0x80, 0x80, 0x80, 6, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+
+static const ShuffleConversion shuffle_conversion_rg16_to_rgbx8 = {
+	4, 4, 4, true,
+	{ 0, 2, 0x80, 0x80, 4, 6, 0x80, 0x80, 8, 10, 0x80, 0x80, 12, 14, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+
+static const ShuffleConversion shuffle_conversion_rg16_to_bgrx8 = {
+	4, 4, 4, true,
+	{ 0x80, 2, 0, 0x80, 0x80, 6, 4, 0x80, 0x80, 10, 8, 0x80, 0x80, 14, 12, 0x80 },
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF }
+};
+
+static const ShuffleConversion shuffle_conversion_r8_to_rgbx16 = {
+	1, 8, 2, false,
+	{ 0, 0, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 1, 1, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF }
+};
+
+static const ShuffleConversion shuffle_conversion_rg8_to_rgbx16 = {
+	2, 8, 2, false,
+	{ 0, 0, 1, 1, 0x80, 0x80, 0x80, 0x80, 2, 2, 3, 3, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF }
+};
+
+static const ShuffleConversion shuffle_conversion_rgb8_to_rgbx16 = {
+	3, 8, 2, false,
+	{ 0, 0, 1, 1, 2, 2, 0x80, 0x80, 3, 3, 4, 4, 5, 5, 0x80, 0x80 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF }
+};
+
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertR8ToRGBX8, shuffle_conversion_r8_to_rgbx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertR8ToBGRX8, shuffle_conversion_r8_to_bgrx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertRG8ToRGBX8, shuffle_conversion_rg8_to_rgbx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertRG8ToBGRX8, shuffle_conversion_rg8_to_bgrx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertSIGNED_R8ToRGBX8, shuffle_conversion_signed_r8_to_rgbx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertSIGNED_R8ToBGRX8, shuffle_conversion_signed_r8_to_bgrx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertSIGNED_RG8ToRGBX8, shuffle_conversion_signed_rg8_to_rgbx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertSIGNED_RG8ToBGRX8, shuffle_conversion_signed_rg8_to_bgrx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertR16ToRGBX8, shuffle_conversion_r16_to_rgbx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertR16ToBGRX8, shuffle_conversion_r16_to_bgrx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertRG16ToRGBX8, shuffle_conversion_rg16_to_rgbx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertRG16ToBGRX8, shuffle_conversion_rg16_to_bgrx8)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertR8ToRGBX16, shuffle_conversion_r8_to_rgbx16)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertRG8ToRGBX16, shuffle_conversion_rg8_to_rgbx16)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertRGB8ToRGBX16, shuffle_conversion_rgb8_to_rgbx16)
+SHUFFLE_CONVERSION_FUNCTION(FusedConvertSwapRedBlue32, shuffle_conversion_rgba8_to_bgra8)
+
+// Fused conversions between 8-bit components and half-float or float formats. The pixels
+// are converted in chunks that stay in the cache: 8-bit components are converted to
+// normalized floats (or vice versa) with SSE2, and the conversion to or from half-floats
+// uses the SIMD half-float conversion functions. Optional 8-bit conversion steps that
+// change the number of components or swap red and blue are performed on the chunk with
+// the functions from the conversion table.
+
+#define FUSED_CHUNK_SIZE 64
+
+enum {
+	// 16-bit components are interpreted as signed, as ConvertPixel64RGBX16ToPixel64FloatRGBX16
+	// does.
+	FUSED_FLOAT_SIGNED_16 = 0x1,
+	// Every fourth component is set to 1.0f (or 0xFF when converting to 8 bits).
+	FUSED_FLOAT_ALPHA_ONE = 0x2
+};
+
+#ifdef DETEX_USE_SSE2
+
+// Convert 8-bit components to normalized floats as the 8-bit to 16-bit and 16-bit to
+// half-float conversions do, returning the number of components converted. The number
+// of components converted at a time is a multiple of four, so the alpha components are
+// in the last lane.
+static int ConvertUInt8ToNormalizedFloatSSE2(const uint8_t * DETEX_RESTRICT source_buffer, int n,
+float * DETEX_RESTRICT target_buffer, int flags) {
+	__m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(- 1, 0, 0, 0));
+	int i;
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)&source_buffer[i]);
+		// Interleaving the bytes with themselves multiplies them by 257.
+		__m128i v16[2] = { _mm_unpacklo_epi8(v, v), _mm_unpackhi_epi8(v, v) };
+		for (int j = 0; j < 4; j++) {
+			__m128i w = v16[j >> 1];
+			__m128i x;
+			if (flags & FUSED_FLOAT_SIGNED_16)
+				x = _mm_srai_epi32((j & 1) ? _mm_unpackhi_epi16(w, w) : _mm_unpacklo_epi16(w, w), 16);
+			else
+				x = (j & 1) ? _mm_unpackhi_epi16(w, _mm_setzero_si128()) :
+					_mm_unpacklo_epi16(w, _mm_setzero_si128());
+			__m128 f = _mm_mul_ps(_mm_cvtepi32_ps(x), _mm_set1_ps(1.0f / 65535.0f));
+			if (flags & FUSED_FLOAT_ALPHA_ONE)
+				f = _mm_or_ps(_mm_andnot_ps(alpha_mask, f), _mm_and_ps(alpha_mask, _mm_set1_ps(1.0f)));
+			_mm_storeu_ps(&target_buffer[i + j * 4], f);
+		}
+	}
+	return i;
+}
+
+// Convert normalized floats to 8-bit components as detexConvertNormalizedFloatToUInt16
+// followed by the 16-bit to 8-bit conversion does. The rounding mode must be set to
+// FE_DOWNWARD.
+static int ConvertNormalizedFloatToUInt8SSE2(const float * DETEX_RESTRICT source_buffer, int n,
+uint8_t * DETEX_RESTRICT target_buffer, int flags) {
+	int i;
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i u[4];
+		for (int j = 0; j < 4; j++) {
+			__m128 f = _mm_loadu_ps(&source_buffer[i + j * 4]);
+			// Clamp as detexClamp0To1 does; the operand order passes NaNs through.
+			f = _mm_min_ps(_mm_set1_ps(1.0f), _mm_max_ps(_mm_setzero_ps(), f));
+			u[j] = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(65535.0f)),
+				_mm_set1_ps(0.5f)));
+			// Keep the low 16 bits, as the conversion to uint16_t does.
+			u[j] = _mm_srai_epi32(_mm_slli_epi32(u[j], 16), 16);
+		}
+		__m128i v16[2];
+		for (int j = 0; j < 2; j++) {
+			__m128i v = _mm_packs_epi32(u[j * 2], u[j * 2 + 1]);
+			// Convert to 8 bits as ApplyShuffleConversionSSSE3 does.
+			v16[j] = _mm_srli_epi16(_mm_mulhi_epu16(_mm_adds_epu16(v, _mm_set1_epi16(127)),
+				_mm_set1_epi16((short)0xFF01)), 8);
+		}
+		__m128i v = _mm_packus_epi16(v16[0], v16[1]);
+		if (flags & FUSED_FLOAT_ALPHA_ONE)
+			v = _mm_or_si128(v, _mm_set1_epi32(0xFF000000));
+		_mm_storeu_si128((__m128i *)&target_buffer[i], v);
+	}
+	return i;
+}
+
+#endif
+
+// Without SSE2, all components are converted by the scalar code.
+static int ConvertUInt8ToNormalizedFloatNone(const uint8_t * DETEX_RESTRICT source_buffer, int n,
+float * DETEX_RESTRICT target_buffer, int flags) {
+	return 0;
+}
+
+static int ConvertNormalizedFloatToUInt8None(const float * DETEX_RESTRICT source_buffer, int n,
+uint8_t * DETEX_RESTRICT target_buffer, int flags) {
+	return 0;
+}
+
+DETEX_DEFINE_KERNEL(ConvertUInt8ToNormalizedFloatKernel, int, (const uint8_t * DETEX_RESTRICT
+	source_buffer, int n, float * DETEX_RESTRICT target_buffer, int flags),
+	(source_buffer, n, target_buffer, flags))
+DETEX_DEFINE_KERNEL(ConvertNormalizedFloatToUInt8Kernel, int, (const float * DETEX_RESTRICT
+	source_buffer, int n, uint8_t * DETEX_RESTRICT target_buffer, int flags),
+	(source_buffer, n, target_buffer, flags))
+
+void detexSelectConversionKernels(int level) {
+	// Every function defined with SHUFFLE_CONVERSION_FUNCTION must be listed here; the
+	// SIMD functions of a missing one are reported as unused.
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32RGBA8ToPixel32BGRA8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel64RGBX16ToPixel64BGRX16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel24RGB8ToPixel32BGRX8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel8R8ToPixel8SignedR8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel16RG8ToPixel16SignedRG8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel8SignedR8ToPixel8R8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel16SignedRG8ToPixel16RG8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel16R16ToPixel16SignedR16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32RG16ToPixel32SignedRG16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel16SignedR16ToPixel16R16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32SignedRG16ToPixel32RG16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32RGBA8ToPixel8R8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32RGBA8ToPixel16RG8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel24RGB8ToPixel8R8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel24RGB8ToPixel16RG8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel8R8ToPixel32RGBX8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel16RG8ToPixel32RGBX8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel16R16ToPixel8R8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32RG16ToPixel16RG8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel48RGB16ToPixel24RGB8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel64RGBX16ToPixel32RGBX8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel64RGBA16ToPixel32RGBA8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel8R8ToPixel16R16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel16RG8ToPixel32RG16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel24RGB8ToPixel48RGB16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32RGBX8ToPixel64RGBX16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32RGBA8ToPixel64RGBA16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel24RGB8ToPixel32RGBX8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel32RGBX8ToPixel24RGB8, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel48RGB16ToPixel64RGBX16, level);
+	SELECT_SHUFFLE_KERNEL(ConvertPixel64RGBX16ToPixel48RGB16, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertR8ToRGBX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertR8ToBGRX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertRG8ToRGBX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertRG8ToBGRX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertSIGNED_R8ToRGBX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertSIGNED_R8ToBGRX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertSIGNED_RG8ToRGBX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertSIGNED_RG8ToBGRX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertR16ToRGBX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertR16ToBGRX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertRG16ToRGBX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertRG16ToBGRX8, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertR8ToRGBX16, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertRG8ToRGBX16, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertRGB8ToRGBX16, level);
+	SELECT_SHUFFLE_KERNEL(FusedConvertSwapRedBlue32, level);
+	int (*to_float_kernel)(const uint8_t * DETEX_RESTRICT, int, float * DETEX_RESTRICT, int) =
+		ConvertUInt8ToNormalizedFloatNone;
+	int (*to_uint8_kernel)(const float * DETEX_RESTRICT, int, uint8_t * DETEX_RESTRICT, int) =
+		ConvertNormalizedFloatToUInt8None;
+#ifdef DETEX_USE_SSE2
+	if (level >= DETEX_SIMD_LEVEL_SSE2) {
+		to_float_kernel = ConvertUInt8ToNormalizedFloatSSE2;
+		to_uint8_kernel = ConvertNormalizedFloatToUInt8SSE2;
+	}
+#endif
+	DETEX_SET_KERNEL(ConvertUInt8ToNormalizedFloatKernel, to_float_kernel);
+	DETEX_SET_KERNEL(ConvertNormalizedFloatToUInt8Kernel, to_uint8_kernel);
+}
+
+static void ConvertUInt8ToNormalizedFloat(const uint8_t * DETEX_RESTRICT source_buffer, int n,
+float * DETEX_RESTRICT target_buffer, int flags) {
+	int i = DETEX_GET_KERNEL(ConvertUInt8ToNormalizedFloatKernel)(source_buffer, n, target_buffer,
+		flags);
+	for (; i < n; i++) {
+		uint32_t v = source_buffer[i] * 257;
+		int x = (flags & FUSED_FLOAT_SIGNED_16) ? (int16_t)v : (int)v;
+		target_buffer[i] = x * (1.0f / 65535.0f);
+		if ((flags & FUSED_FLOAT_ALPHA_ONE) && (i & 3) == 3)
+			target_buffer[i] = 1.0f;
+	}
+}
+
+static void ConvertNormalizedFloatToUInt8(const float * DETEX_RESTRICT source_buffer, int n,
+uint8_t * DETEX_RESTRICT target_buffer, int flags) {
+	int i = DETEX_GET_KERNEL(ConvertNormalizedFloatToUInt8Kernel)(source_buffer, n, target_buffer,
+		flags);
+	for (; i < n; i++) {
+		uint16_t u = (uint16_t)lrintf(detexClamp0To1(source_buffer[i]) * 65535.0f + 0.5f);
+		target_buffer[i] = Convert16To8(u);
+		if ((flags & FUSED_FLOAT_ALPHA_ONE) && (i & 3) == 3)
+			target_buffer[i] = 0xFF;
+	}
+}
+
+// Convert 8-bit pixels with source_pixel_size bytes, optionally expanded to nu_components
+// components with expand_func, to half-floats, or to floats when float_target is set.
+static DETEX_INLINE_ONLY void FusedConvertUInt8ToHalfFloat(uint8_t * DETEX_RESTRICT source_pixel_buffer,
+int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer, int source_pixel_size,
+detexConversionFunc expand_func, int nu_components, int flags, bool float_target) {
+	uint8_t byte_buffer[FUSED_CHUNK_SIZE * 4];
+	float float_buffer[FUSED_CHUNK_SIZE * 4];
+	uint16_t half_float_buffer[FUSED_CHUNK_SIZE * 4];
+	for (int i = 0; i < nu_pixels; i += FUSED_CHUNK_SIZE) {
+		int n = nu_pixels - i < FUSED_CHUNK_SIZE ? nu_pixels - i : FUSED_CHUNK_SIZE;
+		uint8_t *source = source_pixel_buffer + i * source_pixel_size;
+		if (expand_func != NULL) {
+			expand_func(source, n, byte_buffer);
+			source = byte_buffer;
+		}
+		ConvertUInt8ToNormalizedFloat(source, n * nu_components, float_buffer, flags);
+		if (float_target) {
+			detexConvertFloatToHalfFloat(float_buffer, n * nu_components, half_float_buffer);
+			detexConvertHalfFloatToFloat(half_float_buffer, n * nu_components,
+				(float *)(target_pixel_buffer + i * nu_components * 4));
+		}
+		else
+			detexConvertFloatToHalfFloat(float_buffer, n * nu_components,
+				(uint16_t *)(target_pixel_buffer + i * nu_components * 2));
+	}
+}
+
+// Convert pixels with nu_components float components, or half-float components when
+// half_float_source is set, to 8-bit components. The 8-bit pixels are then converted to
+// the target format with target_pixel_size bytes by post_func, if set; post_func is
+// applied in-place when the pixel size does not change.
+static DETEX_INLINE_ONLY void FusedConvertFloatToUInt8(uint8_t * DETEX_RESTRICT source_pixel_buffer,
+int nu_pixels, uint8_t * DETEX_RESTRICT target_pixel_buffer, bool half_float_source,
+int nu_components, int flags, detexConversionFunc post_func, int target_pixel_size) {
+	uint8_t byte_buffer[FUSED_CHUNK_SIZE * 4];
+	float float_buffer[FUSED_CHUNK_SIZE * 4];
+	int source_pixel_size = nu_components * (half_float_source ? 2 : 4);
+	fesetround(FE_DOWNWARD);
+	for (int i = 0; i < nu_pixels; i += FUSED_CHUNK_SIZE) {
+		int n = nu_pixels - i < FUSED_CHUNK_SIZE ? nu_pixels - i : FUSED_CHUNK_SIZE;
+		float *source = (float *)(source_pixel_buffer + i * source_pixel_size);
+		if (half_float_source) {
+			detexConvertHalfFloatToFloat((uint16_t *)(source_pixel_buffer + i * source_pixel_size),
+				n * nu_components, float_buffer);
+			source = float_buffer;
+		}
+		uint8_t *target = target_pixel_buffer + i * target_pixel_size;
+		if (target_pixel_size == nu_components) {
+			ConvertNormalizedFloatToUInt8(source, n * nu_components, target, flags);
+			if (post_func != NULL)
+				post_func(target, n, NULL);
+		}
+		else {
+			ConvertNormalizedFloatToUInt8(source, n * nu_components, byte_buffer, flags);
+			post_func(byte_buffer, n, target);
+		}
+	}
+}
+
+#define FUSED_CONVERSION_TO_HALF_FLOAT(name, source_pixel_size, expand_func, nu_components, flags) \
+	static void FusedConvert##name(uint8_t * DETEX_RESTRICT source_pixel_buffer, int nu_pixels, \
+	uint8_t * DETEX_RESTRICT target_pixel_buffer) { \
+		FusedConvertUInt8ToHalfFloat(source_pixel_buffer, nu_pixels, target_pixel_buffer, \
+			source_pixel_size, expand_func, nu_components, flags, false); \
+	}
+
+#define FUSED_CONVERSION_TO_FLOAT(name, source_pixel_size, expand_func, nu_components, flags) \
+	static void FusedConvert##name(uint8_t * DETEX_RESTRICT source_pixel_buffer, int nu_pixels, \
+	uint8_t * DETEX_RESTRICT target_pixel_buffer) { \
+		FusedConvertUInt8ToHalfFloat(source_pixel_buffer, nu_pixels, target_pixel_buffer, \
+			source_pixel_size, expand_func, nu_components, flags, true); \
+	}
+
+#define FUSED_CONVERSION_FROM_FLOAT(name, half_float_source, nu_components, flags, post_func, \
+target_pixel_size) \
+	static void FusedConvert##name(uint8_t * DETEX_RESTRICT source_pixel_buffer, int nu_pixels, \
+	uint8_t * DETEX_RESTRICT target_pixel_buffer) { \
+		FusedConvertFloatToUInt8(source_pixel_buffer, nu_pixels, target_pixel_buffer, \
+			half_float_source, nu_components, flags, post_func, target_pixel_size); \
+	}
+
+FUSED_CONVERSION_TO_HALF_FLOAT(R8ToFloatR16, 1, NULL, 1, 0)
+FUSED_CONVERSION_TO_HALF_FLOAT(RG8ToFloatRG16, 2, NULL, 2, 0)
+FUSED_CONVERSION_TO_HALF_FLOAT(RGB8ToFloatRGB16, 3, NULL, 3, 0)
+FUSED_CONVERSION_TO_HALF_FLOAT(RGB8ToFloatRGBX16, 3, ConvertPixel24RGB8ToPixel32RGBX8SIMD, 4,
+	FUSED_FLOAT_ALPHA_ONE)
+FUSED_CONVERSION_TO_HALF_FLOAT(R8ToFloatRGBX16, 1, ConvertPixel8R8ToPixel32RGBX8SIMD, 4,
+	FUSED_FLOAT_SIGNED_16 | FUSED_FLOAT_ALPHA_ONE)
+FUSED_CONVERSION_TO_HALF_FLOAT(RG8ToFloatRGBX16, 2, ConvertPixel16RG8ToPixel32RGBX8SIMD, 4,
+	FUSED_FLOAT_SIGNED_16 | FUSED_FLOAT_ALPHA_ONE)
+FUSED_CONVERSION_TO_HALF_FLOAT(RGBX8ToFloatRGBX16, 4, NULL, 4,
+	FUSED_FLOAT_SIGNED_16 | FUSED_FLOAT_ALPHA_ONE)
+FUSED_CONVERSION_TO_FLOAT(R8ToFloatR32, 1, NULL, 1, 0)
+FUSED_CONVERSION_TO_FLOAT(RG8ToFloatRG32, 2, NULL, 2, 0)
+FUSED_CONVERSION_TO_FLOAT(RGB8ToFloatRGB32, 3, NULL, 3, 0)
+FUSED_CONVERSION_TO_FLOAT(RGBX8ToFloatRGBX32, 4, NULL, 4,
+	FUSED_FLOAT_SIGNED_16 | FUSED_FLOAT_ALPHA_ONE)
+FUSED_CONVERSION_FROM_FLOAT(FloatR32ToR8, false, 1, 0, NULL, 1)
+FUSED_CONVERSION_FROM_FLOAT(FloatRG32ToRG8, false, 2, 0, NULL, 2)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGB32ToRGB8, false, 3, 0, NULL, 3)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGBX32ToRGBX8, false, 4, FUSED_FLOAT_ALPHA_ONE, NULL, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGBX32ToBGRX8, false, 4, FUSED_FLOAT_ALPHA_ONE,
+	ConvertPixel32RGBA8ToPixel32BGRA8SIMD, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatR32ToRGBX8, false, 1, 0, ConvertPixel8R8ToPixel32RGBX8SIMD, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatRG32ToRGBX8, false, 2, 0, ConvertPixel16RG8ToPixel32RGBX8SIMD, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGB32ToRGBX8, false, 3, 0, ConvertPixel24RGB8ToPixel32RGBX8SIMD, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGB32ToBGRX8, false, 3, 0, ConvertPixel24RGB8ToPixel32BGRX8SIMD, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatR16ToR8, true, 1, 0, NULL, 1)
+FUSED_CONVERSION_FROM_FLOAT(FloatRG16ToRG8, true, 2, 0, NULL, 2)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGB16ToRGB8, true, 3, 0, NULL, 3)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGBX16ToRGBX8, true, 4, FUSED_FLOAT_ALPHA_ONE, NULL, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGBX16ToBGRX8, true, 4, FUSED_FLOAT_ALPHA_ONE,
+	ConvertPixel32RGBA8ToPixel32BGRA8SIMD, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGBX16ToRGB8, true, 4, 0, ConvertPixel32RGBX8ToPixel24RGB8SIMD, 3)
+FUSED_CONVERSION_FROM_FLOAT(FloatR16ToRGBX8, true, 1, 0, ConvertPixel8R8ToPixel32RGBX8SIMD, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatRG16ToRGBX8, true, 2, 0, ConvertPixel16RG8ToPixel32RGBX8SIMD, 4)
+FUSED_CONVERSION_FROM_FLOAT(FloatRGB16ToRGBX8, true, 3, 0, ConvertPixel24RGB8ToPixel32RGBX8SIMD, 4)
+
+// The fused conversions are only used for format pairs for which a conversion chain exists.
+static const detexConversionType fused_conversion_table[] = {
+	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_BGRA8, FusedConvertSwapRedBlue32SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_BGRX8, FusedConvertSwapRedBlue32SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_BGRA8, FusedConvertSwapRedBlue32SIMD },
+	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_BGRX8, FusedConvertSwapRedBlue32SIMD },
+	{ DETEX_PIXEL_FORMAT_BGRA8, DETEX_PIXEL_FORMAT_RGBA8, FusedConvertSwapRedBlue32SIMD },
+	{ DETEX_PIXEL_FORMAT_BGRA8, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertSwapRedBlue32SIMD },
+	{ DETEX_PIXEL_FORMAT_BGRX8, DETEX_PIXEL_FORMAT_RGBA8, FusedConvertSwapRedBlue32SIMD },
+	{ DETEX_PIXEL_FORMAT_BGRX8, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertSwapRedBlue32SIMD },
+#define FUSED_TO_RGBX8_AND_BGRX8(source, suffix) \
+	{ DETEX_PIXEL_FORMAT_##source, DETEX_PIXEL_FORMAT_RGBA8, FusedConvert##source##ToRGBX8##suffix }, \
+	{ DETEX_PIXEL_FORMAT_##source, DETEX_PIXEL_FORMAT_RGBX8, FusedConvert##source##ToRGBX8##suffix }, \
+	{ DETEX_PIXEL_FORMAT_##source, DETEX_PIXEL_FORMAT_BGRA8, FusedConvert##source##ToBGRX8##suffix }, \
+	{ DETEX_PIXEL_FORMAT_##source, DETEX_PIXEL_FORMAT_BGRX8, FusedConvert##source##ToBGRX8##suffix },
+	FUSED_TO_RGBX8_AND_BGRX8(R8, SIMD)
+	FUSED_TO_RGBX8_AND_BGRX8(RG8, SIMD)
+	FUSED_TO_RGBX8_AND_BGRX8(SIGNED_R8, SIMD)
+	FUSED_TO_RGBX8_AND_BGRX8(SIGNED_RG8, SIMD)
+	FUSED_TO_RGBX8_AND_BGRX8(R16, SIMD)
+	FUSED_TO_RGBX8_AND_BGRX8(RG16, SIMD)
+	FUSED_TO_RGBX8_AND_BGRX8(SIGNED_R16, )
+	FUSED_TO_RGBX8_AND_BGRX8(SIGNED_RG16, )
+#define FUSED_TO_RGBX16_AND_RGBA16(source) \
+	{ DETEX_PIXEL_FORMAT_##source, DETEX_PIXEL_FORMAT_RGBX16, FusedConvert##source##ToRGBX16SIMD }, \
+	{ DETEX_PIXEL_FORMAT_##source, DETEX_PIXEL_FORMAT_RGBA16, FusedConvert##source##ToRGBX16SIMD },
+	FUSED_TO_RGBX16_AND_RGBA16(R8)
+	FUSED_TO_RGBX16_AND_RGBA16(RG8)
+	FUSED_TO_RGBX16_AND_RGBA16(RGB8)
+	// Conversions from 8-bit components to half-floats and floats.
+	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_FLOAT_R16, FusedConvertR8ToFloatR16 },
+	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_FLOAT_RG16, FusedConvertRG8ToFloatRG16 },
+	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_FLOAT_RGB16, FusedConvertRGB8ToFloatRGB16 },
+	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, FusedConvertRGB8ToFloatRGBX16 },
+	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, FusedConvertR8ToFloatRGBX16 },
+	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, FusedConvertRG8ToFloatRGBX16 },
+	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, FusedConvertRGBX8ToFloatRGBX16 },
+	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_FLOAT_RGBX16, FusedConvertRGBX8ToFloatRGBX16 },
+	{ DETEX_PIXEL_FORMAT_R8, DETEX_PIXEL_FORMAT_FLOAT_R32, FusedConvertR8ToFloatR32 },
+	{ DETEX_PIXEL_FORMAT_RG8, DETEX_PIXEL_FORMAT_FLOAT_RG32, FusedConvertRG8ToFloatRG32 },
+	{ DETEX_PIXEL_FORMAT_RGB8, DETEX_PIXEL_FORMAT_FLOAT_RGB32, FusedConvertRGB8ToFloatRGB32 },
+	{ DETEX_PIXEL_FORMAT_RGBX8, DETEX_PIXEL_FORMAT_FLOAT_RGBX32, FusedConvertRGBX8ToFloatRGBX32 },
+	{ DETEX_PIXEL_FORMAT_RGBA8, DETEX_PIXEL_FORMAT_FLOAT_RGBX32, FusedConvertRGBX8ToFloatRGBX32 },
+	// Conversions from floats and half-floats to 8-bit components.
+	{ DETEX_PIXEL_FORMAT_FLOAT_R32, DETEX_PIXEL_FORMAT_R8, FusedConvertFloatR32ToR8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RG32, DETEX_PIXEL_FORMAT_RG8, FusedConvertFloatRG32ToRG8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGB32, DETEX_PIXEL_FORMAT_RGB8, FusedConvertFloatRGB32ToRGB8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX32, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertFloatRGBX32ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX32, DETEX_PIXEL_FORMAT_RGBA8, FusedConvertFloatRGBX32ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX32, DETEX_PIXEL_FORMAT_BGRX8, FusedConvertFloatRGBX32ToBGRX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_R32, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertFloatR32ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RG32, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertFloatRG32ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGB32, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertFloatRGB32ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGB32, DETEX_PIXEL_FORMAT_BGRX8, FusedConvertFloatRGB32ToBGRX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_R16, DETEX_PIXEL_FORMAT_R8, FusedConvertFloatR16ToR8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RG16, DETEX_PIXEL_FORMAT_RG8, FusedConvertFloatRG16ToRG8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGB16, DETEX_PIXEL_FORMAT_RGB8, FusedConvertFloatRGB16ToRGB8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertFloatRGBX16ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_RGBA8, FusedConvertFloatRGBX16ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_BGRX8, FusedConvertFloatRGBX16ToBGRX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_BGRA8, FusedConvertFloatRGBX16ToBGRX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16, DETEX_PIXEL_FORMAT_RGB8, FusedConvertFloatRGBX16ToRGB8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_R16, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertFloatR16ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RG16, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertFloatRG16ToRGBX8 },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGB16, DETEX_PIXEL_FORMAT_RGBX8, FusedConvertFloatRGB16ToRGBX8 },
+};
+
+#define NU_FUSED_CONVERSION_TYPES (sizeof(fused_conversion_table) / sizeof(fused_conversion_table[0]))
+
+// #define TRACE_MATCH_CONVERSION
+
+// Search for a conversion path of up to four steps between two different pixel formats.
+// Returns number of conversion steps, -1 if not succesful. This is only used to build the
+// table of conversion paths.
+static int SearchConversion(uint32_t source_pixel_format, uint32_t target_pixel_format,
+uint8_t *conversion) {
 #ifdef TRACE_MATCH_CONVERSION
 	printf("Matching conversion between %s and %s.\n", detexGetTextureFormatText(source_pixel_format),
 		detexGetTextureFormatText(target_pixel_format));
 #endif
-	// Check whether the conversion has been cached.
-	if (source_pixel_format == cached_source_format && target_pixel_format == cached_target_format) {
-		for (int i = 0; i < cached_nu_conversions; i++)
-			conversion[i] = cached_conversion[i];
-		return cached_nu_conversions;
-	}
 	// First check direct conversions.
 	for (int i = 0; i < NU_CONVERSION_TYPES; i++)
 		if (detex_conversion_table[i].target_format == target_pixel_format 
 		&& detex_conversion_table[i].source_format == source_pixel_format) {
 			conversion[0] = i;
-			CacheResult(source_pixel_format, target_pixel_format, 1, conversion);
 			return 1;
 		}
 	// Check two-step conversions.
@@ -933,7 +1886,6 @@ uint32_t *conversion) {
 				detex_conversion_table[i].source_format &&
 				detex_conversion_table[j].source_format == source_pixel_format) {
 					conversion[0] = j;
-					CacheResult(source_pixel_format, target_pixel_format, 2, conversion);
 					return 2;
 				}
 			}
@@ -975,8 +1927,6 @@ uint32_t *conversion) {
 						detex_conversion_table[k].source_format ==
 						detex_conversion_table[i].target_format) {
 							conversion[1] = k;
-							CacheResult(source_pixel_format, target_pixel_format,
-								3, conversion);
 							return 3;
 						}
 				}
@@ -1036,8 +1986,6 @@ uint32_t *conversion) {
 								detex_conversion_table[l].source_format ==
 								detex_conversion_table[k].target_format) {
 									conversion[2] = l;
-									CacheResult(source_pixel_format, target_pixel_format,
-										4, conversion);
 									return 4;
 								}
 							}
@@ -1047,32 +1995,150 @@ uint32_t *conversion) {
 	return - 1;
 }
 
-// Temporary pixel buffer management for conversion function.
-
-#define DETEX_MAX_TEMP_PIXEL_BUFFERS 3
+// Conversion paths between all pairs of pixel formats that occur in the conversion table,
+// determined once with SearchConversion. A path length of -1 indicates that there is no
+// conversion path.
 
 typedef struct {
-	uint8_t *pixel_buffer[DETEX_MAX_TEMP_PIXEL_BUFFERS];
-	uint32_t size[DETEX_MAX_TEMP_PIXEL_BUFFERS];
-	int nu_buffers;
-} TempPixelBufferInfo;
+	int8_t length;
+	// Index into fused_conversion_table, or -1 when there is no fused conversion.
+	int8_t fused;
+	uint8_t step[4];
+} ConversionPath;
+
+// Each conversion adds at most two formats.
+static uint32_t conversion_format[NU_CONVERSION_TYPES * 2];
+static int nu_conversion_formats;
+// The paths, indexed by source format index * nu_conversion_formats + target format index.
+// NULL when the table could not be allocated.
+static ConversionPath *conversion_path;
+static pthread_once_t conversion_paths_once = PTHREAD_ONCE_INIT;
+
+static void AddConversionFormat(uint32_t pixel_format) {
+	for (int i = 0; i < nu_conversion_formats; i++)
+		if (conversion_format[i] == pixel_format)
+			return;
+	conversion_format[nu_conversion_formats] = pixel_format;
+	nu_conversion_formats++;
+}
+
+static void InitConversionPaths() {
+	for (int i = 0; i < NU_CONVERSION_TYPES; i++) {
+		AddConversionFormat(detex_conversion_table[i].source_format);
+		AddConversionFormat(detex_conversion_table[i].target_format);
+	}
+	conversion_path = (ConversionPath *)malloc(sizeof(ConversionPath) * nu_conversion_formats *
+		nu_conversion_formats);
+	if (conversion_path == NULL)
+		return;
+	for (int i = 0; i < nu_conversion_formats; i++)
+		for (int j = 0; j < nu_conversion_formats; j++) {
+			ConversionPath *path = &conversion_path[i * nu_conversion_formats + j];
+			path->fused = - 1;
+			if (i == j) {
+				path->length = 0;
+				continue;
+			}
+			path->length = SearchConversion(conversion_format[i], conversion_format[j],
+				path->step);
+			// Use a fused conversion for multi-step paths when available.
+			if (path->length < 2)
+				continue;
+			for (int k = 0; k < NU_FUSED_CONVERSION_TYPES; k++)
+				if (fused_conversion_table[k].source_format == conversion_format[i] &&
+				fused_conversion_table[k].target_format == conversion_format[j])
+					path->fused = k;
+		}
+}
+
+static int LookupConversionFormat(uint32_t pixel_format) {
+	for (int i = 0; i < nu_conversion_formats; i++)
+		if (conversion_format[i] == pixel_format)
+			return i;
+	return - 1;
+}
 
-static void InitTemporaryPixelBuffers(TempPixelBufferInfo *info) {
-	info->nu_buffers = 0;
+// Match conversion. Returns number of conversion steps, -1 if not succesful. fused_out
+// returns the index of the fused conversion for the path, or -1.
+static int detexMatchConversion(uint32_t source_pixel_format, uint32_t target_pixel_format,
+uint8_t *conversion, int *fused_out) {
+	*fused_out = - 1;
+	// Immediately return if the formats are identical.
+	if (source_pixel_format == target_pixel_format)
+		return 0;
+	pthread_once(&conversion_paths_once, InitConversionPaths);
+	if (conversion_path == NULL)
+		return - 1;
+	int source_index = LookupConversionFormat(source_pixel_format);
+	int target_index = LookupConversionFormat(target_pixel_format);
+	if (source_index < 0 || target_index < 0)
+		return - 1;
+	const ConversionPath *path = &conversion_path[source_index * nu_conversion_formats +
+		target_index];
+	*fused_out = path->fused;
+	for (int i = 0; i < path->length; i++)
+		conversion[i] = path->step[i];
+	return path->length;
+}
+
+// Conversions with steps that change the pixel size are performed in chunks of pixels,
+// with intermediate results stored in temporary buffers on the stack.
+
+#define CONVERSION_CHUNK_SIZE 256
+#define MAX_PIXEL_SIZE 16
+
+struct detexConversionPlan {
+	uint32_t source_pixel_format;
+	uint32_t target_pixel_format;
+	int nu_steps;
+	uint8_t step[4];
+	int fused_conversion;
+};
+
+// Initialize a conversion plan between two pixel formats. Returns false, setting an error
+// message for func_name, if there is no conversion path.
+static bool InitConversionPlan(detexConversionPlan *plan, uint32_t source_pixel_format,
+uint32_t target_pixel_format, const char *func_name) {
+	plan->source_pixel_format = source_pixel_format;
+	plan->target_pixel_format = target_pixel_format;
+	plan->nu_steps = detexMatchConversion(source_pixel_format, target_pixel_format, plan->step,
+		&plan->fused_conversion);
+	if (plan->nu_steps >= 0)
+		return true;
+	if (conversion_path == NULL)
+		detexSetErrorMessage("%s: Out of memory", func_name);
+	else
+		detexSetErrorMessage("%s: Unable to find conversion path", func_name);
+	return false;
 }
 
-static uint8_t *AllocateTemporaryPixelBuffer(TempPixelBufferInfo *info, uint32_t size) {
-	if (info->nu_buffers == DETEX_MAX_TEMP_PIXEL_BUFFERS)
+// Create a conversion plan between two pixel formats. Returns NULL if there is no
+// conversion path or memory could not be allocated.
+detexConversionPlan *detexCreateConversionPlan(uint32_t source_pixel_format,
+uint32_t target_pixel_format) {
+	detexConversionPlan *plan = (detexConversionPlan *)malloc(sizeof(detexConversionPlan));
+	if (plan == NULL) {
+		detexSetErrorMessage("detexCreateConversionPlan: Out of memory");
+		return NULL;
+	}
+	if (!InitConversionPlan(plan, source_pixel_format, target_pixel_format,
+	"detexCreateConversionPlan")) {
+		free(plan);
 		return NULL;
-	uint8_t *buffer = (uint8_t *)malloc(size);
-	info->pixel_buffer[info->nu_buffers] = buffer;
-	info->nu_buffers++;
-	return buffer;
+	}
+	return plan;
+}
+
+void detexFreeConversionPlan(detexConversionPlan *plan) {
+	free(plan);
+}
+
+uint32_t detexGetConversionPlanSourceFormat(const detexConversionPlan *plan) {
+	return plan->source_pixel_format;
 }
 
-static void FreeTemporaryPixelBuffers(TempPixelBufferInfo *info) {
-	for (int i = 0; i < info->nu_buffers; i++)
-		free(info->pixel_buffer[i]);
+uint32_t detexGetConversionPlanTargetFormat(const detexConversionPlan *plan) {
+	return plan->target_pixel_format;
 }
 
 // Convert pixels between different formats. Return true if successful.
@@ -1084,18 +2150,31 @@ uint32_t source_pixel_format, uint8_t * DETEX_RESTRICT target_pixel_buffer,
 uint32_t target_pixel_format) {
 //	printf("Converting between %s and %s (0x%08X and 0x%08X).\n", detexGetTextureFormatText(source_pixel_format),
 //		detexGetTextureFormatText(target_pixel_format), source_pixel_format, target_pixel_format);
-	if (source_pixel_format == target_pixel_format) {
+	detexConversionPlan plan;
+	if (!InitConversionPlan(&plan, source_pixel_format, target_pixel_format, "detexConvertPixels"))
+		return false;
+	return detexConvertPixelsWithPlan(&plan, source_pixel_buffer, nu_pixels, target_pixel_buffer);
+}
+
+// Convert pixels using a conversion plan. Return true if successful. If target_pixel_format
+// is NULL, the conversion will be attempted in-place.
+bool detexConvertPixelsWithPlan(const detexConversionPlan *plan,
+uint8_t * DETEX_RESTRICT source_pixel_buffer, uint32_t nu_pixels,
+uint8_t * DETEX_RESTRICT target_pixel_buffer) {
+	uint32_t source_pixel_format = plan->source_pixel_format;
+	if (plan->nu_steps == 0) {
 		if (target_pixel_buffer != NULL)
 			memcpy(target_pixel_buffer, source_pixel_buffer, nu_pixels *
 				detexGetPixelSize(source_pixel_format));
 		return true;
 	}
-	uint32_t conversion[4];
-	int nu_conversions = detexMatchConversion(source_pixel_format, target_pixel_format, conversion);
-	if (nu_conversions < 0) {
-		detexSetErrorMessage("detexConvertPixels: Unable to find conversion path");
-		return false;
+	if (plan->fused_conversion >= 0 && target_pixel_buffer != NULL) {
+		fused_conversion_table[plan->fused_conversion].conversion_func(source_pixel_buffer,
+			nu_pixels, target_pixel_buffer);
+		return true;
 	}
+	const uint8_t *conversion = plan->step;
+	int nu_conversions = plan->nu_steps;
 	// Count in place/non-place steps.
 	int nu_non_in_place_conversions = 0;
 	int last_non_in_place_conversion = - 1;
@@ -1112,61 +2191,89 @@ uint32_t target_pixel_format) {
 		detexSetErrorMessage("Unable to find in-place conversion path");
 		return false;
 	}
-	// Perform conversions.
-	TempPixelBufferInfo temp_pixel_buffer_info;
-	InitTemporaryPixelBuffers(&temp_pixel_buffer_info);
-	if (first_non_in_place_conversion > 0) {
-		// When doing a non-place conversion and the first conversion step is in-place,
-		// allocate a temporary buffer to avoid corrupting the source buffer.
-		uint8_t *temp_pixel_buffer = AllocateTemporaryPixelBuffer(&temp_pixel_buffer_info,
-			detexGetPixelSize(source_pixel_format) * nu_pixels);
-		memcpy(temp_pixel_buffer, source_pixel_buffer,
-			detexGetPixelSize(source_pixel_format) * nu_pixels);
-		source_pixel_buffer = temp_pixel_buffer;
-	}
-	if (target_pixel_buffer != NULL && nu_non_in_place_conversions == 0) {
-		// When doing a non-in-place conversion with only in-place conversion steps,
-		// start by copying the source buffer to the target buffer.
-		memcpy(target_pixel_buffer, source_pixel_buffer,
-			detexGetPixelSize(source_pixel_format) * nu_pixels);
-		source_pixel_buffer = target_pixel_buffer;
-	}
-	for (int i = 0; i < nu_conversions; i++) {
-		if (detexGetPixelSize(detex_conversion_table[conversion[i]].source_format)
-		== detexGetPixelSize(detex_conversion_table[conversion[i]].target_format)) {
-			// In-place conversion step.
-			detex_conversion_table[conversion[i]].conversion_func(
-				source_pixel_buffer, nu_pixels, NULL);
+	if (nu_non_in_place_conversions == 0) {
+		// Perform in-place conversions on the whole buffer.
+		if (target_pixel_buffer != NULL) {
+			// When doing a non-in-place conversion with only in-place conversion steps,
+			// start by copying the source buffer to the target buffer.
+			memcpy(target_pixel_buffer, source_pixel_buffer,
+				detexGetPixelSize(source_pixel_format) * nu_pixels);
+			source_pixel_buffer = target_pixel_buffer;
 		}
-		else {
-			if (i == last_non_in_place_conversion) {
-				detex_conversion_table[conversion[i]].conversion_func(
-					source_pixel_buffer, nu_pixels, target_pixel_buffer);
-				source_pixel_buffer = target_pixel_buffer;
+		for (int i = 0; i < nu_conversions; i++)
+			detex_conversion_table[conversion[i]].conversion_func(source_pixel_buffer,
+				nu_pixels, NULL);
+		return true;
+	}
+	uint8_t temp_pixel_buffer[2][CONVERSION_CHUNK_SIZE * MAX_PIXEL_SIZE];
+	int source_pixel_size = detexGetPixelSize(source_pixel_format);
+	int target_pixel_size = detexGetPixelSize(plan->target_pixel_format);
+	for (uint32_t start = 0; start < nu_pixels; start += CONVERSION_CHUNK_SIZE) {
+		int n = nu_pixels - start < CONVERSION_CHUNK_SIZE ? nu_pixels - start : CONVERSION_CHUNK_SIZE;
+		uint8_t *pixel_buffer = source_pixel_buffer + start * source_pixel_size;
+		int temp_index = 0;
+		if (first_non_in_place_conversion > 0) {
+			// When the first conversion step is in-place, copy the source pixels to a
+			// temporary buffer to avoid corrupting the source buffer.
+			memcpy(temp_pixel_buffer[0], pixel_buffer, n * source_pixel_size);
+			pixel_buffer = temp_pixel_buffer[0];
+			temp_index = 1;
+		}
+		for (int i = 0; i < nu_conversions; i++) {
+			const detexConversionType *step = &detex_conversion_table[conversion[i]];
+			if (detexGetPixelSize(step->source_format) == detexGetPixelSize(step->target_format))
+				// In-place conversion step.
+				step->conversion_func(pixel_buffer, n, NULL);
+			else if (i == last_non_in_place_conversion) {
+				uint8_t *target = target_pixel_buffer + start * target_pixel_size;
+				step->conversion_func(pixel_buffer, n, target);
+				pixel_buffer = target;
 			}
 			else {
-				uint8_t *temp_pixel_buffer = AllocateTemporaryPixelBuffer(&temp_pixel_buffer_info,
-					nu_pixels * detexGetPixelSize(
-						detex_conversion_table[conversion[i]].target_format));
-				if (temp_pixel_buffer == NULL) {
-					// Error: Too many temporary buffers needed.
-					detexSetErrorMessage("detexConvertPixels: Too many temporary buffers needed");
-					FreeTemporaryPixelBuffers(&temp_pixel_buffer_info);
-					return false;
-				}
-				detex_conversion_table[conversion[i]].conversion_func(
-					source_pixel_buffer, nu_pixels, temp_pixel_buffer);
-				source_pixel_buffer = temp_pixel_buffer;
+				// Alternate between the temporary buffers.
+				step->conversion_func(pixel_buffer, n, temp_pixel_buffer[temp_index]);
+				pixel_buffer = temp_pixel_buffer[temp_index];
+				temp_index ^= 1;
 			}
 		}
-	
 	}
-	FreeTemporaryPixelBuffers(&temp_pixel_buffer_info);
 	return true;
 }
 
+// Convert pixels using a conversion plan and explicit HDR parameters, which are used
+// instead of the thread-local parameters for the duration of the call.
+bool detexConvertPixelsWithPlanHDR(const detexConversionPlan *plan,
+uint8_t * DETEX_RESTRICT source_pixel_buffer, uint32_t nu_pixels,
+uint8_t * DETEX_RESTRICT target_pixel_buffer, const detexHDRParameters *params) {
+	const detexHDRParameters *previous_params = detexSetActiveHDRParameters(params);
+	bool result = detexConvertPixelsWithPlan(plan, source_pixel_buffer, nu_pixels, target_pixel_buffer);
+	detexSetActiveHDRParameters(previous_params);
+	return result;
+}
+
+bool detexConvertPixelsHDR(uint8_t * DETEX_RESTRICT source_pixel_buffer, uint32_t nu_pixels,
+uint32_t source_pixel_format, uint8_t * DETEX_RESTRICT target_pixel_buffer,
+uint32_t target_pixel_format, const detexHDRParameters *params) {
+	detexConversionPlan plan;
+	if (!InitConversionPlan(&plan, source_pixel_format, target_pixel_format,
+	"detexConvertPixelsHDR"))
+		return false;
+	return detexConvertPixelsWithPlanHDR(&plan, source_pixel_buffer, nu_pixels, target_pixel_buffer,
+		params);
+}
+
 bool detexConvertPixelsInPlace(uint8_t * DETEX_RESTRICT source_pixel_buffer, uint32_t nu_pixels,
 uint32_t source_pixel_format, uint32_t target_pixel_format) {
 	return detexConvertPixels(source_pixel_buffer, nu_pixels, source_pixel_format, NULL, target_pixel_format);
 }
 
+
+// Return the source and target pixel formats of the elementary conversion with the given
+// index in the conversion table. Returns false if the index is out of range.
+bool detexGetConversion(int index, uint32_t *source_pixel_format, uint32_t *target_pixel_format) {
+	if (index < 0 || index >= (int)NU_CONVERSION_TYPES)
+		return false;
+	*source_pixel_format = detex_conversion_table[index].source_format;
+	*target_pixel_format = detex_conversion_table[index].target_format;
+	return true;
+}
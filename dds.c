@@ -23,43 +23,41 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "detex.h"
 #include "file-info.h"
 #include "misc.h"
+#include "stream.h"
 
-// Load texture from DDS file with mip-maps. Returns true if successful.
-// nu_levels is a return parameter that returns the number of mipmap levels found.
-// textures_out is a return parameter for an array of detexTexture pointers that is allocated,
-// free with free(). textures_out[i] are allocated textures corresponding to each level, free
-// with free();
-bool detexLoadDDSFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
-int *nu_levels_out) {
-	FILE *f = fopen(filename, "rb");
-	if (f == NULL) {
-		detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Could not open file %s", filename);
-		return false;
-	}
+// Properties of a DDS file read from its header.
+typedef struct {
+	const detexTextureFileInfo *info;
+	int width;
+	int height;
+	int nu_file_mipmaps;
+} DDSHeader;
+
+// Read the header of a DDS file, leaving the input source positioned at the data of the
+// first mipmap level. func_name and filename (NULL when not loading from a file) are used
+// in error messages.
+static bool ReadDDSHeader(detexInputSource *source, const char *func_name, const char *filename,
+DDSHeader *dds_header) {
 	// Read signature.
 	char id[4];
-	size_t s = fread(id, 1, 4, f);
-	if (s != 4) {
-		detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Error reading file %s", filename);
+	if (!detexReadInputSource(source, id, 4)) {
+		detexSetReadErrorMessage(func_name, filename);
 		return false;
 	}
 	if (id[0] != 'D' || id[1] != 'D' || id[2] != 'S' || id[3] != ' ') {
-		detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Couldn't find DDS signature");
+		detexSetErrorMessage("%s: Couldn't find DDS signature", func_name);
 		return false;
 	}
 	uint8_t header[124];
-	s = fread(header, 1, 124, f);
-	if (s != 124) {
-		detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Error reading file %s", filename);
+	if (!detexReadInputSource(source, header, 124)) {
+		detexSetReadErrorMessage(func_name, filename);
 		return false;
 	}
 	uint8_t *headerp = &header[0];
-	int width = *(uint32_t *)(headerp + 12);
-	int height = *(uint32_t *)(headerp + 8);
+	dds_header->width = *(uint32_t *)(headerp + 12);
+	dds_header->height = *(uint32_t *)(headerp + 8);
 //	int pitch = *(uint32_t *)(headerp + 16);
 	int pixel_format_flags = *(uint32_t *)(headerp + 76);
-	int block_width = 4;
-	int block_height = 4;
 	int bitcount = *(uint32_t *)(headerp + 84);
 	uint32_t red_mask = *(uint32_t *)(headerp + 88);
 	uint32_t green_mask = *(uint32_t *)(headerp + 92);
@@ -71,76 +69,169 @@ int *nu_levels_out) {
 	uint32_t dx10_format = 0;
 	if (strncmp(four_cc, "DX10", 4) == 0) {
 		uint32_t dx10_header[5];
-		s = fread(dx10_header, 1, 20, f);
-		if (s != 20) {
-			detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Error reading file %s", filename);
+		if (!detexReadInputSource(source, dx10_header, 20)) {
+			detexSetReadErrorMessage(func_name, filename);
 			return false;
 		}
 		dx10_format = dx10_header[0];
 		uint32_t resource_dimension = dx10_header[1];
 		if (resource_dimension != 3) {
-			detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Only 2D textures supported for .dds files");
+			detexSetErrorMessage("%s: Only 2D textures supported for .dds files", func_name);
 			return false;
 		}
 	}
-	const detexTextureFileInfo *info = detexLookupDDSFileInfo(four_cc, dx10_format, pixel_format_flags, bitcount,
+	dds_header->info = detexLookupDDSFileInfo(four_cc, dx10_format, pixel_format_flags, bitcount,
 		red_mask, green_mask, blue_mask, alpha_mask);
-	if (info == NULL) {
-		detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Unsupported format in .dds file (fourCC = %s, "
-			"DX10 format = %d).", four_cc, dx10_format);
+	if (dds_header->info == NULL) {
+		detexSetErrorMessage("%s: Unsupported format in .dds file (fourCC = %s, "
+			"DX10 format = %d).", func_name, four_cc, dx10_format);
 		return false;
 	}
 	// Maybe implement option to treat BC1 as BC1A?
-	int bytes_per_block;
-	if (detexFormatIsCompressed(info->texture_format))
-		bytes_per_block = detexGetCompressedBlockSize(info->texture_format);
-	else
-		bytes_per_block = detexGetPixelSize(info->texture_format);
-	block_width = info->block_width;
-	block_height = info->block_height;
-	int extended_width = ((width + block_width - 1) / block_width) * block_width;
-	int extended_height = ((height + block_height - 1) / block_height) * block_height;
 	uint32_t flags = *(uint32_t *)(headerp + 4);
-	int nu_file_mipmaps = 1;
+	dds_header->nu_file_mipmaps = 1;
 	if (flags & 0x20000) {
-		nu_file_mipmaps = *(uint32_t *)(headerp + 24);
+		dds_header->nu_file_mipmaps = *(uint32_t *)(headerp + 24);
 //		if (nu_file_mipmaps > 1 && max_mipmaps == 1) {
 //			detexSetErrorMessage("Disregarding mipmaps beyond the first level.\n");
 //		}
 	}
+	return true;
+}
+
+// Set the properties of a mipmap level texture of the given size, without data.
+static void SetDDSLevel(const DDSHeader *dds_header, int width, int height, detexTexture *texture) {
+	int block_width = dds_header->info->block_width;
+	int block_height = dds_header->info->block_height;
+	texture->format = dds_header->info->texture_format;
+	texture->width = width;
+	texture->height = height;
+	texture->width_in_blocks = (width + block_width - 1) / block_width;
+	texture->height_in_blocks = (height + block_height - 1) / block_height;
+	texture->data = NULL;
+}
+
+// Load texture from DDS input source with mip-maps. When reference_data is true, the
+// texture data references the memory of the input source instead of being copied.
+// func_name and filename (NULL when not loading from a file) are used in error messages.
+static bool LoadDDSWithMipmaps(detexInputSource *source, const char *func_name, const char *filename,
+int max_mipmaps, bool reference_data, detexTexture ***textures_out, int *nu_levels_out) {
+	DDSHeader dds_header;
+	if (!ReadDDSHeader(source, func_name, filename, &dds_header))
+		return false;
+	int width = dds_header.width;
+	int height = dds_header.height;
 	int nu_mipmaps;
-	if (nu_file_mipmaps > max_mipmaps)
+	if (dds_header.nu_file_mipmaps > max_mipmaps)
 		nu_mipmaps = max_mipmaps;
 	else
-		nu_mipmaps = nu_file_mipmaps;
+		nu_mipmaps = dds_header.nu_file_mipmaps;
 	detexTexture **textures = (detexTexture **)malloc(sizeof(detexTexture *) * nu_mipmaps);
 	for (int i = 0; i < nu_mipmaps; i++) {
-		int n = (extended_height / block_width) * (extended_width / block_height);
 		// Allocate texture.
 		textures[i] = (detexTexture *)malloc(sizeof(detexTexture));
-		textures[i]->format = info->texture_format;
-		textures[i]->data = (uint8_t *)malloc(n * bytes_per_block);
-		textures[i]->width = width;
-		textures[i]->height = height;
-		textures[i]->width_in_blocks = extended_width / block_width;
-		textures[i]->height_in_blocks = extended_height / block_height;
-		size_t r = fread(textures[i]->data, 1, n * bytes_per_block, f);
-		if (r < n * bytes_per_block) {
-			detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Error reading file %s", filename);
+		SetDDSLevel(&dds_header, width, height, textures[i]);
+		int image_size = textures[i]->width_in_blocks * textures[i]->height_in_blocks *
+			detexGetFileBytesPerBlock(textures[i]->format);
+		bool r;
+		if (reference_data) {
+			textures[i]->data = detexReferenceTextureData(source, image_size);
+			r = (textures[i]->data != NULL);
+		}
+		else {
+			textures[i]->data = (uint8_t *)malloc(image_size);
+			r = detexReadInputSource(source, textures[i]->data, image_size);
+		}
+		if (!r) {
+			detexFreeLoadedTextures(textures, i + 1, reference_data ? source : NULL);
+			detexSetReadErrorMessage(func_name, filename);
 			return false;
 		}
 		// Divide by two for the next mipmap level, rounding down.
 		width >>= 1;
 		height >>= 1;
-		extended_width = ((width + block_width - 1) / block_width) * block_width;
-		extended_height = ((height + block_height - 1) / block_height) * block_height;
 	}
-	fclose(f);
 	*nu_levels_out = nu_mipmaps;
 	*textures_out = textures;
 	return true;
 }
 
+// Read the header of a DDS file from an input source, leaving the source positioned at
+// the data of the first mipmap level, the properties of which are returned in
+// texture_out (with data set to NULL).
+bool detexReadDDSFirstLevel(detexInputSource *source, const char *func_name, const char *filename,
+detexTexture *texture_out) {
+	DDSHeader dds_header;
+	if (!ReadDDSHeader(source, func_name, filename, &dds_header))
+		return false;
+	SetDDSLevel(&dds_header, dds_header.width, dds_header.height, texture_out);
+	return true;
+}
+
+// Load texture from DDS file with mip-maps. Returns true if successful.
+// nu_levels is a return parameter that returns the number of mipmap levels found.
+// textures_out is a return parameter for an array of detexTexture pointers that is allocated,
+// free with free(). textures_out[i] are allocated textures corresponding to each level, free
+// with free();
+bool detexLoadDDSFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
+int *nu_levels_out) {
+	FILE *f = fopen(filename, "rb");
+	if (f == NULL) {
+		detexSetErrorMessage("detexLoadDDSFileWithMipmaps: Could not open file %s", filename);
+		return false;
+	}
+	detexInputSource source;
+	detexInitFileInputSource(&source, f);
+	bool r = LoadDDSWithMipmaps(&source, "detexLoadDDSFileWithMipmaps", filename, max_mipmaps, false,
+		textures_out, nu_levels_out);
+	fclose(f);
+	return r;
+}
+
+// Map DDS file into memory with mip-maps. Returns true if successful. The texture data
+// references the mapped file. textures_out and nu_levels_out are return parameters as with
+// detexLoadDDSFileWithMipmaps, but the textures are owned by the mapped file that is
+// returned in file_out and must be released with detexReleaseMappedTextureFile().
+bool detexMapDDSFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
+int *nu_levels_out, detexMappedTextureFile **file_out) {
+	detexMappedTextureFile *file = detexMapFile(filename, "detexMapDDSFileWithMipmaps");
+	if (file == NULL)
+		return false;
+	detexInputSource source;
+	detexInitMemoryInputSource(&source, (const uint8_t *)file->mapping, file->size);
+	if (!LoadDDSWithMipmaps(&source, "detexMapDDSFileWithMipmaps", filename, max_mipmaps, true,
+	&file->textures, &file->nu_levels)) {
+		detexReleaseMappedTextureFile(file);
+		return false;
+	}
+	*textures_out = file->textures;
+	*nu_levels_out = file->nu_levels;
+	*file_out = file;
+	return true;
+}
+
+
+// Load texture from DDS file data in memory with mip-maps. Returns true if successful.
+// The texture data is copied; textures_out and nu_levels_out are return parameters as with
+// detexLoadDDSFileWithMipmaps.
+bool detexLoadDDSMemoryWithMipmaps(const uint8_t *data, size_t size, int max_mipmaps,
+detexTexture ***textures_out, int *nu_levels_out) {
+	detexInputSource source;
+	detexInitMemoryInputSource(&source, data, size);
+	return LoadDDSWithMipmaps(&source, "detexLoadDDSMemoryWithMipmaps", NULL, max_mipmaps, false,
+		textures_out, nu_levels_out);
+}
+
+// Load texture from DDS file data read from a stream with mip-maps. Returns true if
+// successful. textures_out and nu_levels_out are return parameters as with
+// detexLoadDDSFileWithMipmaps.
+bool detexLoadDDSStreamWithMipmaps(detexReadFunc read_func, void *user_data, int max_mipmaps,
+detexTexture ***textures_out, int *nu_levels_out) {
+	detexInputSource source;
+	detexInitStreamInputSource(&source, read_func, user_data);
+	return LoadDDSWithMipmaps(&source, "detexLoadDDSStreamWithMipmaps", NULL, max_mipmaps, false,
+		textures_out, nu_levels_out);
+}
 
 // Load texture from DDS file (first mip-map only). Returns true if successful.
 // The texture is allocated, free with free().
@@ -159,25 +250,23 @@ static const char dds_id[4] = {
 	'D', 'D', 'S', ' '
 };
 
-// Save textures to DDS file (multiple mip-maps levels). Return true if succesful.
-bool detexSaveDDSFileWithMipmaps(detexTexture **textures, int nu_levels, const char *filename) {
-	FILE *f = fopen(filename, "wb");
-	if (f == NULL) {
-		detexSetErrorMessage("detexSaveDDSFileWithMipmaps: Could not open file %s for writing", filename);
-		return false;
-	}
+// Save textures in DDS format (multiple mip-maps levels) using a write callback. Return true
+// if succesful. func_name and filename (NULL when not saving to a file) are used in error
+// messages.
+static bool SaveDDSWithMipmaps(detexTexture **textures, int nu_levels, detexWriteFunc write_func,
+void *user_data, const char *func_name, const char *filename) {
 	const detexTextureFileInfo *info = detexLookupTextureFormatFileInfo(textures[0]->format);
 	if (info == NULL) {
-		detexSetErrorMessage("detexSaveDDSFileWithMipmaps: Could not match texture format with file format");
+		detexSetErrorMessage("%s: Could not match texture format with file format", func_name);
 		return false;
 	}
 	if (!info->dds_support) {
-		detexSetErrorMessage("detexSaveDDSFileWithMipmaps: Could not match texture format with DDS file format");
+		detexSetErrorMessage("%s: Could not match texture format with DDS file format", func_name);
 		return false;
 	}
-	size_t r = fwrite(dds_id, 1, 4, f);
+	size_t r = write_func(user_data, dds_id, 4);
 	if (r != 4) {
-		detexSetErrorMessage("detexSaveDDSFileWithMipmaps: Error writing to file %s", filename);
+		detexSetWriteErrorMessage(func_name, filename);
 		return false;
 	}
 	int n;
@@ -250,15 +339,15 @@ bool detexSaveDDSFileWithMipmaps(detexTexture **textures, int nu_levels, const c
 	int pitch = textures[0]->width * detexGetPixelSize(textures[0]->format);
 	if (!detexFormatIsCompressed(textures[0]->format))
 		*(uint32_t *)(header + 16) = pitch;
-	r = fwrite(header, 1, 124, f);
+	r = write_func(user_data, header, 124);
 	if (r != 124) {
-		detexSetErrorMessage("detexSaveDDSFileWithMipmaps: Error writing to file %s", filename);
+		detexSetWriteErrorMessage(func_name, filename);
 		return false;
 	}
 	if (write_dx10_header) {
-		r = fwrite(dx10_header, 1, 20, f);
+		r = write_func(user_data, dx10_header, 20);
 		if (r != 20) {
-			detexSetErrorMessage("detexSaveDDSFileWithMipmaps: Error writing to file %s", filename);
+			detexSetWriteErrorMessage(func_name, filename);
 			return false;
 		}
 	}
@@ -278,16 +367,51 @@ bool detexSaveDDSFileWithMipmaps(detexTexture **textures, int nu_levels, const c
 			block_size = pixel_size;
 		}
 		// Write level data.
-		r = fwrite(textures[i]->data, 1, n * block_size, f);
+		r = write_func(user_data, textures[i]->data, n * block_size);
 		if (r != n * block_size) {
-			detexSetErrorMessage("detexSaveDDSFileWithMipmaps: Error writing to file %s", filename);
+			detexSetWriteErrorMessage(func_name, filename);
 			return false;
 		}
 	}
+	return true;
+}
+
+// Save textures to DDS file (multiple mip-maps levels). Return true if succesful.
+bool detexSaveDDSFileWithMipmaps(detexTexture **textures, int nu_levels, const char *filename) {
+	FILE *f = fopen(filename, "wb");
+	if (f == NULL) {
+		detexSetErrorMessage("detexSaveDDSFileWithMipmaps: Could not open file %s for writing", filename);
+		return false;
+	}
+	bool r = SaveDDSWithMipmaps(textures, nu_levels, detexWriteFile, f, "detexSaveDDSFileWithMipmaps",
+		filename);
 	fclose(f);
+	return r;
+}
+
+// Save textures in DDS format (multiple mip-maps levels) to memory. Return true if succesful.
+// data_out is a return parameter for the allocated file data, free with free(); size_out
+// returns its size in bytes.
+bool detexSaveDDSMemoryWithMipmaps(detexTexture **textures, int nu_levels, uint8_t **data_out,
+size_t *size_out) {
+	detexOutputBuffer output = { NULL, 0, 0 };
+	if (!SaveDDSWithMipmaps(textures, nu_levels, detexWriteOutputBuffer, &output,
+	"detexSaveDDSMemoryWithMipmaps", NULL)) {
+		free(output.data);
+		return false;
+	}
+	*data_out = output.data;
+	*size_out = output.size;
 	return true;
 }
 
+// Save textures in DDS format (multiple mip-maps levels) to a stream. Return true if succesful.
+bool detexSaveDDSStreamWithMipmaps(detexTexture **textures, int nu_levels, detexWriteFunc write_func,
+void *user_data) {
+	return SaveDDSWithMipmaps(textures, nu_levels, write_func, user_data, "detexSaveDDSStreamWithMipmaps",
+		NULL);
+}
+
 // Save texture to DDS file (single mip-map level). Returns true if succesful.
 bool detexSaveDDSFile(detexTexture *texture, const char *filename) {
 	detexTexture *textures[1];
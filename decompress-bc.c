@@ -16,7 +16,10 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 */
 
+#include <string.h>
+
 #include "detex.h"
+#include "simd.h"
 
 /* Decompress a 64-bit 4x4 pixel texture block compressed using the BC1 */
 /* format. */
@@ -239,3 +242,356 @@ uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
 	return true;
 }
 
+
+// Batch decompression of consecutive BC1, BC1A, BC2 and BC3 blocks. The SIMD code paths
+// calculate the color palettes of four blocks at a time and expand the 2-bit color indices
+// of each block using vector selects (SSE2) or permutes (AVX2). The results are identical
+// to the single block functions above.
+
+enum {
+	BC_BATCH_TYPE_BC1,
+	BC_BATCH_TYPE_BC1A,
+	BC_BATCH_TYPE_BC2,
+	BC_BATCH_TYPE_BC3
+};
+
+// Calculate the eight-entry alpha palette of a BC3 block.
+static DETEX_INLINE_ONLY void CalculateAlphaPaletteBC3(int alpha0, int alpha1, uint8_t *palette) {
+	palette[0] = alpha0;
+	palette[1] = alpha1;
+	if (alpha0 > alpha1) {
+		for (int i = 2; i < 8; i++)
+			palette[i] = detexDivide0To1791By7((8 - i) * alpha0 + (i - 1) * alpha1);
+	}
+	else {
+		for (int i = 2; i < 6; i++)
+			palette[i] = detexDivide0To1279By5((6 - i) * alpha0 + (i - 1) * alpha1);
+		palette[6] = 0;
+		palette[7] = 0xFF;
+	}
+}
+
+#ifdef DETEX_USE_SSE2
+
+// Exact division by three of values in the range [0, 767] stored in 32-bit lanes,
+// calculated as (x * 0xAAAB) >> 17.
+static DETEX_INLINE_ONLY __m128i Divide0To767By3SSE2(__m128i x) {
+	return _mm_srli_epi32(_mm_mulhi_epu16(x, _mm_set1_epi32(0xAAAB)), 1);
+}
+
+static DETEX_INLINE_ONLY __m128i SelectSSE2(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Calculate the packed 32-bit color palettes of four consecutive blocks. palette_out[i]
+// holds the four palette entries of block i. BC1 and BC1A select the three-color mode per
+// block; BC2 and BC3 always use four colors and leave the alpha component zero.
+static DETEX_INLINE_ONLY void CalculateColorPalettesSSE2(const uint8_t * DETEX_RESTRICT bitstring,
+int block_size, int color_offset, int type, __m128i *palette_out) {
+	__m128i colors = _mm_setr_epi32(
+		*(uint32_t *)&bitstring[color_offset],
+		*(uint32_t *)&bitstring[block_size + color_offset],
+		*(uint32_t *)&bitstring[block_size * 2 + color_offset],
+		*(uint32_t *)&bitstring[block_size * 3 + color_offset]);
+	__m128i c0 = _mm_and_si128(colors, _mm_set1_epi32(0xFFFF));
+	__m128i c1 = _mm_srli_epi32(colors, 16);
+	__m128i r0 = _mm_srli_epi32(_mm_and_si128(c0, _mm_set1_epi32(0xF800)), 11 - 3);
+	__m128i g0 = _mm_srli_epi32(_mm_and_si128(c0, _mm_set1_epi32(0x07E0)), 5 - 2);
+	__m128i b0 = _mm_slli_epi32(_mm_and_si128(c0, _mm_set1_epi32(0x001F)), 3);
+	__m128i r1 = _mm_srli_epi32(_mm_and_si128(c1, _mm_set1_epi32(0xF800)), 11 - 3);
+	__m128i g1 = _mm_srli_epi32(_mm_and_si128(c1, _mm_set1_epi32(0x07E0)), 5 - 2);
+	__m128i b1 = _mm_slli_epi32(_mm_and_si128(c1, _mm_set1_epi32(0x001F)), 3);
+	__m128i r2 = Divide0To767By3SSE2(_mm_add_epi32(_mm_add_epi32(r0, r0), r1));
+	__m128i g2 = Divide0To767By3SSE2(_mm_add_epi32(_mm_add_epi32(g0, g0), g1));
+	__m128i b2 = Divide0To767By3SSE2(_mm_add_epi32(_mm_add_epi32(b0, b0), b1));
+	__m128i r3 = Divide0To767By3SSE2(_mm_add_epi32(_mm_add_epi32(r1, r1), r0));
+	__m128i g3 = Divide0To767By3SSE2(_mm_add_epi32(_mm_add_epi32(g1, g1), g0));
+	__m128i b3 = Divide0To767By3SSE2(_mm_add_epi32(_mm_add_epi32(b1, b1), b0));
+	__m128i p0 = _mm_or_si128(_mm_or_si128(r0, _mm_slli_epi32(g0, 8)), _mm_slli_epi32(b0, 16));
+	__m128i p1 = _mm_or_si128(_mm_or_si128(r1, _mm_slli_epi32(g1, 8)), _mm_slli_epi32(b1, 16));
+	__m128i p2 = _mm_or_si128(_mm_or_si128(r2, _mm_slli_epi32(g2, 8)), _mm_slli_epi32(b2, 16));
+	__m128i p3 = _mm_or_si128(_mm_or_si128(r3, _mm_slli_epi32(g3, 8)), _mm_slli_epi32(b3, 16));
+	if (type == BC_BATCH_TYPE_BC1 || type == BC_BATCH_TYPE_BC1A) {
+		__m128i opaque = _mm_cmpgt_epi32(c0, c1);
+		__m128i r2t = _mm_srli_epi32(_mm_add_epi32(r0, r1), 1);
+		__m128i g2t = _mm_srli_epi32(_mm_add_epi32(g0, g1), 1);
+		__m128i b2t = _mm_srli_epi32(_mm_add_epi32(b0, b1), 1);
+		__m128i p2t = _mm_or_si128(_mm_or_si128(r2t, _mm_slli_epi32(g2t, 8)), _mm_slli_epi32(b2t, 16));
+		p2 = SelectSSE2(opaque, p2, p2t);
+		p3 = _mm_and_si128(opaque, p3);
+		__m128i alpha = _mm_set1_epi32(0xFF000000);
+		p0 = _mm_or_si128(p0, alpha);
+		p1 = _mm_or_si128(p1, alpha);
+		p2 = _mm_or_si128(p2, alpha);
+		if (type == BC_BATCH_TYPE_BC1)
+			p3 = _mm_or_si128(p3, alpha);
+		else
+			p3 = _mm_or_si128(p3, _mm_and_si128(opaque, alpha));
+	}
+	// Transpose so that each vector holds the palette of one block.
+	__m128i t0 = _mm_unpacklo_epi32(p0, p1);
+	__m128i t1 = _mm_unpacklo_epi32(p2, p3);
+	__m128i t2 = _mm_unpackhi_epi32(p0, p1);
+	__m128i t3 = _mm_unpackhi_epi32(p2, p3);
+	palette_out[0] = _mm_unpacklo_epi64(t0, t1);
+	palette_out[1] = _mm_unpackhi_epi64(t0, t1);
+	palette_out[2] = _mm_unpacklo_epi64(t2, t3);
+	palette_out[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+// Calculate the alpha components of the 16 pixels of a BC2 or BC3 block, stored in the
+// top byte of each 32-bit lane of alpha_out[0] to alpha_out[3].
+static DETEX_INLINE_ONLY void CalculateAlphaSSE2(const uint8_t * DETEX_RESTRICT bitstring, int type,
+__m128i *alpha_out) {
+	__m128i alpha;
+	if (type == BC_BATCH_TYPE_BC2) {
+		__m128i a = _mm_loadl_epi64((__m128i *)bitstring);
+		__m128i nibble_mask = _mm_set1_epi8(0x0F);
+		__m128i nibbles = _mm_unpacklo_epi8(_mm_and_si128(a, nibble_mask),
+			_mm_and_si128(_mm_srli_epi16(a, 4), nibble_mask));
+		// Multiply by 255 / 15 = 17.
+		alpha = _mm_or_si128(nibbles, _mm_slli_epi16(nibbles, 4));
+	}
+	else {
+		uint8_t palette[8];
+		uint8_t alpha_values[16];
+		CalculateAlphaPaletteBC3(bitstring[0], bitstring[1], palette);
+		uint64_t alpha_bits = (uint32_t)bitstring[2] |
+			((uint32_t)bitstring[3] << 8) |
+			((uint64_t)*(uint32_t *)&bitstring[4] << 16);
+		for (int i = 0; i < 16; i++)
+			alpha_values[i] = palette[(alpha_bits >> (i * 3)) & 0x7];
+		alpha = _mm_loadu_si128((__m128i *)alpha_values);
+	}
+	__m128i zero = _mm_setzero_si128();
+	__m128i alpha16_lo = _mm_unpacklo_epi8(zero, alpha);
+	__m128i alpha16_hi = _mm_unpackhi_epi8(zero, alpha);
+	alpha_out[0] = _mm_unpacklo_epi16(zero, alpha16_lo);
+	alpha_out[1] = _mm_unpackhi_epi16(zero, alpha16_lo);
+	alpha_out[2] = _mm_unpacklo_epi16(zero, alpha16_hi);
+	alpha_out[3] = _mm_unpackhi_epi16(zero, alpha16_hi);
+}
+
+// Expand the 2-bit color indices of a block using the block's palette, combining with
+// the alpha components when present, and store the 16 pixels.
+static DETEX_INLINE_ONLY void ExpandColorIndicesSSE2(__m128i palette, uint32_t pixels,
+const __m128i *alpha, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	__m128i entry0 = _mm_shuffle_epi32(palette, 0x00);
+	__m128i entry1 = _mm_shuffle_epi32(palette, 0x55);
+	__m128i entry2 = _mm_shuffle_epi32(palette, 0xAA);
+	__m128i entry3 = _mm_shuffle_epi32(palette, 0xFF);
+	__m128i lane_mask = _mm_setr_epi32(0x03, 0x0C, 0x30, 0xC0);
+	__m128i index1 = _mm_setr_epi32(0x01, 0x04, 0x10, 0x40);
+	__m128i index2 = _mm_setr_epi32(0x02, 0x08, 0x20, 0x80);
+	for (int i = 0; i < 4; i++) {
+		__m128i index = _mm_and_si128(_mm_set1_epi32(pixels >> (i * 8)), lane_mask);
+		__m128i p = _mm_or_si128(
+			_mm_or_si128(
+				_mm_and_si128(_mm_cmpeq_epi32(index, _mm_setzero_si128()), entry0),
+				_mm_and_si128(_mm_cmpeq_epi32(index, index1), entry1)),
+			_mm_or_si128(
+				_mm_and_si128(_mm_cmpeq_epi32(index, index2), entry2),
+				_mm_and_si128(_mm_cmpeq_epi32(index, lane_mask), entry3)));
+		if (alpha != NULL)
+			p = _mm_or_si128(p, alpha[i]);
+		_mm_storeu_si128((__m128i *)(pixel_buffer + i * 16), p);
+	}
+}
+
+// Decompress groups of four blocks. Returns the number of blocks decompressed.
+static int DecompressBlocksBCSSE2(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int block_size = (type == BC_BATCH_TYPE_BC2 || type == BC_BATCH_TYPE_BC3) ? 16 : 8;
+	int color_offset = block_size - 8;
+	int i;
+	for (i = 0; i + 4 <= nu_blocks; i += 4) {
+		__m128i palette[4];
+		CalculateColorPalettesSSE2(bitstring, block_size, color_offset, type, palette);
+		for (int j = 0; j < 4; j++) {
+			uint32_t pixels = *(uint32_t *)&bitstring[color_offset + 4];
+			if (block_size == 16) {
+				__m128i alpha[4];
+				CalculateAlphaSSE2(bitstring, type, alpha);
+				ExpandColorIndicesSSE2(palette[j], pixels, alpha, pixel_buffer);
+			}
+			else
+				ExpandColorIndicesSSE2(palette[j], pixels, NULL, pixel_buffer);
+			bitstring += block_size;
+			pixel_buffer += 64;
+		}
+	}
+	return i;
+}
+
+#endif
+
+#ifdef DETEX_USE_AVX2
+
+// Expand the 2-bit color indices of a block using the block's palette with two
+// eight-lane permutes, combining with the alpha components, and store the 16 pixels.
+static DETEX_INLINE_ONLY DETEX_TARGET_AVX2 void ExpandColorIndicesAVX2(__m128i palette, uint32_t pixels,
+__m256i alpha0, __m256i alpha1, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	__m256i palette256 = _mm256_broadcastsi128_si256(palette);
+	__m256i index = _mm256_set1_epi32(pixels);
+	__m256i three = _mm256_set1_epi32(0x3);
+	__m256i index0 = _mm256_and_si256(_mm256_srlv_epi32(index,
+		_mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14)), three);
+	__m256i index1 = _mm256_and_si256(_mm256_srlv_epi32(index,
+		_mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30)), three);
+	_mm256_storeu_si256((__m256i *)pixel_buffer,
+		_mm256_or_si256(_mm256_permutevar8x32_epi32(palette256, index0), alpha0));
+	_mm256_storeu_si256((__m256i *)(pixel_buffer + 32),
+		_mm256_or_si256(_mm256_permutevar8x32_epi32(palette256, index1), alpha1));
+}
+
+// Calculate the alpha components of the 16 pixels of a BC2 or BC3 block, stored in the
+// top byte of each 32-bit lane of alpha0_out (pixels 0 to 7) and alpha1_out (pixels 8 to 15).
+static DETEX_INLINE_ONLY DETEX_TARGET_AVX2 void CalculateAlphaAVX2(const uint8_t * DETEX_RESTRICT bitstring,
+int type, __m256i *alpha0_out, __m256i *alpha1_out) {
+	if (type == BC_BATCH_TYPE_BC2) {
+		uint64_t alpha_pixels = *(uint64_t *)&bitstring[0];
+		__m256i shift = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+		__m256i mask = _mm256_set1_epi32(0xF);
+		__m256i a0 = _mm256_and_si256(_mm256_srlv_epi32(
+			_mm256_set1_epi32((uint32_t)alpha_pixels), shift), mask);
+		__m256i a1 = _mm256_and_si256(_mm256_srlv_epi32(
+			_mm256_set1_epi32((uint32_t)(alpha_pixels >> 32)), shift), mask);
+		// Multiply by 255 / 15 = 17 and shift into the top byte.
+		*alpha0_out = _mm256_or_si256(_mm256_slli_epi32(a0, 24), _mm256_slli_epi32(a0, 28));
+		*alpha1_out = _mm256_or_si256(_mm256_slli_epi32(a1, 24), _mm256_slli_epi32(a1, 28));
+	}
+	else {
+		uint8_t palette[8];
+		CalculateAlphaPaletteBC3(bitstring[0], bitstring[1], palette);
+		__m256i palette256 = _mm256_slli_epi32(_mm256_cvtepu8_epi32(
+			_mm_loadl_epi64((__m128i *)palette)), 24);
+		uint64_t alpha_bits = (uint32_t)bitstring[2] |
+			((uint32_t)bitstring[3] << 8) |
+			((uint64_t)*(uint32_t *)&bitstring[4] << 16);
+		__m256i shift = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+		__m256i mask = _mm256_set1_epi32(0x7);
+		__m256i index0 = _mm256_and_si256(_mm256_srlv_epi32(
+			_mm256_set1_epi32((uint32_t)alpha_bits), shift), mask);
+		__m256i index1 = _mm256_and_si256(_mm256_srlv_epi32(
+			_mm256_set1_epi32((uint32_t)(alpha_bits >> 24)), shift), mask);
+		*alpha0_out = _mm256_permutevar8x32_epi32(palette256, index0);
+		*alpha1_out = _mm256_permutevar8x32_epi32(palette256, index1);
+	}
+}
+
+// Decompress groups of four blocks. Returns the number of blocks decompressed.
+static DETEX_TARGET_AVX2 int DecompressBlocksBCAVX2(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int block_size = (type == BC_BATCH_TYPE_BC2 || type == BC_BATCH_TYPE_BC3) ? 16 : 8;
+	int color_offset = block_size - 8;
+	int i;
+	for (i = 0; i + 4 <= nu_blocks; i += 4) {
+		__m128i palette[4];
+		CalculateColorPalettesSSE2(bitstring, block_size, color_offset, type, palette);
+		for (int j = 0; j < 4; j++) {
+			uint32_t pixels = *(uint32_t *)&bitstring[color_offset + 4];
+			__m256i alpha0 = _mm256_setzero_si256();
+			__m256i alpha1 = _mm256_setzero_si256();
+			if (block_size == 16)
+				CalculateAlphaAVX2(bitstring, type, &alpha0, &alpha1);
+			ExpandColorIndicesAVX2(palette[j], pixels, alpha0, alpha1, pixel_buffer);
+			bitstring += block_size;
+			pixel_buffer += 64;
+		}
+	}
+	return i;
+}
+
+#endif
+
+// Without SIMD, all blocks are decompressed by the scalar code.
+static int DecompressBlocksBCNone(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return 0;
+}
+
+DETEX_DEFINE_KERNEL(DecompressBlocksBCKernel, int, (const uint8_t * DETEX_RESTRICT bitstring,
+	int nu_blocks, int type, uint8_t * DETEX_RESTRICT pixel_buffer),
+	(bitstring, nu_blocks, type, pixel_buffer))
+
+void detexSelectBCKernels(int level) {
+	int (*kernel)(const uint8_t * DETEX_RESTRICT, int, int, uint8_t * DETEX_RESTRICT) =
+		DecompressBlocksBCNone;
+#ifdef DETEX_USE_SSE2
+	if (level >= DETEX_SIMD_LEVEL_SSE2)
+		kernel = DecompressBlocksBCSSE2;
+#endif
+#ifdef DETEX_USE_AVX2
+	if (level >= DETEX_SIMD_LEVEL_AVX2)
+		kernel = DecompressBlocksBCAVX2;
+#endif
+	DETEX_SET_KERNEL(DecompressBlocksBCKernel, kernel);
+}
+
+static bool DecompressBlocksBC(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer, int type) {
+	int block_size = (type == BC_BATCH_TYPE_BC2 || type == BC_BATCH_TYPE_BC3) ? 16 : 8;
+	int i = 0;
+	// The SIMD code paths do not handle the flags that can reject blocks.
+	if (flags == 0)
+		i = DETEX_GET_KERNEL(DecompressBlocksBCKernel)(bitstring, nu_blocks, type, pixel_buffer);
+	bool result = true;
+	for (; i < nu_blocks; i++) {
+		bool r;
+		switch (type) {
+		case BC_BATCH_TYPE_BC1 :
+			r = detexDecompressBlockBC1(bitstring + i * block_size, mode_mask, flags,
+				pixel_buffer + i * 64);
+			break;
+		case BC_BATCH_TYPE_BC1A :
+			r = detexDecompressBlockBC1A(bitstring + i * block_size, mode_mask, flags,
+				pixel_buffer + i * 64);
+			break;
+		case BC_BATCH_TYPE_BC2 :
+			r = detexDecompressBlockBC2(bitstring + i * block_size, mode_mask, flags,
+				pixel_buffer + i * 64);
+			break;
+		default :
+			r = detexDecompressBlockBC3(bitstring + i * block_size, mode_mask, flags,
+				pixel_buffer + i * 64);
+			break;
+		}
+		if (!r) {
+			result = false;
+			memset(pixel_buffer + i * 64, 0, 64);
+		}
+	}
+	return result;
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the BC1 */
+/* format. */
+bool detexDecompressBlocksBC1(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksBC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		BC_BATCH_TYPE_BC1);
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the BC1A */
+/* format. */
+bool detexDecompressBlocksBC1A(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksBC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		BC_BATCH_TYPE_BC1A);
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the BC2 */
+/* format. */
+bool detexDecompressBlocksBC2(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksBC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		BC_BATCH_TYPE_BC2);
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the BC3 */
+/* format. */
+bool detexDecompressBlocksBC3(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksBC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		BC_BATCH_TYPE_BC3);
+}
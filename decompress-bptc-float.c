@@ -16,6 +16,8 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 */
 
+#include <string.h>
+
 #include "detex.h"
 #include "bits.h"
 #include "bptc-tables.h"
@@ -25,14 +27,45 @@ static const int8_t map_mode_table[32] = {
 	-1, -1, 6, -1, -1, -1, 7, -1, -1, -1, 8, -1, -1, -1, 9, -1
 };
 
-static int ExtractMode(detexBlock128 *block) {
-	uint32_t mode = detexBlock128ExtractBits(block, 2);
-	if (mode < 2)
-		return mode;
-	return map_mode_table[mode | (detexBlock128ExtractBits(block, 3) << 2)];
+static DETEX_INLINE_ONLY int ExtractMode(const detexBlock128 *block) {
+	// Modes with a two-bit mode field (0 and 1) have bit 1 clear, the others are
+	// identified by five bits.
+	uint32_t mode = block->data0 & 0x1F;
+	if ((mode & 2) == 0)
+		return mode & 1;
+	return map_mode_table[mode];
 }
 
-static int GetPartitionIndex(int nu_subsets, int partition_set_id, int i) {
+// Precomputed layout parameters of each mode. The endpoint bit layout differs too much
+// between modes and is extracted per mode.
+typedef struct {
+	uint8_t nu_subsets;
+	uint8_t transformed;		// Endpoints other than the first are deltas.
+	uint8_t delta_bits_r;
+	uint8_t delta_bits_g;
+	uint8_t delta_bits_b;
+	uint8_t index_bits;
+	uint8_t index_offset;
+} BPTCFloatModeLayout;
+
+static const BPTCFloatModeLayout bptc_float_mode_layout[14] = {
+	{ 2, 1, 5, 5, 5, 3, 82 },
+	{ 2, 1, 6, 6, 6, 3, 82 },
+	{ 2, 1, 5, 4, 4, 3, 82 },
+	{ 2, 1, 4, 5, 4, 3, 82 },
+	{ 2, 1, 4, 4, 5, 3, 82 },
+	{ 2, 1, 5, 5, 5, 3, 82 },
+	{ 2, 1, 6, 5, 5, 3, 82 },
+	{ 2, 1, 5, 6, 5, 3, 82 },
+	{ 2, 1, 5, 5, 6, 3, 82 },
+	{ 2, 0, 6, 6, 6, 3, 82 },
+	{ 1, 0, 10, 10, 10, 4, 65 },
+	{ 1, 1, 9, 9, 9, 4, 65 },
+	{ 1, 1, 8, 8, 8, 4, 65 },
+	{ 1, 1, 4, 4, 4, 4, 65 },
+};
+
+static DETEX_INLINE_ONLY int GetPartitionIndex(int nu_subsets, int partition_set_id, int i) {
 	if (nu_subsets == 1)
 		return 0;
 	// nu_subset == 2
@@ -49,7 +82,7 @@ static DETEX_INLINE_ONLY int GetAnchorIndex(int partition_set_id, int partition,
 	return detex_bptc_table_anchor_index_second_subset[partition_set_id];
 }
 
-static uint32_t Unquantize(uint16_t x, int mode) {
+static DETEX_INLINE_ONLY uint32_t Unquantize(uint16_t x, int mode) {
 	int32_t unq;
 	if (mode == 13)
 		unq = x;
@@ -62,7 +95,7 @@ static uint32_t Unquantize(uint16_t x, int mode) {
 	return unq;
 }
 
-static int32_t UnquantizeSigned(int16_t x, int mode) {
+static DETEX_INLINE_ONLY int32_t UnquantizeSigned(int16_t x, int mode) {
 	int s = 0;
 	int32_t unq;
 	if (bptc_float_EPB[mode] >= 16)
@@ -85,7 +118,7 @@ static int32_t UnquantizeSigned(int16_t x, int mode) {
 	return unq;
 }
 
-static int SignExtend(int value, int source_nu_bits, int target_nu_bits) {
+static DETEX_INLINE_ONLY int SignExtend(int value, int source_nu_bits, int target_nu_bits) {
 	uint32_t sign_bit = value & (1 << (source_nu_bits - 1));
 	if (!sign_bit)
 		return value;
@@ -94,7 +127,7 @@ static int SignExtend(int value, int source_nu_bits, int target_nu_bits) {
 	return value | sign_extend_bits;
 }
 
-static int32_t InterpolateFloat(int32_t e0, int32_t e1, int16_t index, uint8_t indexprecision) {
+static DETEX_INLINE_ONLY int32_t InterpolateFloat(int32_t e0, int32_t e1, int16_t index, uint8_t indexprecision) {
 	if (indexprecision == 2)
 		return (((64 - detex_bptc_table_aWeight2[index]) * e0
 			+ detex_bptc_table_aWeight2[index] * e1 + 32) >> 6);
@@ -107,24 +140,15 @@ static int32_t InterpolateFloat(int32_t e0, int32_t e1, int16_t index, uint8_t i
 			+ detex_bptc_table_aWeight4[index] * e1 + 32) >> 6);
 }
 
-static bool DecompressBlockBPTCFloatShared(const uint8_t * DETEX_RESTRICT bitstring,
-uint32_t mode_mask, uint32_t flags, bool signed_flag,
-const uint8_t * DETEX_RESTRICT pixel_buffer) {
-	detexBlock128 block;
-	block.data0 = *(uint64_t *)&bitstring[0];
-	block.data1 = *(uint64_t *)&bitstring[8];
-	block.index = 0;
-	uint32_t mode = ExtractMode(&block);
-	if (mode == - 1)
-		return false;
-	// Allow compression tied to specific modes (according to mode_mask).
-	if (!(mode_mask & ((int)1 << mode)))
-		return false;
+// Decompress a block of the given mode. When inlined with a constant mode and signed_flag,
+// the endpoint bit layout and mode parameters are folded into constants.
+static DETEX_INLINE_ONLY void DecompressBlockBPTCFloatMode(const detexBlock128 * DETEX_RESTRICT block,
+int mode, bool signed_flag, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	const BPTCFloatModeLayout *layout = &bptc_float_mode_layout[mode];
 	int32_t r[4], g[4], b[4];
 	int partition_set_id = 0;
-	int delta_bits_r, delta_bits_g, delta_bits_b;
-	uint64_t data0 = block.data0;
-	uint64_t data1 = block.data1;
+	uint64_t data0 = block->data0;
+	uint64_t data1 = block->data1;
 	switch (mode) {
 	case 0 :
 		// m[1:0],g2[4],b2[4],b3[4],r0[9:0],g0[9:0],b0[9:0],r1[4:0],g3[4],g2[3:0],
@@ -150,8 +174,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		r[3] = detexGetBits64(data1, 7, 11);
 		b[3] |= detexGetBits64(data1, 12, 12) << 3;
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = delta_bits_g = delta_bits_b = 5;
 		break;
 	case 1 :
 		// m[1:0],g2[5],g3[4],g3[5],r0[6:0],b3[0],b3[1],b2[4],g0[6:0],b2[5],b3[2],
@@ -182,8 +204,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		r[2] = detexGetBits64(data1, 1, 6);
 		r[3] = detexGetBits64(data1, 7, 12);
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = delta_bits_g = delta_bits_b = 6;
 		break;
 	case 2 :
 		// m[4:0],r0[9:0],g0[9:0],b0[9:0],r1[4:0],r0[10],g2[3:0],g1[3:0],g0[10],
@@ -208,9 +228,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		r[3] = detexGetBits64(data1, 7, 11);
 		b[3] |= detexGetBits64(data1, 12, 12) << 3;
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = 5;
-		delta_bits_g = delta_bits_b = 4;
 		break;
 	case 3 :	// Original mode 6.
 		// m[4:0],r0[9:0],g0[9:0],b0[9:0],r1[3:0],r0[10],g3[4],g2[3:0],g1[4:0],
@@ -238,9 +255,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		g[2] |= detexGetBits64(data1, 11, 11) << 4;
 		b[3] |= detexGetBits64(data1, 12, 12) << 3;
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = delta_bits_b = 4;
-		delta_bits_g = 5;
 		break;
 	case 4 :	// Original mode 10.
 		// m[4:0],r0[9:0],g0[9:0],b0[9:0],r1[3:0],r0[10],b2[4],g2[3:0],g1[3:0],
@@ -268,9 +282,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		b[3] |= detexGetBits64(data1, 11, 11) << 4;
 		b[3] |= detexGetBits64(data1, 12, 12) << 3;
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = delta_bits_g = 4;
-		delta_bits_b = 5;
 		break;
 	case 5 :	// Original mode 14
 		// m[4:0],r0[8:0],b2[4],g0[8:0],g2[4],b0[8:0],b3[4],r1[4:0],g3[4],g2[3:0],
@@ -296,8 +307,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		r[3] = detexGetBits64(data1, 7, 11);
 		b[3] |= detexGetBits64(data1, 12, 12) << 3;
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = delta_bits_g = delta_bits_b = 5;
 		break;
 	case 6 :	// Original mode 18
 		// m[4:0],r0[7:0],g3[4],b2[4],g0[7:0],b3[2],g2[4],b0[7:0],b3[3],b3[4],
@@ -323,9 +332,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		r[2] = detexGetBits64(data1, 1, 6);
 		r[3] = detexGetBits64(data1, 7, 12);
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = 6;
-		delta_bits_g = delta_bits_b = 5;
 		break;
 	case 7 :	// Original mode 22
 		// m[4:0],r0[7:0],b3[0],b2[4],g0[7:0],g2[5],g2[4],b0[7:0],g3[5],b3[4],
@@ -354,9 +360,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		r[3] = detexGetBits64(data1, 7, 11);
 		b[3] |= detexGetBits64(data1, 12, 12) << 3;
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = delta_bits_b = 5;
-		delta_bits_g = 6;
 		break;
 	case 8 :	// Original mode 26
 		// m[4:0],r0[7:0],b3[1],b2[4],g0[7:0],b2[5],g2[4],b0[7:0],b3[5],b3[4],
@@ -385,9 +388,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		r[3] = detexGetBits64(data1, 7, 11);
 		b[3] |= detexGetBits64(data1, 12, 12) << 3;
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-		delta_bits_r = delta_bits_g = 5;
-		delta_bits_b = 6;
 		break;
 	case 9 :	// Original mode 30
 		// m[4:0],r0[5:0],g3[4],b3[0],b3[1],b2[4],g0[5:0],g2[5],b2[5],b3[2],
@@ -417,8 +417,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		r[2] = detexGetBits64(data1, 1, 6);
 		r[3] = detexGetBits64(data1, 7, 12);
 		partition_set_id = detexGetBits64(data1, 13, 17);
-		block.index = 64 + 18;
-//		delta_bits_r = delta_bits_g = delta_bits_b = 6;
 		break;
 	case 10 :	// Original mode 3
 		// m[4:0],r0[9:0],g0[9:0],b0[9:0],r1[9:0],g1[9:0],b1[9:0]
@@ -430,8 +428,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		b[1] = detexGetBits64(data0, 55, 63);
 		b[1] |= detexGetBits64(data1, 0, 0) << 9;
 		partition_set_id = 0;
-		block.index = 65;
-//		delta_bits_r = delta_bits_g = delta_bits_b = 10;
 		break;
 	case 11 :	// Original mode 7
 		// m[4:0],r0[9:0],g0[9:0],b0[9:0],r1[8:0],r0[10],g1[8:0],g0[10],b1[8:0],b0[10]
@@ -445,8 +441,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		b[1] = detexGetBits64(data0, 55, 63);
 		b[0] |= detexGetBits64(data1, 0, 0) << 10;
 		partition_set_id = 0;
-		block.index = 65;
-		delta_bits_r = delta_bits_g = delta_bits_b = 9;
 		break;
 	case 12 :	// Original mode 11
 		// m[4:0],r0[9:0],g0[9:0],b0[9:0],r1[7:0],r0[10:11],g1[7:0],g0[10:11],
@@ -462,8 +456,6 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		b[0] |= detexGetBits64(data0, 63, 63) << 11;	// MSB
 		b[0] |= detexGetBits64(data1, 0, 0) << 10;	// LSB
 		partition_set_id = 0;
-		block.index = 65;
-		delta_bits_r = delta_bits_g = delta_bits_b = 8;
 		break;
 	case 13 :	// Original mode 15
 		// m[4:0],r0[9:0],g0[9:0],b0[9:0],r1[3:0],r0[10:15],g1[3:0],g0[10:15],
@@ -479,28 +471,22 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		b[0] |= detexGetBits64Reversed(data0, 63, 59) << 11;	// Reversed.
 		b[0] |= detexGetBits64(data1, 0, 0) << 10;
 		partition_set_id = 0;
-		block.index = 65;
-		delta_bits_r = delta_bits_g = delta_bits_b = 4;
 		break;
 	}
-	int nu_subsets;
-	if (mode >= 10)
-		nu_subsets = 1;
-	else
-		nu_subsets = 2;
+	int nu_subsets = layout->nu_subsets;
 	if (signed_flag) {
 		r[0] = SignExtend(r[0], bptc_float_EPB[mode], 32);
 		g[0] = SignExtend(g[0], bptc_float_EPB[mode], 32);
 		b[0] = SignExtend(b[0], bptc_float_EPB[mode], 32);
 	}
-	if (mode != 9 && mode != 10) {
+	if (layout->transformed) {
 		// Transformed endpoints.
 		for (int i = 1; i < nu_subsets * 2; i++) {
-			r[i] = SignExtend(r[i], delta_bits_r, 32);
+			r[i] = SignExtend(r[i], layout->delta_bits_r, 32);
 			r[i] = (r[0] + r[i]) & (((uint32_t)1 << bptc_float_EPB[mode]) - 1);
-			g[i] = SignExtend(g[i], delta_bits_g, 32);
+			g[i] = SignExtend(g[i], layout->delta_bits_g, 32);
 			g[i] = (g[0] + g[i]) & (((uint32_t)1 << bptc_float_EPB[mode]) - 1);
-			b[i] = SignExtend(b[i], delta_bits_b, 32);
+			b[i] = SignExtend(b[i], layout->delta_bits_b, 32);
 			b[i] = (b[0] + b[i]) & (((uint32_t)1 << bptc_float_EPB[mode]) - 1);
 			if (signed_flag) {
 				r[i] = SignExtend(r[i], bptc_float_EPB[mode], 32);
@@ -540,27 +526,15 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 	for (int i = 0; i < nu_subsets; i++)
 		anchor_index[i] = GetAnchorIndex(partition_set_id, i, nu_subsets);
 	uint8_t color_index[16];
-	// Extract index bits.
-	int color_index_bit_count = 3;
-	if ((bitstring[0] & 3) == 3)	// This defines original modes 3, 7, 11, 15
-		color_index_bit_count = 4;
-	// Because the index bits are all in the second 64-bit word, there is no need to use
-	// block_extract_bits().
-	data1 >>= (block.index - 64);
-	uint8_t mask1 = (1 << color_index_bit_count) - 1;
-	uint8_t mask2 = (1 << (color_index_bit_count - 1)) - 1;
+	// Extract index bits. The index bits of all modes (at most 63) are extracted at once.
+	int color_index_bit_count = layout->index_bits;
+	uint64_t index_data = detexBlock128GetBits(block, layout->index_offset,
+		16 * color_index_bit_count - nu_subsets);
 	for (int i = 0; i < 16; i++) {
-		if (i == anchor_index[subset_index[i]]) {
-			// Highest bit is zero.
-//			color_index[i] = block_extract_bits(&block, color_index_bit_count - 1);
-			color_index[i] = data1 & mask2;
-			data1 >>= color_index_bit_count - 1;
-		}
-		else {
-//			color_index[i] = block_extract_bits(&block, color_index_bit_count);
-			color_index[i] = data1 & mask1;	
-			data1 >>= color_index_bit_count;
-		}
+		// The index at the anchor of each subset has its highest bit zero.
+		int n = color_index_bit_count - (i == anchor_index[subset_index[i]]);
+		color_index[i] = index_data & ((1 << n) - 1);
+		index_data >>= n;
 	}
 
 	for (int i = 0; i < 16; i++) {
@@ -622,6 +596,69 @@ const uint8_t * DETEX_RESTRICT pixel_buffer) {
 		}
 		*(uint64_t *)&pixel_buffer[i * 8] = output;
 	}
+}
+
+// Generate specialized unsigned and signed decoders for each mode.
+#define BPTC_FLOAT_MODE_DECODER(mode) \
+	static void DecompressBlockBPTCFloatMode##mode(const detexBlock128 * DETEX_RESTRICT block, \
+	uint8_t * DETEX_RESTRICT pixel_buffer) { \
+		DecompressBlockBPTCFloatMode(block, mode, false, pixel_buffer); \
+	} \
+	static void DecompressBlockBPTCSignedFloatMode##mode(const detexBlock128 * DETEX_RESTRICT block, \
+	uint8_t * DETEX_RESTRICT pixel_buffer) { \
+		DecompressBlockBPTCFloatMode(block, mode, true, pixel_buffer); \
+	}
+
+BPTC_FLOAT_MODE_DECODER(0)
+BPTC_FLOAT_MODE_DECODER(1)
+BPTC_FLOAT_MODE_DECODER(2)
+BPTC_FLOAT_MODE_DECODER(3)
+BPTC_FLOAT_MODE_DECODER(4)
+BPTC_FLOAT_MODE_DECODER(5)
+BPTC_FLOAT_MODE_DECODER(6)
+BPTC_FLOAT_MODE_DECODER(7)
+BPTC_FLOAT_MODE_DECODER(8)
+BPTC_FLOAT_MODE_DECODER(9)
+BPTC_FLOAT_MODE_DECODER(10)
+BPTC_FLOAT_MODE_DECODER(11)
+BPTC_FLOAT_MODE_DECODER(12)
+BPTC_FLOAT_MODE_DECODER(13)
+
+typedef void (*DecompressBlockBPTCFloatModeFunc)(const detexBlock128 * DETEX_RESTRICT block,
+	uint8_t * DETEX_RESTRICT pixel_buffer);
+
+static const DecompressBlockBPTCFloatModeFunc decompress_block_bptc_float_mode[2][14] = {
+	{
+	DecompressBlockBPTCFloatMode0, DecompressBlockBPTCFloatMode1, DecompressBlockBPTCFloatMode2,
+	DecompressBlockBPTCFloatMode3, DecompressBlockBPTCFloatMode4, DecompressBlockBPTCFloatMode5,
+	DecompressBlockBPTCFloatMode6, DecompressBlockBPTCFloatMode7, DecompressBlockBPTCFloatMode8,
+	DecompressBlockBPTCFloatMode9, DecompressBlockBPTCFloatMode10, DecompressBlockBPTCFloatMode11,
+	DecompressBlockBPTCFloatMode12, DecompressBlockBPTCFloatMode13
+	},
+	{
+	DecompressBlockBPTCSignedFloatMode0, DecompressBlockBPTCSignedFloatMode1,
+	DecompressBlockBPTCSignedFloatMode2, DecompressBlockBPTCSignedFloatMode3,
+	DecompressBlockBPTCSignedFloatMode4, DecompressBlockBPTCSignedFloatMode5,
+	DecompressBlockBPTCSignedFloatMode6, DecompressBlockBPTCSignedFloatMode7,
+	DecompressBlockBPTCSignedFloatMode8, DecompressBlockBPTCSignedFloatMode9,
+	DecompressBlockBPTCSignedFloatMode10, DecompressBlockBPTCSignedFloatMode11,
+	DecompressBlockBPTCSignedFloatMode12, DecompressBlockBPTCSignedFloatMode13
+	}
+};
+
+static DETEX_INLINE_ONLY bool DecompressBlockBPTCFloatShared(const uint8_t * DETEX_RESTRICT bitstring,
+uint32_t mode_mask, uint32_t flags, bool signed_flag, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	detexBlock128 block;
+	block.data0 = *(uint64_t *)&bitstring[0];
+	block.data1 = *(uint64_t *)&bitstring[8];
+	block.index = 0;
+	int mode = ExtractMode(&block);
+	if (mode == - 1)
+		return false;
+	// Allow compression tied to specific modes (according to mode_mask).
+	if (!(mode_mask & ((int)1 << mode)))
+		return false;
+	decompress_block_bptc_float_mode[signed_flag][mode](&block, pixel_buffer);
 	return true;
 }
 
@@ -643,6 +680,34 @@ uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
 		pixel_buffer);
 }
 
+static bool DecompressBlocksBPTCFloatShared(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, bool signed_flag, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	bool result = true;
+	for (int i = 0; i < nu_blocks; i++)
+		if (!DecompressBlockBPTCFloatShared(bitstring + i * 16, mode_mask, flags, signed_flag,
+		pixel_buffer + i * 128)) {
+			result = false;
+			memset(pixel_buffer + i * 128, 0, 128);
+		}
+	return result;
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the */
+/* BPTC_FLOAT (BC6H) format. */
+bool detexDecompressBlocksBPTC_FLOAT(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksBPTCFloatShared(bitstring, nu_blocks, mode_mask, flags, false,
+		pixel_buffer);
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the */
+/* BPTC_FLOAT (BC6H_FLOAT) format. */
+bool detexDecompressBlocksBPTC_SIGNED_FLOAT(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksBPTCFloatShared(bitstring, nu_blocks, mode_mask, flags, true,
+		pixel_buffer);
+}
+
 /* Return the internal mode of the BPTC_FLOAT block. */
 uint32_t detexGetModeBPTC_FLOAT(const uint8_t *bitstring) {
 	detexBlock128 block;
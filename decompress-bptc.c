@@ -42,149 +42,99 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 //     For formats with alpha, the number of index bits is reduced by 2 * #subsets by the anchor bits.
 
 
-static const uint8_t color_precision_table[8] = { 4, 6, 5, 7, 5, 7, 7, 5 };
-
-// Note: precision includes P-bits!
-static const uint8_t color_precision_plus_pbit_table[8] = { 5, 7, 5, 8, 5, 7, 8, 6 };
-
-static DETEX_INLINE_ONLY uint8_t GetColorComponentPrecision(int mode) {
-	return color_precision_table[mode];
-}
-
-static DETEX_INLINE_ONLY uint8_t GetColorComponentPrecisionPlusPbit(int mode) {
-	return color_precision_plus_pbit_table[mode];
-}
-
-static const int8_t alpha_precision_table[8] = { 0, 0, 0, 0, 6, 8, 7, 5 };
-
-// Note: precision include P-bits!
-static const uint8_t alpha_precision_plus_pbit_table[8] = { 0, 0, 0, 0, 6, 8, 8, 6 };
-
-static DETEX_INLINE_ONLY uint8_t GetAlphaComponentPrecision(int mode) {
-	return alpha_precision_table[mode];
-}
-
-static DETEX_INLINE_ONLY uint8_t GetAlphaComponentPrecisionPlusPbit(int mode) {
-	return alpha_precision_plus_pbit_table[mode];
-}
-
-static const int8_t components_in_qword0_table[8] = { 2, -1, 1, 1, 3, 3, 3, 2 };
-
-/* Extract endpoint colors. */
-static void ExtractEndpoints(int mode, int nu_subsets, detexBlock128 * DETEX_RESTRICT block,
+// Precomputed field layout of each mode. Bit offsets are relative to the start of the
+// 128-bit block; the partition set ID and rotation fields directly follow the mode bits.
+typedef struct {
+	unsigned int nu_subsets : 2;	// 1 to 3.
+	uint8_t partition_bits;
+	uint8_t rotation_bits;
+	uint8_t index_selection_bits;
+	uint8_t color_precision;	// Excluding P-bits.
+	uint8_t alpha_precision;	// Excluding P-bits, zero when there is no alpha.
+	uint8_t pbit_type;
+	uint8_t index_bits;		// Primary index bits (color and alpha).
+	uint8_t secondary_index_bits;	// Zero when there is no separate (alpha) index.
+	uint8_t endpoint_offset;
+	uint8_t pbit_offset;
+	uint8_t index_offset;
+	uint8_t secondary_index_offset;
+} BPTCModeLayout;
+
+enum {
+	BPTC_PBITS_NONE,
+	BPTC_PBITS_PER_ENDPOINT,
+	BPTC_PBITS_PER_SUBSET
+};
+
+static const BPTCModeLayout bptc_mode_layout[8] = {
+	{ 3, 4, 0, 0, 4, 0, BPTC_PBITS_PER_ENDPOINT, 3, 0, 5, 77, 83, 0 },
+	{ 2, 6, 0, 0, 6, 0, BPTC_PBITS_PER_SUBSET, 3, 0, 8, 80, 82, 0 },
+	{ 3, 6, 0, 0, 5, 0, BPTC_PBITS_NONE, 2, 0, 9, 0, 99, 0 },
+	{ 2, 6, 0, 0, 7, 0, BPTC_PBITS_PER_ENDPOINT, 2, 0, 10, 94, 98, 0 },
+	{ 1, 0, 2, 1, 5, 6, BPTC_PBITS_NONE, 2, 3, 8, 0, 50, 81 },
+	{ 1, 0, 2, 0, 7, 8, BPTC_PBITS_NONE, 2, 2, 8, 0, 66, 97 },
+	{ 1, 0, 0, 0, 7, 7, BPTC_PBITS_PER_ENDPOINT, 4, 0, 7, 63, 65, 0 },
+	{ 2, 6, 0, 0, 5, 5, BPTC_PBITS_PER_ENDPOINT, 2, 0, 14, 94, 98, 0 },
+};
+
+/* Extract endpoint colors and fully decode them to 8-bit components. */
+static DETEX_INLINE_ONLY void DecodeEndpoints(const detexBlock128 * DETEX_RESTRICT block, const BPTCModeLayout *layout,
 uint8_t * DETEX_RESTRICT endpoint_array) {
-	// Optimized version avoiding the use of block_extract_bits().
-	int components_in_qword0 = components_in_qword0_table[mode];
-	uint64_t data = block->data0 >> block->index;
-	uint8_t precision = GetColorComponentPrecision(mode);
-	uint8_t mask = (1 << precision) - 1;
-	int total_bits_per_component = nu_subsets * 2 * precision;
-	for (int i = 0; i < components_in_qword0; i++)	// For each color component.
-		for (int j = 0; j < nu_subsets; j++)	// For each subset.
-			for (int k = 0; k < 2; k++) {	// For each endpoint.
-				endpoint_array[j * 8 + k * 4 + i] = data & mask;
-				data >>= precision;
-			}
-	block->index += components_in_qword0 * total_bits_per_component;
-	if (components_in_qword0 < 3) {
-		// Handle the color component that crosses the boundary between data0 and data1
-		data = block->data0 >> block->index;
-		data |= block->data1 << (64 - block->index);
-		int i = components_in_qword0;
-		for (int j = 0; j < nu_subsets; j++)	// For each subset.
-			for (int k = 0; k < 2; k++) {	// For each endpoint.
-				endpoint_array[j * 8 + k * 4 + i] = data & mask;
-				data >>= precision;
-			}
-		block->index += total_bits_per_component;
+	int nu_endpoints = layout->nu_subsets * 2;
+	int color_precision = layout->color_precision;
+	int alpha_precision = layout->alpha_precision;
+	// Each component of all endpoints is at most 30 bits and is extracted at once.
+	int offset = layout->endpoint_offset;
+	for (int i = 0; i < 3; i++) {
+		uint32_t data = detexBlock128GetBits(block, offset, nu_endpoints * color_precision);
+		for (int j = 0; j < nu_endpoints; j++) {
+			endpoint_array[j * 4 + i] = data & ((1 << color_precision) - 1);
+			data >>= color_precision;
+		}
+		offset += nu_endpoints * color_precision;
 	}
-	if (components_in_qword0 < 2) {
-		// Handle the color component that is wholly in data1.
-		data = block->data1 >> (block->index - 64);
-		int i = 2;
-		for (int j = 0; j < nu_subsets; j++)	// For each subset.
-			for (int k = 0; k < 2; k++) {	// For each endpoint.
-				endpoint_array[j * 8 + k * 4 + i] = data & mask;
-				data >>= precision;
-			}
-		block->index += total_bits_per_component;
+	if (alpha_precision > 0) {
+		uint32_t data = detexBlock128GetBits(block, offset, nu_endpoints * alpha_precision);
+		for (int j = 0; j < nu_endpoints; j++) {
+			endpoint_array[j * 4 + 3] = data & ((1 << alpha_precision) - 1);
+			data >>= alpha_precision;
+		}
 	}
-	// Alpha component.
-	if (GetAlphaComponentPrecision(mode) > 0) {
-		// For mode 7, the alpha data is wholly in data1.
-		// For modes 4 and 6, the alpha data is wholly in data0.
-		// For mode 5, the alpha data is in data0 and data1.
-		if (mode == 7)
-			data = block->data1 >> (block->index - 64);
-		else if (mode == 5)
-			data = (block->data0 >> block->index) | ((block->data1 & 0x3) << 14);
-		else
-			data = block->data0 >> block->index;
-		uint8_t alpha_precision = GetAlphaComponentPrecision(mode);
-		uint8_t mask = (1 << alpha_precision) - 1;
-		for (int j = 0; j < nu_subsets; j++)
-			for (int k = 0; k < 2; k++) {	// For each endpoint.
-				endpoint_array[j * 8 + k * 4 + 3] = data & mask;
-				data >>= alpha_precision;
-			}
-		block->index += nu_subsets * 2 * alpha_precision;
+	if (layout->pbit_type != BPTC_PBITS_NONE) {
+		uint32_t pbits = detexBlock128GetBits(block, layout->pbit_offset, nu_endpoints);
+		for (int j = 0; j < nu_endpoints; j++) {
+			uint8_t pbit;
+			if (layout->pbit_type == BPTC_PBITS_PER_SUBSET)
+				// Mode 1 has one shared P-bit per subset.
+				pbit = (pbits >> (j >> 1)) & 1;
+			else
+				pbit = (pbits >> j) & 1;
+			for (int i = 0; i < 3; i++)
+				endpoint_array[j * 4 + i] = (endpoint_array[j * 4 + i] << 1) | pbit;
+			if (alpha_precision > 0)
+				endpoint_array[j * 4 + 3] = (endpoint_array[j * 4 + 3] << 1) | pbit;
+		}
+		color_precision++;
+		if (alpha_precision > 0)
+			alpha_precision++;
 	}
-}
-
-static const uint8_t mode_has_p_bits[8] = { 1, 1, 0, 1, 0, 0, 1, 1 };
-
-static void FullyDecodeEndpoints(uint8_t * DETEX_RESTRICT endpoint_array, int nu_subsets,
-int mode, detexBlock128 * DETEX_RESTRICT block) {
-	if (mode_has_p_bits[mode]) {
-		// Mode 1 (shared P-bits) handled elsewhere.
-		// Extract end-point P-bits. Take advantage of the fact that they don't cross the
-		// 64-bit word boundary in any mode.
-		uint32_t bits;
-		if (block->index < 64) {
-			bits = block->data0 >> block->index;
-
-			if ((block->index + nu_subsets * 2) > 64) {
-				bits |= (block->data1 << (64 - block->index));
-			}
+	for (int j = 0; j < nu_endpoints; j++) {
+		// Left shift endpoint components so that their MSB lies in bit 7, and replicate
+		// each component's MSB into the LSBs revealed by the left-shift.
+		for (int i = 0; i < 3; i++) {
+			endpoint_array[j * 4 + i] <<= (8 - color_precision);
+			endpoint_array[j * 4 + i] |= (endpoint_array[j * 4 + i] >> color_precision);
 		}
-		else
-			bits = block->data1 >> (block->index - 64);
-		for (int i = 0; i < nu_subsets * 2; i++) {
-			endpoint_array[i * 4 + 0] <<= 1;
- 			endpoint_array[i * 4 + 1] <<= 1;
-			endpoint_array[i * 4 + 2] <<= 1;
-			endpoint_array[i * 4 + 3] <<= 1;
-			endpoint_array[i * 4 + 0] |= (bits & 1);
-			endpoint_array[i * 4 + 1] |= (bits & 1);
-			endpoint_array[i * 4 + 2] |= (bits & 1);
-			endpoint_array[i * 4 + 3] |= (bits & 1);
-			bits >>= 1;
+		if (alpha_precision > 0) {
+			endpoint_array[j * 4 + 3] <<= (8 - alpha_precision);
+			endpoint_array[j * 4 + 3] |= (endpoint_array[j * 4 + 3] >> alpha_precision);
 		}
-		block->index += nu_subsets * 2;
-	}
-	int color_prec = GetColorComponentPrecisionPlusPbit(mode);
-	int alpha_prec = GetAlphaComponentPrecisionPlusPbit(mode);
-	for (int i = 0; i < nu_subsets * 2; i++) {
-		// Color_component_precision & alpha_component_precision includes pbit
-		// left shift endpoint components so that their MSB lies in bit 7
-		endpoint_array[i * 4 + 0] <<= (8 - color_prec);
-		endpoint_array[i * 4 + 1] <<= (8 - color_prec);
-		endpoint_array[i * 4 + 2] <<= (8 - color_prec);
-		endpoint_array[i * 4 + 3] <<= (8 - alpha_prec);
-
-	        // Replicate each component's MSB into the LSBs revealed by the left-shift operation above.
-		endpoint_array[i * 4 + 0] |= (endpoint_array[i * 4 + 0] >> color_prec);
-		endpoint_array[i * 4 + 1] |= (endpoint_array[i * 4 + 1] >> color_prec);
-		endpoint_array[i * 4 + 2] |= (endpoint_array[i * 4 + 2] >> color_prec);
-		endpoint_array[i * 4 + 3] |= (endpoint_array[i * 4 + 3] >> alpha_prec);
+		else
+			endpoint_array[j * 4 + 3] = 0xFF;
 	}
-	if (mode <= 3) {
-		for (int i = 0; i < nu_subsets * 2; i++)
-			endpoint_array[i * 4 + 3] = 0xFF;
- 	}
 }
 
-static uint8_t Interpolate(uint8_t e0, uint8_t e1, uint8_t index, uint8_t indexprecision) {
+static DETEX_INLINE_ONLY uint8_t Interpolate(uint8_t e0, uint8_t e1, uint8_t index, uint8_t indexprecision) {
 	if (indexprecision == 2)
 		return (uint8_t) (((64 - detex_bptc_table_aWeight2[index]) * (uint16_t)e0
 			+ detex_bptc_table_aWeight2[index] * (uint16_t)e1 + 32) >> 6);
@@ -197,64 +147,25 @@ static uint8_t Interpolate(uint8_t e0, uint8_t e1, uint8_t index, uint8_t indexp
 			+ detex_bptc_table_aWeight4[index] * (uint16_t)e1 + 32) >> 6);
 }
 
-static const uint8_t bptc_color_index_bitcount[8] = { 3, 3, 2, 2, 2, 2, 4, 2 };
-
-static DETEX_INLINE_ONLY int GetColorIndexBitcount(int mode, int index_selection_bit) {
-	// If the index selection bit is set for mode 4, return 3, otherwise 2.
-	return bptc_color_index_bitcount[mode] + index_selection_bit;
-}
-
-static uint8_t bptc_alpha_index_bitcount[8] = { 3, 3, 2, 2, 3, 2, 4, 2};
-
-static DETEX_INLINE_ONLY int GetAlphaIndexBitcount(int mode, int index_selection_bit) {
-	// If the index selection bit is set for mode 4, return 2, otherwise 3.
-	return bptc_alpha_index_bitcount[mode] - index_selection_bit;
-}
-
-static const uint8_t bptc_NS[8] = { 3, 2, 3, 2, 1, 1, 1, 2 };
-
-static DETEX_INLINE_ONLY int GetNumberOfSubsets(int mode) {
-	return bptc_NS[mode];
-}
-
-static const uint8_t PB[8] = { 4, 6, 6, 6, 0, 0, 0, 6 };
-
-static DETEX_INLINE_ONLY int GetNumberOfPartitionBits(int mode) {
-	return PB[mode];
-}
-
-static const uint8_t RB[8] = { 0, 0, 0, 0, 2, 2, 0, 0 };
-
-static DETEX_INLINE_ONLY int GetNumberOfRotationBits(int mode) {
-	return RB[mode];
-}
-
 // Functions to extract parameters. */
 
-static int ExtractMode(detexBlock128 *block) {
-	for (int i = 0; i < 8; i++)
-		if (block->data0 & ((uint64_t)1 << i)) {
-			block->index = i + 1;
-			return i;
-		}
-	// Illegal.
-	return - 1;
+static DETEX_INLINE_ONLY int ExtractMode(const detexBlock128 *block) {
+	// The mode is the position of the lowest set bit of the first byte.
+	if ((block->data0 & 0xFF) == 0)
+		// Illegal.
+		return - 1;
+	return __builtin_ctz((uint32_t)block->data0 & 0xFF);
 }
 
-static DETEX_INLINE_ONLY int ExtractPartitionSetID(detexBlock128 *block, int mode) {
-	return detexBlock128ExtractBits(block, GetNumberOfPartitionBits(mode));
-}
+static const uint8_t bptc_single_subset_partition[16] = { 0 };
 
-static DETEX_INLINE_ONLY int GetPartitionIndex(int nu_subsets, int partition_set_id, int i) {
+// Return the subset index of each pixel.
+static DETEX_INLINE_ONLY const uint8_t *GetPartition(int nu_subsets, int partition_set_id) {
 	if (nu_subsets == 1)
-		return 0;
+		return bptc_single_subset_partition;
 	if (nu_subsets == 2)
-		return detex_bptc_table_P2[partition_set_id * 16 + i];
-	return detex_bptc_table_P3[partition_set_id * 16 + i];
-}
-
-static DETEX_INLINE_ONLY int ExtractRotationBits(detexBlock128 *block, int mode) {
-	return detexBlock128ExtractBits(block, GetNumberOfRotationBits(mode));
+		return &detex_bptc_table_P2[partition_set_id * 16];
+	return &detex_bptc_table_P3[partition_set_id * 16];
 }
 
 static DETEX_INLINE_ONLY int GetAnchorIndex(int partition_set_id, int partition, int nu_subsets) {
@@ -267,239 +178,80 @@ static DETEX_INLINE_ONLY int GetAnchorIndex(int partition_set_id, int partition,
 	return detex_bptc_table_anchor_index_third_subset[partition_set_id];
 }
 
-static const uint8_t IB[8] = { 3, 3, 2, 2, 2, 2, 4, 2 };
-static const uint8_t IB2[8] = { 0, 0, 0, 0, 3, 2, 0, 0 };
-static const uint8_t mode_has_partition_bits[8] = { 1, 1, 1, 1, 0, 0, 0, 1 };
-
-/* Decompress a 128-bit 4x4 pixel texture block compressed using BPTC mode 1. */
-
-static bool DecompressBlockBPTCMode1(detexBlock128 * DETEX_RESTRICT block,
-uint8_t * DETEX_RESTRICT pixel_buffer) {
-	uint64_t data0 = block->data0;
-	uint64_t data1 = block->data1;
-	int partition_set_id = detexGetBits64(data0, 2, 7);
-	uint8_t endpoint[2 * 2 * 3];	// 2 subsets.
-	endpoint[0] = detexGetBits64(data0, 8, 13);	// red, subset 0, endpoint 0
-	endpoint[3] = detexGetBits64(data0, 14, 19);	// red, subset 0, endpoint 1
-	endpoint[6] = detexGetBits64(data0, 20, 25);	// red, subset 1, endpoint 0
-	endpoint[9] = detexGetBits64(data0, 26, 31);	// red, subset 1, endpoint 1
-	endpoint[1] = detexGetBits64(data0, 32, 37);	// green, subset 0, endpoint 0
-	endpoint[4] = detexGetBits64(data0, 38, 43);	// green, subset 0, endpoint 1
-	endpoint[7] = detexGetBits64(data0, 44, 49);	// green, subset 1, endpoint 0
-	endpoint[10] = detexGetBits64(data0, 50, 55);	// green, subset 1, endpoint 1
-	endpoint[2] = detexGetBits64(data0, 56, 61);	// blue, subset 0, endpoint 0
-	endpoint[5] = detexGetBits64(data0, 62, 63)	// blue, subset 0, endpoint 1
-		| (detexGetBits64(data1, 0, 3) << 2);
-	endpoint[8] = detexGetBits64(data1, 4, 9);	// blue, subset 1, endpoint 0
-	endpoint[11] = detexGetBits64(data1, 10, 15);	// blue, subset 1, endpoint 1
-	// Decode endpoints.
-	for (int i = 0; i < 2 * 2; i++) {
-		//component-wise left-shift
-		endpoint[i * 3 + 0] <<= 2;
-		endpoint[i * 3 + 1] <<= 2;
-		endpoint[i * 3 + 2] <<= 2;
-       	}
-	// P-bit is shared.
-	uint8_t pbit_zero = detexGetBits64(data1, 16, 16) << 1;
-	uint8_t pbit_one = detexGetBits64(data1, 17, 17) << 1;
-        // RGB only pbits for mode 1, one for each subset.
-	for (int j = 0; j < 3; j++) {
-		endpoint[0 * 3 + j] |= pbit_zero;
-		endpoint[1 * 3 + j] |= pbit_zero;
-		endpoint[2 * 3 + j] |= pbit_one;
-		endpoint[3 * 3 + j] |= pbit_one;
-	}
-	for (int i = 0; i < 2 * 2; i++) {
-	        // Replicate each component's MSB into the LSB.
-		endpoint[i * 3 + 0] |= endpoint[i * 3 + 0] >> 7;
-		endpoint[i * 3 + 1] |= endpoint[i * 3 + 1] >> 7;
-		endpoint[i * 3 + 2] |= endpoint[i * 3 + 2] >> 7;
-	}
- 
-	uint8_t subset_index[16];
-	for (int i = 0; i < 16; i++)
-		// subset_index[i] is a number from 0 to 1.
-		subset_index[i] = detex_bptc_table_P2[partition_set_id * 16 + i];
-	uint8_t anchor_index[2];
-	anchor_index[0] = 0;
-	anchor_index[1] = detex_bptc_table_anchor_index_second_subset[partition_set_id];
-	uint8_t color_index[16];
-	// Extract primary index bits.
-	data1 >>= 18;
-	for (int i = 0; i < 16; i++)
-		if (i == anchor_index[subset_index[i]]) {
-			// Highest bit is zero.
-			color_index[i] = data1 & 3; // Get two bits.
-			data1 >>= 2;
-		}
-		else {
-			color_index[i] = data1 & 7;	// Get three bits.
-			data1 >>= 3;
-		}
-	uint32_t *pixel32_buffer = (uint32_t *)pixel_buffer;
+// Extract 16 indices of nu_bits each from the bitstring at offset, where the index at
+// the anchor of each subset has one bit less (its highest bit is zero).
+static DETEX_INLINE_ONLY void ExtractIndices(const detexBlock128 * DETEX_RESTRICT block, int offset,
+int nu_bits, const uint8_t * DETEX_RESTRICT subset_index, const uint8_t * DETEX_RESTRICT anchor_index,
+int nu_subsets, uint8_t * DETEX_RESTRICT index) {
+	// At most 63 bits (mode 6).
+	uint64_t data = detexBlock128GetBits(block, offset, 16 * nu_bits - nu_subsets);
 	for (int i = 0; i < 16; i++) {
-		uint8_t endpoint_start[3];
-		uint8_t endpoint_end[3];
-		for (int j = 0; j < 3; j++) {
-			 endpoint_start[j] = endpoint[2 * subset_index[i] * 3 + j];
-			 endpoint_end[j] = endpoint[(2 * subset_index[i] + 1) * 3 + j];
-		}
-		uint32_t output;
-		output = detexPack32R8(Interpolate(endpoint_start[0], endpoint_end[0], color_index[i], 3));
-		output |= detexPack32G8(Interpolate(endpoint_start[1], endpoint_end[1], color_index[i], 3));
-		output |= detexPack32B8(Interpolate(endpoint_start[2], endpoint_end[2], color_index[i], 3));
-		output |= detexPack32A8(0xFF);
-		pixel32_buffer[i] = output;
+		int n = nu_bits - (i == anchor_index[subset_index[i]]);
+		index[i] = data & ((1 << n) - 1);
+		data >>= n;
 	}
-	return true;
 }
 
-/* Decompress a 128-bit 4x4 pixel texture block compressed using the BPTC */
-/* (BC7) format. */
-bool detexDecompressBlockBPTC(const uint8_t * DETEX_RESTRICT bitstring, uint32_t mode_mask,
-uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
-	detexBlock128 block;
-	block.data0 = *(uint64_t *)&bitstring[0];
-	block.data1 = *(uint64_t *)&bitstring[8];
-	block.index = 0;
-	int mode = ExtractMode(&block);
-	if (mode == - 1)
-		return 0;
-	// Allow compression tied to specific modes (according to mode_mask).
-	if (!(mode_mask & ((int)1 << mode)))
-		return 0;
-	if (mode >= 4 && (flags & DETEX_DECOMPRESS_FLAG_OPAQUE_ONLY))
-		return 0;
-	if (mode < 4 && (flags & DETEX_DECOMPRESS_FLAG_NON_OPAQUE_ONLY))
-		return 0;
-	if (mode == 1)
-		return DecompressBlockBPTCMode1(&block, pixel_buffer);
-
-	int nu_subsets = 1;
-	int partition_set_id = 0;
-	if (mode_has_partition_bits[mode]) {
-		nu_subsets = GetNumberOfSubsets(mode);
-		partition_set_id = ExtractPartitionSetID(&block, mode);
-	}
-	int rotation = ExtractRotationBits(&block, mode);
-	int index_selection_bit = 0;
-	if (mode == 4)
-		index_selection_bit = detexBlock128ExtractBits(&block, 1);
-
-	int alpha_index_bitcount = GetAlphaIndexBitcount(mode, index_selection_bit);
-	int color_index_bitcount = GetColorIndexBitcount(mode, index_selection_bit);
+// Decompress a block of the given mode. When inlined with a constant mode, the mode layout
+// is folded into constants.
+static DETEX_INLINE_ONLY bool DecompressBlockBPTCMode(const detexBlock128 * DETEX_RESTRICT block,
+int mode, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	const BPTCModeLayout *layout = &bptc_mode_layout[mode];
+	int nu_subsets = layout->nu_subsets;
+	int offset = mode + 1;
+	int partition_set_id = detexBlock128GetBits(block, offset, layout->partition_bits);
+	offset += layout->partition_bits;
+	int rotation = detexBlock128GetBits(block, offset, layout->rotation_bits);
+	offset += layout->rotation_bits;
+	int index_selection_bit = detexBlock128GetBits(block, offset, layout->index_selection_bits);
 
 	uint8_t endpoint_array[3 * 2 * 4];	// Max. 3 subsets.
-	ExtractEndpoints(mode, nu_subsets, &block, endpoint_array);
-	FullyDecodeEndpoints(endpoint_array, nu_subsets, mode, &block);
+	DecodeEndpoints(block, layout, endpoint_array);
 
-	uint8_t subset_index[16];
-	for (int i = 0; i < 16; i++)
-		// subset_index[i] is a number from 0 to 2, or 0 to 1, or 0 depending on the number of subsets.
-		subset_index[i] = GetPartitionIndex(nu_subsets, partition_set_id, i);
+	// subset_index[i] is a number from 0 to 2, or 0 to 1, or 0 depending on the number of subsets.
+	const uint8_t *subset_index = GetPartition(nu_subsets, partition_set_id);
 	uint8_t anchor_index[4];	// Only need max. 3 elements.
 	for (int i = 0; i < nu_subsets; i++)
 		anchor_index[i] = GetAnchorIndex(partition_set_id, i, nu_subsets);
-	uint8_t color_index[16];
-	uint8_t alpha_index[16];
-	// Extract primary index bits.
-	uint64_t data1;
-	if (block.index >= 64) {
-		// Because the index bits are all in the second 64-bit word, there is no need to use
-		// block_extract_bits().
-		// This implies the mode is not 4.
-		data1 = block.data1 >> (block.index - 64);
-		uint8_t mask1 = (1 << IB[mode]) - 1;
-		uint8_t mask2 = (1 << (IB[mode] - 1)) - 1;
-		for (int i = 0; i < 16; i++)
-			if (i == anchor_index[subset_index[i]]) {
-				// Highest bit is zero.
-				color_index[i] = data1 & mask2;
-				data1 >>= IB[mode] - 1;
-				alpha_index[i] = color_index[i];
-			}
-			else {
-				color_index[i] = data1 & mask1;
-				data1 >>= IB[mode];
-				alpha_index[i] = color_index[i];
-			}
-	}
-	else {	// Implies mode 4.
-		// Because the bits cross the 64-bit word boundary, we have to be careful.
-		// Block index is 50 at this point.
-		uint64_t data = block.data0 >> 50;
-		data |= block.data1 << 14;
-		for (int i = 0; i < 16; i++)
-			if (i == anchor_index[subset_index[i]]) {
-				// Highest bit is zero.
-				if (index_selection_bit) {	// Implies mode == 4.
-					alpha_index[i] = data & 0x1;
-					data >>= 1;
-				}
-				else {
-					color_index[i] = data & 0x1;
-					data >>= 1;
-				}
-			}
-			else {
-				if (index_selection_bit) {	// Implies mode == 4.
-					alpha_index[i] = data & 0x3;
-					data >>= 2;
-				}
-				else {
-					color_index[i] = data & 0x3;
-					data >>= 2;
-				}
-			}
-		// Block index is 81 at this point.
-		data1 = block.data1 >> (81 - 64);
-	}
-	// Extract secondary index bits.
-	if (IB2[mode] > 0) {
-		uint8_t mask1 = (1 << IB2[mode]) - 1;
-		uint8_t mask2 = (1 << (IB2[mode] - 1)) - 1;
-		for (int i = 0; i < 16; i++)
-			if (i == anchor_index[subset_index[i]]) {
-				// Highest bit is zero.
-				if (index_selection_bit) {
-					color_index[i] = data1 & 0x3;
-					data1 >>= 2;
-				}
-				else {
-//					alpha_index[i] = block_extract_bits(&block, IB2[mode] - 1);
-					alpha_index[i] = data1 & mask2;
-					data1 >>= IB2[mode] - 1;
-				}
-			}
-			else {
-				if (index_selection_bit) {
-					color_index[i] = data1 & 0x7;
-					data1 >>= 3;
-				}
-				else {
-//					alpha_index[i] = block_extract_bits(&block, IB2[mode]);
-					alpha_index[i] = data1 & mask1;
-					data1 >>= IB2[mode];
-				}
-			}
+	// Extract primary and secondary index bits. When there are no secondary indices, the
+	// primary indices are used for both color and alpha. When the index selection bit
+	// (mode 4) is set, the primary indices are used for alpha and the secondary indices
+	// for color.
+	uint8_t primary_index[16];
+	uint8_t secondary_index[16];
+	ExtractIndices(block, layout->index_offset, layout->index_bits, subset_index, anchor_index,
+		nu_subsets, primary_index);
+	const uint8_t *color_index = primary_index;
+	const uint8_t *alpha_index = primary_index;
+	int color_index_bitcount = layout->index_bits;
+	int alpha_index_bitcount = layout->index_bits;
+	if (layout->secondary_index_bits > 0) {
+		ExtractIndices(block, layout->secondary_index_offset, layout->secondary_index_bits,
+			subset_index, anchor_index, nu_subsets, secondary_index);
+		if (index_selection_bit) {
+			color_index = secondary_index;
+			color_index_bitcount = layout->secondary_index_bits;
+		}
+		else {
+			alpha_index = secondary_index;
+			alpha_index_bitcount = layout->secondary_index_bits;
+		}
 	}
 
 	uint32_t *pixel32_buffer = (uint32_t *)pixel_buffer;
 	for (int i = 0; i < 16; i++) {
-		uint8_t endpoint_start[4];
-		uint8_t endpoint_end[4];
-		for (int j = 0; j < 4; j++) {
-			 endpoint_start[j] = endpoint_array[2 * subset_index[i] * 4 + j];
-			 endpoint_end[j] = endpoint_array[(2 * subset_index[i] + 1) * 4 + j];
-		}
-
-		uint32_t output = 0;
+		const uint8_t *endpoint_start = &endpoint_array[2 * subset_index[i] * 4];
+		const uint8_t *endpoint_end = &endpoint_array[(2 * subset_index[i] + 1) * 4];
+		uint32_t output;
 		output = detexPack32R8(Interpolate(endpoint_start[0], endpoint_end[0], color_index[i], color_index_bitcount));
 		output |= detexPack32G8(Interpolate(endpoint_start[1], endpoint_end[1], color_index[i], color_index_bitcount));
 		output |= detexPack32B8(Interpolate(endpoint_start[2], endpoint_end[2], color_index[i], color_index_bitcount));
-		output |= detexPack32A8(Interpolate(endpoint_start[3], endpoint_end[3], alpha_index[i], alpha_index_bitcount));
-   
-		if (rotation > 0) {
+		if (layout->alpha_precision > 0)
+			output |= detexPack32A8(Interpolate(endpoint_start[3], endpoint_end[3], alpha_index[i],
+				alpha_index_bitcount));
+		else
+			output |= detexPack32A8(0xFF);
+		if (layout->rotation_bits > 0 && rotation > 0) {
 			if (rotation == 1)
 				output = detexPack32RGBA8(detexPixel32GetA8(output), detexPixel32GetG8(output),
 					detexPixel32GetB8(output), detexPixel32GetR8(output));
@@ -516,6 +268,50 @@ uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
 	return true;
 }
 
+// Generate a specialized decoder for each mode.
+#define BPTC_MODE_DECODER(mode) \
+	static bool DecompressBlockBPTCMode##mode(const detexBlock128 * DETEX_RESTRICT block, \
+	uint8_t * DETEX_RESTRICT pixel_buffer) { \
+		return DecompressBlockBPTCMode(block, mode, pixel_buffer); \
+	}
+
+BPTC_MODE_DECODER(0)
+BPTC_MODE_DECODER(1)
+BPTC_MODE_DECODER(2)
+BPTC_MODE_DECODER(3)
+BPTC_MODE_DECODER(4)
+BPTC_MODE_DECODER(5)
+BPTC_MODE_DECODER(6)
+BPTC_MODE_DECODER(7)
+
+static bool (* const decompress_block_bptc_mode[8])(const detexBlock128 * DETEX_RESTRICT,
+uint8_t * DETEX_RESTRICT) = {
+	DecompressBlockBPTCMode0, DecompressBlockBPTCMode1, DecompressBlockBPTCMode2,
+	DecompressBlockBPTCMode3, DecompressBlockBPTCMode4, DecompressBlockBPTCMode5,
+	DecompressBlockBPTCMode6, DecompressBlockBPTCMode7
+};
+
+/* Decompress a 128-bit 4x4 pixel texture block compressed using the BPTC */
+/* (BC7) format. */
+bool detexDecompressBlockBPTC(const uint8_t * DETEX_RESTRICT bitstring, uint32_t mode_mask,
+uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	detexBlock128 block;
+	block.data0 = *(uint64_t *)&bitstring[0];
+	block.data1 = *(uint64_t *)&bitstring[8];
+	block.index = 0;
+	int mode = ExtractMode(&block);
+	if (mode == - 1)
+		return 0;
+	// Allow compression tied to specific modes (according to mode_mask).
+	if (!(mode_mask & ((int)1 << mode)))
+		return 0;
+	if (mode >= 4 && (flags & DETEX_DECOMPRESS_FLAG_OPAQUE_ONLY))
+		return 0;
+	if (mode < 4 && (flags & DETEX_DECOMPRESS_FLAG_NON_OPAQUE_ONLY))
+		return 0;
+	return decompress_block_bptc_mode[mode](&block, pixel_buffer);
+}
+
 #if 0
 /* Modify compressed block to use specific colors. For later use. */
 static void SetBlockColors(uint8_t * DETEX_RESTRICT bitstring, uint32_t flags,
@@ -16,7 +16,10 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 */
 
+#include <string.h>
+
 #include "detex.h"
+#include "simd.h"
 
 static const int8_t eac_modifier_table[16][8] = {
 	{ -3, -6, -9, -15, 2, 5, 8, 14 },
@@ -230,3 +233,342 @@ uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
 	return DecodeBlockEACSigned11Bit(green_qword, 1, 1, pixel_buffer);
 }
 
+
+// Batch decompression of consecutive ETC2_EAC, EAC_R11, EAC_SIGNED_R11, EAC_RG11 and
+// EAC_SIGNED_RG11 blocks. Each EAC block channel only has eight possible values, one for
+// every 3-bit selector. The SIMD code paths calculate these values once per block using
+// 16-bit arithmetic, with the clamps replaced by min/max operations, and expand the
+// selectors using permutes (AVX2) or table lookups (SSE2). The results are identical to
+// the single block functions above.
+
+enum {
+	EAC_BATCH_TYPE_ETC2_EAC,
+	EAC_BATCH_TYPE_R11,
+	EAC_BATCH_TYPE_SIGNED_R11,
+	EAC_BATCH_TYPE_RG11,
+	EAC_BATCH_TYPE_SIGNED_RG11
+};
+
+// Maximum number of ETC2_EAC blocks of which the color parts are decompressed at once.
+#define ETC2_EAC_COLOR_RUN 16
+
+static DETEX_INLINE_ONLY uint64_t LoadQwordEAC(const uint8_t * DETEX_RESTRICT bitstring) {
+	return ((uint64_t)bitstring[0] << 56) | ((uint64_t)bitstring[1] << 48) |
+		((uint64_t)bitstring[2] << 40) |
+		((uint64_t)bitstring[3] << 32) | ((uint64_t)bitstring[4] << 24) |
+		((uint64_t)bitstring[5] << 16) | ((uint64_t)bitstring[6] << 8) | bitstring[7];
+}
+
+#ifdef DETEX_USE_SSE2
+
+// Calculate the eight values of an 8-bit alpha channel (ETC2_EAC).
+static DETEX_INLINE_ONLY __m128i CalculateValuesEACAlphaSSE2(uint64_t qword) {
+	__m128i modifiers = _mm_srai_epi16(_mm_unpacklo_epi8(_mm_setzero_si128(),
+		_mm_loadl_epi64((__m128i *)eac_modifier_table[(qword >> 48) & 0xF])), 8);
+	__m128i values = _mm_add_epi16(_mm_set1_epi16(qword >> 56),
+		_mm_mullo_epi16(modifiers, _mm_set1_epi16((qword >> 52) & 0xF)));
+	return _mm_max_epi16(_mm_min_epi16(values, _mm_set1_epi16(255)), _mm_setzero_si128());
+}
+
+// Calculate the eight values of an unsigned 11-bit channel, replicated to 16 bits.
+static DETEX_INLINE_ONLY __m128i CalculateValuesEAC11BitSSE2(uint64_t qword) {
+	__m128i modifiers = _mm_srai_epi16(_mm_unpacklo_epi8(_mm_setzero_si128(),
+		_mm_loadl_epi64((__m128i *)eac_modifier_table[(qword >> 48) & 0xF])), 8);
+	int multiplier_times_8 = ((qword >> 52) & 0xF) << 3;
+	if (multiplier_times_8 == 0)
+		multiplier_times_8 = 1;
+	__m128i values = _mm_add_epi16(_mm_set1_epi16(((qword >> 56) << 3) | 0x4),
+		_mm_mullo_epi16(modifiers, _mm_set1_epi16(multiplier_times_8)));
+	values = _mm_max_epi16(_mm_min_epi16(values, _mm_set1_epi16(2047)), _mm_setzero_si128());
+	return _mm_or_si128(_mm_slli_epi16(values, 5), _mm_srli_epi16(values, 6));
+}
+
+// Calculate the eight values of a signed 11-bit channel, replicated to 16 bits. The
+// magnitude is replicated and the sign applied afterwards.
+static DETEX_INLINE_ONLY __m128i CalculateValuesEACSigned11BitSSE2(uint64_t qword) {
+	__m128i modifiers = _mm_srai_epi16(_mm_unpacklo_epi8(_mm_setzero_si128(),
+		_mm_loadl_epi64((__m128i *)eac_modifier_table[(qword >> 48) & 0xF])), 8);
+	int multiplier_times_8 = ((qword >> 52) & 0xF) << 3;
+	if (multiplier_times_8 == 0)
+		multiplier_times_8 = 1;
+	__m128i values = _mm_add_epi16(_mm_set1_epi16((int8_t)(qword >> 56) * 8),
+		_mm_mullo_epi16(modifiers, _mm_set1_epi16(multiplier_times_8)));
+	values = _mm_max_epi16(_mm_min_epi16(values, _mm_set1_epi16(1023)), _mm_set1_epi16(- 1023));
+	__m128i sign = _mm_srai_epi16(values, 15);
+	__m128i magnitude = _mm_sub_epi16(_mm_xor_si128(values, sign), sign);
+	magnitude = _mm_or_si128(_mm_slli_epi16(magnitude, 5), _mm_srli_epi16(magnitude, 5));
+	return _mm_sub_epi16(_mm_xor_si128(magnitude, sign), sign);
+}
+
+// Calculate the values of the channels of a block. Returns false for a signed block with
+// the base codeword -128, which is left to the single block functions.
+static DETEX_INLINE_ONLY bool CalculateValuesEACSSE2(const uint8_t * DETEX_RESTRICT bitstring, int type,
+uint64_t *qword, __m128i *values) {
+	qword[0] = LoadQwordEAC(bitstring);
+	if (type == EAC_BATCH_TYPE_ETC2_EAC) {
+		values[0] = CalculateValuesEACAlphaSSE2(qword[0]);
+		return true;
+	}
+	if (type == EAC_BATCH_TYPE_R11 || type == EAC_BATCH_TYPE_RG11)
+		values[0] = CalculateValuesEAC11BitSSE2(qword[0]);
+	else {
+		if (bitstring[0] == 0x80)
+			return false;
+		values[0] = CalculateValuesEACSigned11BitSSE2(qword[0]);
+	}
+	if (type == EAC_BATCH_TYPE_R11 || type == EAC_BATCH_TYPE_SIGNED_R11)
+		return true;
+	qword[1] = LoadQwordEAC(bitstring + 8);
+	if (type == EAC_BATCH_TYPE_RG11)
+		values[1] = CalculateValuesEAC11BitSSE2(qword[1]);
+	else {
+		if (bitstring[8] == 0x80)
+			return false;
+		values[1] = CalculateValuesEACSigned11BitSSE2(qword[1]);
+	}
+	return true;
+}
+
+// Expand the selectors of a block channel, storing the 16-bit values (16 bits apart when
+// shift is zero, 32 bits apart when shift is one) or 8-bit alpha values.
+static DETEX_INLINE_ONLY void ExpandSelectorsEACSSE2(__m128i values, uint64_t qword, bool alpha,
+int shift, int offset, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	uint16_t value_table[8];
+	_mm_storeu_si128((__m128i *)value_table, values);
+	uint16_t *buffer = (uint16_t *)pixel_buffer;
+	for (int i = 0; i < 16; i++) {
+		int selector = (qword >> (45 - i * 3)) & 7;
+		int j = (i & 3) * 4 + ((i & 12) >> 2);
+		if (alpha)
+			pixel_buffer[j * 4 + DETEX_PIXEL32_ALPHA_BYTE_OFFSET] = value_table[selector];
+		else
+			buffer[(j << shift) + offset] = value_table[selector];
+	}
+}
+
+// Decode the EAC channels of consecutive blocks until a block is encountered that is not
+// handled by the SIMD code path. For ETC2_EAC, only the alpha channel is decoded. Returns
+// the number of blocks decoded.
+static int DecodeBlocksEACSSE2(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks, int type,
+uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int block_size = (type == EAC_BATCH_TYPE_R11 || type == EAC_BATCH_TYPE_SIGNED_R11) ? 8 : 16;
+	int pixel_block_size = block_size == 8 ? 32 : 64;
+	int i;
+	for (i = 0; i < nu_blocks; i++) {
+		uint64_t qword[2];
+		__m128i values[2];
+		if (!CalculateValuesEACSSE2(bitstring, type, qword, values))
+			break;
+		if (type == EAC_BATCH_TYPE_ETC2_EAC)
+			ExpandSelectorsEACSSE2(values[0], qword[0], true, 0, 0, pixel_buffer);
+		else if (block_size == 8)
+			ExpandSelectorsEACSSE2(values[0], qword[0], false, 0, 0, pixel_buffer);
+		else {
+			ExpandSelectorsEACSSE2(values[0], qword[0], false, 1, 0, pixel_buffer);
+			ExpandSelectorsEACSSE2(values[1], qword[1], false, 1, 1, pixel_buffer);
+		}
+		bitstring += block_size;
+		pixel_buffer += pixel_block_size;
+	}
+	return i;
+}
+
+#endif
+
+#ifdef DETEX_USE_AVX2
+
+// Expand the selectors of a block channel into 32-bit lanes, with values_out[0] holding
+// the pixels of the first two rows and values_out[1] those of the last two rows. Selector
+// fields that lie above bit 31 are extracted from the index bits shifted down by 16.
+static DETEX_INLINE_ONLY DETEX_TARGET_AVX2 void ExpandSelectorsEACAVX2(__m128i values, uint64_t qword,
+__m256i *values_out) {
+	__m256i value_table = _mm256_cvtepu16_epi32(values);
+	__m256i low = _mm256_set1_epi32((uint32_t)qword);
+	__m256i high = _mm256_set1_epi32((uint32_t)(qword >> 16));
+	__m256i seven = _mm256_set1_epi32(7);
+	// The selector of the pixel at (x, y) starts at bit 45 - 3 * (x * 4 + y).
+	__m256i selectors0 = _mm256_and_si256(_mm256_srlv_epi32(_mm256_blend_epi32(low, high, 0x33),
+		_mm256_setr_epi32(45 - 16, 33 - 16, 21, 9, 42 - 16, 30 - 16, 18, 6)), seven);
+	__m256i selectors1 = _mm256_and_si256(_mm256_srlv_epi32(_mm256_blend_epi32(low, high, 0x11),
+		_mm256_setr_epi32(39 - 16, 27, 15, 3, 36 - 16, 24, 12, 0)), seven);
+	values_out[0] = _mm256_permutevar8x32_epi32(value_table, selectors0);
+	values_out[1] = _mm256_permutevar8x32_epi32(value_table, selectors1);
+}
+
+// Decode the EAC channels of consecutive blocks until a block is encountered that is not
+// handled by the SIMD code path. For ETC2_EAC, only the alpha channel is decoded. Returns
+// the number of blocks decoded.
+static DETEX_TARGET_AVX2 int DecodeBlocksEACAVX2(const uint8_t * DETEX_RESTRICT bitstring,
+int nu_blocks, int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int block_size = (type == EAC_BATCH_TYPE_R11 || type == EAC_BATCH_TYPE_SIGNED_R11) ? 8 : 16;
+	int pixel_block_size = block_size == 8 ? 32 : 64;
+	int i;
+	for (i = 0; i < nu_blocks; i++) {
+		uint64_t qword[2];
+		__m128i values[2];
+		if (!CalculateValuesEACSSE2(bitstring, type, qword, values))
+			break;
+		__m256i pixels0[2];
+		ExpandSelectorsEACAVX2(values[0], qword[0], pixels0);
+		if (type == EAC_BATCH_TYPE_ETC2_EAC) {
+			// Replace the alpha components of the decompressed color pixels.
+			__m256i color_mask = _mm256_set1_epi32(0x00FFFFFF);
+			for (int j = 0; j < 2; j++) {
+				__m256i *p = (__m256i *)(pixel_buffer + j * 32);
+				_mm256_storeu_si256(p, _mm256_or_si256(
+					_mm256_and_si256(_mm256_loadu_si256(p), color_mask),
+					_mm256_slli_epi32(pixels0[j], 24)));
+			}
+		}
+		else if (block_size == 8)
+			// Pack the 16-bit values, restoring the order of the 64-bit lanes.
+			_mm256_storeu_si256((__m256i *)pixel_buffer, _mm256_permute4x64_epi64(
+				_mm256_packus_epi32(pixels0[0], pixels0[1]), 0xD8));
+		else {
+			__m256i pixels1[2];
+			ExpandSelectorsEACAVX2(values[1], qword[1], pixels1);
+			for (int j = 0; j < 2; j++)
+				_mm256_storeu_si256((__m256i *)(pixel_buffer + j * 32),
+					_mm256_or_si256(pixels0[j], _mm256_slli_epi32(pixels1[j], 16)));
+		}
+		bitstring += block_size;
+		pixel_buffer += pixel_block_size;
+	}
+	return i;
+}
+
+#endif
+
+// Decompress the color parts of up to ETC2_EAC_COLOR_RUN consecutive ETC2_EAC blocks with
+// the ETC2 batch function. Returns the number of blocks decompressed, or zero when any of
+// the blocks could not be decompressed.
+static int DecompressColorBlocksETC2_EAC(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	uint8_t color_bitstring[ETC2_EAC_COLOR_RUN * 8];
+	if (nu_blocks > ETC2_EAC_COLOR_RUN)
+		nu_blocks = ETC2_EAC_COLOR_RUN;
+	for (int i = 0; i < nu_blocks; i++)
+		memcpy(color_bitstring + i * 8, bitstring + i * 16 + 8, 8);
+	if (!detexDecompressBlocksETC2(color_bitstring, nu_blocks, mode_mask, 0, pixel_buffer))
+		return 0;
+	return nu_blocks;
+}
+
+// Without SIMD, all blocks are decompressed by the scalar code.
+static int DecodeBlocksEACNone(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks, int type,
+uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return 0;
+}
+
+DETEX_DEFINE_KERNEL(DecodeBlocksEACKernel, int, (const uint8_t * DETEX_RESTRICT bitstring,
+	int nu_blocks, int type, uint8_t * DETEX_RESTRICT pixel_buffer),
+	(bitstring, nu_blocks, type, pixel_buffer))
+
+void detexSelectEACKernels(int level) {
+	int (*kernel)(const uint8_t * DETEX_RESTRICT, int, int, uint8_t * DETEX_RESTRICT) =
+		DecodeBlocksEACNone;
+#ifdef DETEX_USE_SSE2
+	if (level >= DETEX_SIMD_LEVEL_SSE2)
+		kernel = DecodeBlocksEACSSE2;
+#endif
+#ifdef DETEX_USE_AVX2
+	if (level >= DETEX_SIMD_LEVEL_AVX2)
+		kernel = DecodeBlocksEACAVX2;
+#endif
+	DETEX_SET_KERNEL(DecodeBlocksEACKernel, kernel);
+}
+
+static bool DecompressBlocksEAC(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer, int type) {
+	int block_size = (type == EAC_BATCH_TYPE_R11 || type == EAC_BATCH_TYPE_SIGNED_R11) ? 8 : 16;
+	int pixel_block_size = block_size == 8 ? 32 : 64;
+	// The SIMD code paths do not handle the flags that can reject blocks.
+	int (*kernel)(const uint8_t * DETEX_RESTRICT, int, int, uint8_t * DETEX_RESTRICT) =
+		DETEX_GET_KERNEL(DecodeBlocksEACKernel);
+	bool use_simd = flags == 0 && kernel != DecodeBlocksEACNone;
+	bool result = true;
+	int i = 0;
+	while (i < nu_blocks) {
+		if (use_simd) {
+			int n = nu_blocks - i;
+			if (type == EAC_BATCH_TYPE_ETC2_EAC)
+				n = DecompressColorBlocksETC2_EAC(bitstring + i * block_size, n, mode_mask,
+					pixel_buffer + i * pixel_block_size);
+			n = kernel(bitstring + i * block_size, n, type, pixel_buffer + i * pixel_block_size);
+			i += n;
+			if (i == nu_blocks)
+				break;
+			// The alpha channel of ETC2_EAC blocks is always handled, so continue with the
+			// next run of color blocks.
+			if (type == EAC_BATCH_TYPE_ETC2_EAC && n > 0)
+				continue;
+		}
+		// Decompress the next block, which was not handled by the SIMD code path.
+		const uint8_t *block = bitstring + i * block_size;
+		uint8_t *pixels = pixel_buffer + i * pixel_block_size;
+		bool r;
+		switch (type) {
+		case EAC_BATCH_TYPE_ETC2_EAC :
+			r = detexDecompressBlockETC2_EAC(block, mode_mask, flags, pixels);
+			break;
+		case EAC_BATCH_TYPE_R11 :
+			r = detexDecompressBlockEAC_R11(block, mode_mask, flags, pixels);
+			break;
+		case EAC_BATCH_TYPE_SIGNED_R11 :
+			r = detexDecompressBlockEAC_SIGNED_R11(block, mode_mask, flags, pixels);
+			break;
+		case EAC_BATCH_TYPE_RG11 :
+			r = detexDecompressBlockEAC_RG11(block, mode_mask, flags, pixels);
+			break;
+		default :
+			r = detexDecompressBlockEAC_SIGNED_RG11(block, mode_mask, flags, pixels);
+			break;
+		}
+		if (!r) {
+			result = false;
+			memset(pixels, 0, pixel_block_size);
+		}
+		i++;
+	}
+	return result;
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the */
+/* ETC2_EAC format. */
+bool detexDecompressBlocksETC2_EAC(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksEAC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		EAC_BATCH_TYPE_ETC2_EAC);
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the */
+/* EAC_R11 format. */
+bool detexDecompressBlocksEAC_R11(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksEAC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		EAC_BATCH_TYPE_R11);
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the */
+/* EAC_SIGNED_R11 format. */
+bool detexDecompressBlocksEAC_SIGNED_R11(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksEAC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		EAC_BATCH_TYPE_SIGNED_R11);
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the */
+/* EAC_RG11 format. */
+bool detexDecompressBlocksEAC_RG11(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksEAC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		EAC_BATCH_TYPE_RG11);
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the */
+/* EAC_SIGNED_RG11 format. */
+bool detexDecompressBlocksEAC_SIGNED_RG11(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksEAC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		EAC_BATCH_TYPE_SIGNED_RG11);
+}
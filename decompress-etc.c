@@ -16,7 +16,10 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 */
 
+#include <string.h>
+
 #include "detex.h"
+#include "simd.h"
 
 static const int complement3bitshifted_table[8] = {
 	0, 8, 16, 24, -32, -24, -16, -8
@@ -284,8 +287,9 @@ uint8_t * DETEX_RESTRICT pixel_buffer) {
 	}
 }
 
-static void ProcessBlockETC2PlanarMode(const uint8_t * DETEX_RESTRICT bitstring,
-uint8_t * DETEX_RESTRICT pixel_buffer) {
+// Decode the colors O, H and V of a planar mode block, expanded to 8 bits.
+static DETEX_INLINE_ONLY void DecodeColorsETC2PlanarMode(const uint8_t * DETEX_RESTRICT bitstring,
+int *color_O, int *color_H, int *color_V) {
 	// Each color O, H and V is in 6-7-6 format.
 	int RO = (bitstring[0] & 0x7E) >> 1;
 	int GO = ((bitstring[0] & 0x1) << 6) | ((bitstring[1] & 0x7E) >> 1);
@@ -306,6 +310,24 @@ uint8_t * DETEX_RESTRICT pixel_buffer) {
 	RV = (RV << 2) | ((RV & 0x30) >> 4);
 	GV = (GV << 1) | ((GV & 0x40) >> 6);
 	BV = (BV << 2) | ((BV & 0x30) >> 4);
+	color_O[0] = RO;
+	color_O[1] = GO;
+	color_O[2] = BO;
+	color_H[0] = RH;
+	color_H[1] = GH;
+	color_H[2] = BH;
+	color_V[0] = RV;
+	color_V[1] = GV;
+	color_V[2] = BV;
+}
+
+static void ProcessBlockETC2PlanarMode(const uint8_t * DETEX_RESTRICT bitstring,
+uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int O[3], H[3], V[3];
+	DecodeColorsETC2PlanarMode(bitstring, O, H, V);
+	int RO = O[0], GO = O[1], BO = O[2];
+	int RH = H[0], GH = H[1], BH = H[2];
+	int RV = V[0], GV = V[1], BV = V[2];
 	uint32_t *buffer = (uint32_t *)pixel_buffer;
 	for (int y = 0; y < 4; y++)
 		for (int x = 0; x < 4; x++) {
@@ -750,3 +772,397 @@ uint32_t *colors) {
 	SetModeETC2THP(bitstring, flags);
 }
 
+
+// Batch decompression of consecutive ETC1, ETC2 and ETC2_PUNCHTHROUGH blocks. The SIMD code
+// paths represent every block other than a planar mode block by a palette of eight colors
+// (four for each subblock), which is calculated with saturating byte additions and
+// subtractions instead of clamps. The 2-bit pixel indices are expanded using permutes (AVX2)
+// or palette lookups (SSE2). Planar mode blocks are interpolated using 16-bit arithmetic.
+// The results are identical to the single block functions above.
+
+enum {
+	ETC_BATCH_TYPE_ETC1,
+	ETC_BATCH_TYPE_ETC2,
+	ETC_BATCH_TYPE_ETC2_PUNCHTHROUGH
+};
+
+#ifdef DETEX_USE_SSE2
+
+enum {
+	ETC_BLOCK_PALETTE,
+	ETC_BLOCK_PLANAR,
+	ETC_BLOCK_UNSUPPORTED
+};
+
+#define REPLICATE_RGB8(x) ((uint32_t)(x) * 0x010101)
+
+// For each table codeword, the modifiers that are added to the base color (palette entries
+// 0 and 1) and subtracted from it (palette entries 2 and 3), replicated in the RGB bytes.
+static const uint32_t modifier_add_table[8][4] = {
+	{ REPLICATE_RGB8(2), REPLICATE_RGB8(8), 0, 0 },
+	{ REPLICATE_RGB8(5), REPLICATE_RGB8(17), 0, 0 },
+	{ REPLICATE_RGB8(9), REPLICATE_RGB8(29), 0, 0 },
+	{ REPLICATE_RGB8(13), REPLICATE_RGB8(42), 0, 0 },
+	{ REPLICATE_RGB8(18), REPLICATE_RGB8(60), 0, 0 },
+	{ REPLICATE_RGB8(24), REPLICATE_RGB8(80), 0, 0 },
+	{ REPLICATE_RGB8(33), REPLICATE_RGB8(106), 0, 0 },
+	{ REPLICATE_RGB8(47), REPLICATE_RGB8(183), 0, 0 }
+};
+
+static const uint32_t modifier_subtract_table[8][4] = {
+	{ 0, 0, REPLICATE_RGB8(2), REPLICATE_RGB8(8) },
+	{ 0, 0, REPLICATE_RGB8(5), REPLICATE_RGB8(17) },
+	{ 0, 0, REPLICATE_RGB8(9), REPLICATE_RGB8(29) },
+	{ 0, 0, REPLICATE_RGB8(13), REPLICATE_RGB8(42) },
+	{ 0, 0, REPLICATE_RGB8(18), REPLICATE_RGB8(60) },
+	{ 0, 0, REPLICATE_RGB8(24), REPLICATE_RGB8(80) },
+	{ 0, 0, REPLICATE_RGB8(33), REPLICATE_RGB8(106) },
+	{ 0, 0, REPLICATE_RGB8(47), REPLICATE_RGB8(183) }
+};
+
+// Calculate clamp(base + add - subtract) for each byte, where at most one of add and
+// subtract is non-zero.
+static DETEX_INLINE_ONLY __m128i ApplyModifiersSSE2(__m128i base, __m128i add, __m128i subtract) {
+	return _mm_subs_epu8(_mm_adds_epu8(base, add), subtract);
+}
+
+// Calculate the palette of a subblock in individual or differential mode. In punchthrough
+// mode, entries 0 and 2 have no modifier and entry 2 is transparent.
+static DETEX_INLINE_ONLY __m128i CalculateSubblockPaletteSSE2(uint32_t base_color, int table_codeword,
+bool punchthrough) {
+	__m128i add = _mm_loadu_si128((__m128i *)modifier_add_table[table_codeword]);
+	__m128i subtract = _mm_loadu_si128((__m128i *)modifier_subtract_table[table_codeword]);
+	if (punchthrough) {
+		add = _mm_and_si128(add, _mm_setr_epi32(0, -1, 0, 0));
+		subtract = _mm_and_si128(subtract, _mm_setr_epi32(0, 0, 0, -1));
+		return _mm_and_si128(ApplyModifiersSSE2(_mm_set1_epi32(base_color), add, subtract),
+			_mm_setr_epi32(-1, -1, 0, -1));
+	}
+	return ApplyModifiersSSE2(_mm_set1_epi32(base_color), add, subtract);
+}
+
+// Decode the second base color of a differential mode block, returning false when a
+// component overflows.
+static DETEX_INLINE_ONLY bool DecodeDifferentialBaseColor(const uint8_t * DETEX_RESTRICT bitstring,
+uint32_t *color) {
+	int c[3];
+	for (int i = 0; i < 3; i++) {
+		c[i] = (bitstring[i] & 0xF8) + complement3bitshifted(bitstring[i] & 7);
+		if (c[i] & 0xFF07)
+			return false;
+		c[i] |= (c[i] & 224) >> 5;
+	}
+	*color = detexPack32RGB8Alpha0xFF(c[0], c[1], c[2]);
+	return true;
+}
+
+// Calculate the palette of an ETC1, ETC2 or ETC2_PUNCHTHROUGH block that is not in planar
+// mode. palette_out[0] holds the palette of the first subblock and palette_out[1] that of the
+// second subblock. *split_mask_out is set to the bit of the pixel number that selects the
+// second subblock (zero for T and H mode blocks, which only use the first palette). Returns
+// ETC_BLOCK_PLANAR for planar mode blocks and ETC_BLOCK_UNSUPPORTED for invalid blocks,
+// which are left to the single block functions.
+static DETEX_INLINE_ONLY int CalculatePaletteETC(const uint8_t * DETEX_RESTRICT bitstring, int type,
+__m128i *palette_out, int *split_mask_out) {
+	// For ETC2_PUNCHTHROUGH, the differential bit is the opaque bit.
+	bool differential = (bitstring[3] & 2) != 0;
+	bool punchthrough = type == ETC_BATCH_TYPE_ETC2_PUNCHTHROUGH && !differential;
+	int mode;
+	if (type == ETC_BATCH_TYPE_ETC1 || (type == ETC_BATCH_TYPE_ETC2 && !differential))
+		mode = differential ? DETEX_MODE_MASK_ETC_DIFFERENTIAL : DETEX_MODE_MASK_ETC_INDIVIDUAL;
+	else {
+		int R = (bitstring[0] & 0xF8) + complement3bitshifted(bitstring[0] & 7);
+		int G = (bitstring[1] & 0xF8) + complement3bitshifted(bitstring[1] & 7);
+		int B = (bitstring[2] & 0xF8) + complement3bitshifted(bitstring[2] & 7);
+		if (R & 0xFF07)
+			mode = DETEX_MODE_MASK_ETC_T;
+		else if (G & 0xFF07)
+			mode = DETEX_MODE_MASK_ETC_H;
+		else if (B & 0xFF07)
+			return ETC_BLOCK_PLANAR;
+		else
+			mode = DETEX_MODE_MASK_ETC_DIFFERENTIAL;
+	}
+	uint32_t base_color1, base_color2;
+	if (mode == DETEX_MODE_MASK_ETC_INDIVIDUAL || mode == DETEX_MODE_MASK_ETC_DIFFERENTIAL) {
+		if (mode == DETEX_MODE_MASK_ETC_INDIVIDUAL) {
+			base_color1 = detexPack32RGB8Alpha0xFF(
+				(bitstring[0] & 0xF0) | (bitstring[0] >> 4),
+				(bitstring[1] & 0xF0) | (bitstring[1] >> 4),
+				(bitstring[2] & 0xF0) | (bitstring[2] >> 4));
+			base_color2 = detexPack32RGB8Alpha0xFF(
+				((bitstring[0] & 0x0F) << 4) | (bitstring[0] & 0x0F),
+				((bitstring[1] & 0x0F) << 4) | (bitstring[1] & 0x0F),
+				((bitstring[2] & 0x0F) << 4) | (bitstring[2] & 0x0F));
+		}
+		else {
+			base_color1 = detexPack32RGB8Alpha0xFF(
+				(bitstring[0] & 0xF8) | (bitstring[0] >> 5),
+				(bitstring[1] & 0xF8) | (bitstring[1] >> 5),
+				(bitstring[2] & 0xF8) | (bitstring[2] >> 5));
+			if (!DecodeDifferentialBaseColor(bitstring, &base_color2))
+				return ETC_BLOCK_UNSUPPORTED;
+		}
+		palette_out[0] = CalculateSubblockPaletteSSE2(base_color1, bitstring[3] >> 5,
+			punchthrough);
+		palette_out[1] = CalculateSubblockPaletteSSE2(base_color2, (bitstring[3] >> 2) & 7,
+			punchthrough);
+		// The flip bit selects whether the subblocks are side by side (2x4) or stacked (4x2).
+		*split_mask_out = (bitstring[3] & 1) ? 2 : 8;
+		return ETC_BLOCK_PALETTE;
+	}
+	__m128i base, add, subtract;
+	if (mode == DETEX_MODE_MASK_ETC_T) {
+		int R1 = ((bitstring[0] & 0x18) >> 1) | (bitstring[0] & 0x3);
+		base_color1 = detexPack32RGB8Alpha0xFF(R1 | (R1 << 4),
+			(bitstring[1] & 0xF0) | (bitstring[1] >> 4),
+			(bitstring[1] & 0x0F) | ((bitstring[1] & 0x0F) << 4));
+		base_color2 = detexPack32RGB8Alpha0xFF(
+			(bitstring[2] & 0xF0) | (bitstring[2] >> 4),
+			(bitstring[2] & 0x0F) | ((bitstring[2] & 0x0F) << 4),
+			(bitstring[3] & 0xF0) | (bitstring[3] >> 4));
+		uint32_t distance = REPLICATE_RGB8(etc2_distance_table[((bitstring[3] & 0x0C) >> 1) |
+			(bitstring[3] & 0x1)]);
+		base = _mm_setr_epi32(base_color1, base_color2, base_color2, base_color2);
+		add = _mm_setr_epi32(0, distance, 0, 0);
+		subtract = _mm_setr_epi32(0, 0, 0, distance);
+	}
+	else {
+		int R1 = (bitstring[0] & 0x78) >> 3;
+		int G1 = ((bitstring[0] & 0x07) << 1) | ((bitstring[1] & 0x10) >> 4);
+		int B1 = (bitstring[1] & 0x08) | ((bitstring[1] & 0x03) << 1) | ((bitstring[2] & 0x80) >> 7);
+		int R2 = (bitstring[2] & 0x78) >> 3;
+		int G2 = ((bitstring[2] & 0x07) << 1) | ((bitstring[3] & 0x80) >> 7);
+		int B2 = (bitstring[3] & 0x78) >> 3;
+		R1 |= R1 << 4;
+		G1 |= G1 << 4;
+		B1 |= B1 << 4;
+		R2 |= R2 << 4;
+		G2 |= G2 << 4;
+		B2 |= B2 << 4;
+		int bit = ((R1 << 16) + (G1 << 8) + B1) >= ((R2 << 16) + (G2 << 8) + B2);
+		uint32_t distance = REPLICATE_RGB8(etc2_distance_table[(bitstring[3] & 0x04) |
+			((bitstring[3] & 0x01) << 1) | bit]);
+		base_color1 = detexPack32RGB8Alpha0xFF(R1, G1, B1);
+		base_color2 = detexPack32RGB8Alpha0xFF(R2, G2, B2);
+		base = _mm_setr_epi32(base_color1, base_color1, base_color2, base_color2);
+		add = _mm_setr_epi32(distance, 0, distance, 0);
+		subtract = _mm_setr_epi32(0, distance, 0, distance);
+	}
+	palette_out[0] = ApplyModifiersSSE2(base, add, subtract);
+	if (punchthrough)
+		palette_out[0] = _mm_and_si128(palette_out[0], _mm_setr_epi32(-1, -1, 0, -1));
+	palette_out[1] = palette_out[0];
+	*split_mask_out = 0;
+	return ETC_BLOCK_PALETTE;
+}
+
+// Decompress a planar mode block. The components are interpolated for two pixels at a time
+// in 16-bit lanes and clamped by packing with unsigned saturation.
+static DETEX_INLINE_ONLY void ProcessBlockETC2PlanarModeSSE2(const uint8_t * DETEX_RESTRICT bitstring,
+uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int O[3], H[3], V[3];
+	DecodeColorsETC2PlanarMode(bitstring, O, H, V);
+	__m128i color_O = _mm_setr_epi16(O[0], O[1], O[2], 0, O[0], O[1], O[2], 0);
+	__m128i delta_H = _mm_setr_epi16(H[0] - O[0], H[1] - O[1], H[2] - O[2], 0,
+		H[0] - O[0], H[1] - O[1], H[2] - O[2], 0);
+	__m128i delta_V = _mm_setr_epi16(V[0] - O[0], V[1] - O[1], V[2] - O[2], 0,
+		V[0] - O[0], V[1] - O[1], V[2] - O[2], 0);
+	// Calculate x * (H - O) + 4 * O + 2 for the pixels of the first row.
+	__m128i offset = _mm_add_epi16(_mm_slli_epi16(color_O, 2), _mm_set1_epi16(2));
+	__m128i value01 = _mm_add_epi16(offset, _mm_mullo_epi16(delta_H,
+		_mm_setr_epi16(0, 0, 0, 0, 1, 1, 1, 1)));
+	__m128i value23 = _mm_add_epi16(offset, _mm_mullo_epi16(delta_H,
+		_mm_setr_epi16(2, 2, 2, 2, 3, 3, 3, 3)));
+	__m128i alpha = _mm_set1_epi32(0xFF000000);
+	for (int y = 0; y < 4; y++) {
+		__m128i pixels = _mm_packus_epi16(_mm_srai_epi16(value01, 2), _mm_srai_epi16(value23, 2));
+		_mm_storeu_si128((__m128i *)(pixel_buffer + y * 16), _mm_or_si128(pixels, alpha));
+		value01 = _mm_add_epi16(value01, delta_V);
+		value23 = _mm_add_epi16(value23, delta_V);
+	}
+}
+
+static DETEX_INLINE_ONLY uint32_t GetPixelIndexWordETC(const uint8_t * DETEX_RESTRICT bitstring) {
+	return ((uint32_t)bitstring[4] << 24) | ((uint32_t)bitstring[5] << 16) |
+		((uint32_t)bitstring[6] << 8) | bitstring[7];
+}
+
+// Expand the pixel indices of a block using the palettes of the subblocks and store the 16
+// pixels. Pixels are numbered in column-major order within the block.
+static DETEX_INLINE_ONLY void ExpandPixelIndicesETCSSE2(const __m128i *palette,
+uint32_t pixel_index_word, int split_mask, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	uint32_t palette_entries[8];
+	_mm_storeu_si128((__m128i *)palette_entries, palette[0]);
+	_mm_storeu_si128((__m128i *)(palette_entries + 4), palette[1]);
+	uint32_t *buffer = (uint32_t *)pixel_buffer;
+	for (int i = 0; i < 16; i++) {
+		int index = ((pixel_index_word >> i) & 1) | ((pixel_index_word >> (i + 15)) & 2);
+		if (i & split_mask)
+			index += 4;
+		buffer[(i & 3) * 4 + (i >> 2)] = palette_entries[index];
+	}
+}
+
+// Decompress consecutive blocks until a block is encountered that is not handled by the
+// SIMD code path. Returns the number of blocks decompressed.
+static int DecompressBlocksETCSSE2(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int i;
+	for (i = 0; i < nu_blocks; i++) {
+		__m128i palette[2];
+		int split_mask;
+		int block_type = CalculatePaletteETC(bitstring, type, palette, &split_mask);
+		if (block_type == ETC_BLOCK_UNSUPPORTED)
+			break;
+		if (block_type == ETC_BLOCK_PLANAR)
+			ProcessBlockETC2PlanarModeSSE2(bitstring, pixel_buffer);
+		else
+			ExpandPixelIndicesETCSSE2(palette, GetPixelIndexWordETC(bitstring), split_mask,
+				pixel_buffer);
+		bitstring += 8;
+		pixel_buffer += 64;
+	}
+	return i;
+}
+
+#endif
+
+#ifdef DETEX_USE_AVX2
+
+// Expand the pixel indices of a block with two eight-lane permutes of the combined palettes
+// of the subblocks, and store the 16 pixels.
+static DETEX_INLINE_ONLY DETEX_TARGET_AVX2 void ExpandPixelIndicesETCAVX2(const __m128i *palette,
+uint32_t pixel_index_word, int split_mask, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	__m256i palette256 = _mm256_inserti128_si256(_mm256_castsi128_si256(palette[0]),
+		palette[1], 1);
+	__m256i word = _mm256_set1_epi32(pixel_index_word);
+	__m256i split = _mm256_set1_epi32(split_mask);
+	// Pixel numbers of the first two and the last two rows of the block.
+	__m256i pixel_number[2];
+	pixel_number[0] = _mm256_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13);
+	pixel_number[1] = _mm256_setr_epi32(2, 6, 10, 14, 3, 7, 11, 15);
+	for (int j = 0; j < 2; j++) {
+		__m256i index = _mm256_or_si256(
+			_mm256_and_si256(_mm256_srlv_epi32(word, pixel_number[j]), _mm256_set1_epi32(1)),
+			_mm256_and_si256(_mm256_srlv_epi32(word, _mm256_add_epi32(pixel_number[j],
+			_mm256_set1_epi32(15))), _mm256_set1_epi32(2)));
+		__m256i second_subblock = _mm256_cmpeq_epi32(_mm256_and_si256(pixel_number[j], split),
+			_mm256_setzero_si256());
+		index = _mm256_or_si256(index, _mm256_andnot_si256(second_subblock, _mm256_set1_epi32(4)));
+		_mm256_storeu_si256((__m256i *)(pixel_buffer + j * 32),
+			_mm256_permutevar8x32_epi32(palette256, index));
+	}
+}
+
+// Decompress consecutive blocks until a block is encountered that is not handled by the
+// SIMD code path. Returns the number of blocks decompressed.
+static DETEX_TARGET_AVX2 int DecompressBlocksETCAVX2(const uint8_t * DETEX_RESTRICT bitstring,
+int nu_blocks, int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int i;
+	for (i = 0; i < nu_blocks; i++) {
+		__m128i palette[2];
+		int split_mask;
+		int block_type = CalculatePaletteETC(bitstring, type, palette, &split_mask);
+		if (block_type == ETC_BLOCK_UNSUPPORTED)
+			break;
+		if (block_type == ETC_BLOCK_PLANAR)
+			ProcessBlockETC2PlanarModeSSE2(bitstring, pixel_buffer);
+		else
+			ExpandPixelIndicesETCAVX2(palette, GetPixelIndexWordETC(bitstring), split_mask,
+				pixel_buffer);
+		bitstring += 8;
+		pixel_buffer += 64;
+	}
+	return i;
+}
+
+#endif
+
+// Without SIMD, all blocks are decompressed by the scalar code.
+static int DecompressBlocksETCNone(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return 0;
+}
+
+DETEX_DEFINE_KERNEL(DecompressBlocksETCKernel, int, (const uint8_t * DETEX_RESTRICT bitstring,
+	int nu_blocks, int type, uint8_t * DETEX_RESTRICT pixel_buffer),
+	(bitstring, nu_blocks, type, pixel_buffer))
+
+void detexSelectETCKernels(int level) {
+	int (*kernel)(const uint8_t * DETEX_RESTRICT, int, int, uint8_t * DETEX_RESTRICT) =
+		DecompressBlocksETCNone;
+#ifdef DETEX_USE_SSE2
+	if (level >= DETEX_SIMD_LEVEL_SSE2)
+		kernel = DecompressBlocksETCSSE2;
+#endif
+#ifdef DETEX_USE_AVX2
+	if (level >= DETEX_SIMD_LEVEL_AVX2)
+		kernel = DecompressBlocksETCAVX2;
+#endif
+	DETEX_SET_KERNEL(DecompressBlocksETCKernel, kernel);
+}
+
+static bool DecompressBlocksETC(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer, int type) {
+	uint32_t all_modes;
+	if (type == ETC_BATCH_TYPE_ETC1)
+		all_modes = DETEX_MODE_MASK_ALL_MODES_ETC1;
+	else if (type == ETC_BATCH_TYPE_ETC2)
+		all_modes = DETEX_MODE_MASK_ALL_MODES_ETC2;
+	else
+		all_modes = DETEX_MODE_MASK_ALL_MODES_ETC2_PUNCHTHROUGH;
+	// The SIMD code paths do not handle the flags and mode masks that can reject blocks.
+	int (*kernel)(const uint8_t * DETEX_RESTRICT, int, int, uint8_t * DETEX_RESTRICT) =
+		DETEX_GET_KERNEL(DecompressBlocksETCKernel);
+	bool use_simd = flags == 0 && (mode_mask & all_modes) == all_modes &&
+		kernel != DecompressBlocksETCNone;
+	bool result = true;
+	int i = 0;
+	while (i < nu_blocks) {
+		if (use_simd) {
+			i += kernel(bitstring + i * 8, nu_blocks - i, type, pixel_buffer + i * 64);
+			if (i == nu_blocks)
+				break;
+		}
+		// Decompress the next block, which was not handled by the SIMD code path.
+		bool r;
+		if (type == ETC_BATCH_TYPE_ETC1)
+			r = detexDecompressBlockETC1(bitstring + i * 8, mode_mask, flags, pixel_buffer + i * 64);
+		else if (type == ETC_BATCH_TYPE_ETC2)
+			r = detexDecompressBlockETC2(bitstring + i * 8, mode_mask, flags, pixel_buffer + i * 64);
+		else
+			r = detexDecompressBlockETC2_PUNCHTHROUGH(bitstring + i * 8, mode_mask, flags,
+				pixel_buffer + i * 64);
+		if (!r) {
+			result = false;
+			memset(pixel_buffer + i * 64, 0, 64);
+		}
+		i++;
+	}
+	return result;
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the ETC1 */
+/* format. */
+bool detexDecompressBlocksETC1(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksETC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		ETC_BATCH_TYPE_ETC1);
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the ETC2 */
+/* format. */
+bool detexDecompressBlocksETC2(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksETC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		ETC_BATCH_TYPE_ETC2);
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the */
+/* ETC2_PUNCHTHROUGH format. */
+bool detexDecompressBlocksETC2_PUNCHTHROUGH(const uint8_t * DETEX_RESTRICT bitstring,
+int nu_blocks, uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksETC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		ETC_BATCH_TYPE_ETC2_PUNCHTHROUGH);
+}
@@ -16,7 +16,30 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 */
 
+#include <string.h>
+
 #include "detex.h"
+#include "simd.h"
+
+// Calculate the eight possible values of an unsigned RGTC block channel, one for each
+// 3-bit control code.
+static DETEX_INLINE_ONLY void CalculatePaletteRGTC(const uint8_t * DETEX_RESTRICT bitstring,
+uint8_t * DETEX_RESTRICT palette) {
+	int lum0 = bitstring[0];
+	int lum1 = bitstring[1];
+	palette[0] = lum0;
+	palette[1] = lum1;
+	if (lum0 > lum1) {
+		for (int i = 2; i < 8; i++)
+			palette[i] = detexDivide0To1791By7((8 - i) * lum0 + (i - 1) * lum1);
+	}
+	else {
+		for (int i = 2; i < 6; i++)
+			palette[i] = detexDivide0To1279By5((6 - i) * lum0 + (i - 1) * lum1);
+		palette[6] = 0;
+		palette[7] = 0xFF;
+	}
+}
 
 // For each pixel, decode an 8-bit integer and store as follows:
 // If shift and offset are zero, store each value in consecutive 8 bit values in pixel_buffer.
@@ -27,34 +50,10 @@ static DETEX_INLINE_ONLY void DecodeBlockRGTC(const uint8_t * DETEX_RESTRICT bit
 int offset, uint8_t * DETEX_RESTRICT pixel_buffer) {
 	// LSBFirst byte order only.
 	uint64_t bits = (*(uint64_t *)&bitstring[0]) >> 16;
-	int lum0 = bitstring[0];
-	int lum1 = bitstring[1];
+	uint8_t palette[8];
+	CalculatePaletteRGTC(bitstring, palette);
 	for (int i = 0; i < 16; i++) {
-		int control_code = bits & 0x7;
-		uint8_t output;
-		if (lum0 > lum1)
-			switch (control_code) {
-			case 0 : output = lum0; break;
-			case 1 : output = lum1; break;
-			case 2 : output = detexDivide0To1791By7(6 * lum0 + lum1); break;
-			case 3 : output = detexDivide0To1791By7(5 * lum0 + 2 * lum1); break;
-			case 4 : output = detexDivide0To1791By7(4 * lum0 + 3 * lum1); break;
-			case 5 : output = detexDivide0To1791By7(3 * lum0 + 4 * lum1); break;
-			case 6 : output = detexDivide0To1791By7(2 * lum0 + 5 * lum1); break;
-			case 7 : output = detexDivide0To1791By7(lum0 + 6 * lum1); break;
-			}
-		else
-			switch (control_code) {
-			case 0 : output = lum0; break;
-			case 1 : output = lum1; break;
-			case 2 : output = detexDivide0To1279By5(4 * lum0 + lum1); break;
-			case 3 : output = detexDivide0To1279By5(3 * lum0 + 2 * lum1); break;
-			case 4 : output = detexDivide0To1279By5(2 * lum0 + 3 * lum1); break;
-			case 5 : output = detexDivide0To1279By5(lum0 + 4 * lum1); break;
-			case 6 : output = 0; break;
-			case 7 : output = 0xFF; break;
-			}
-		pixel_buffer[(i << shift) + offset] = output;
+		pixel_buffer[(i << shift) + offset] = palette[bits & 0x7];
 		bits >>= 3;
 	}
 }
@@ -76,15 +75,10 @@ uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
 	return true;
 }
 
-// For each pixel, decode an 16-bit integer and store as follows:
-// If shift and offset are zero, store each value in consecutive 16 bit values in pixel_buffer.
-// If shift is one, store each value in consecutive 32-bit words in pixel_buffer; if offset
-// is zero, store it in the first 16 bits, if offset is one store it in the last 16 bits of each
-// 32-bit word. Returns true if the compressed block is valid.
-static DETEX_INLINE_ONLY bool DecodeBlockSignedRGTC(const uint8_t * DETEX_RESTRICT bitstring, int shift,
-int offset, uint8_t * DETEX_RESTRICT pixel_buffer) {
-	// LSBFirst byte order only.
-	uint64_t bits = (*(uint64_t *)&bitstring[0]) >> 16;
+// Calculate the eight possible values of a signed RGTC block channel, one for each 3-bit
+// control code, mapped to 16-bit signed integers. Returns false if the block is invalid.
+static DETEX_INLINE_ONLY bool CalculatePaletteSignedRGTC(const uint8_t * DETEX_RESTRICT bitstring,
+uint16_t * DETEX_RESTRICT palette) {
 	int lum0 = (int8_t)bitstring[0];
 	int lum1 = (int8_t)bitstring[1];
 	if (lum0 == - 127 && lum1 == - 128)
@@ -95,35 +89,40 @@ int offset, uint8_t * DETEX_RESTRICT pixel_buffer) {
 	if (lum1 == - 128)
 		lum1 = - 127;
 	// Note: values are mapped to a red value of -127 to 127.
+	int result[8];
+	result[0] = lum0;
+	result[1] = lum1;
+	if (lum0 > lum1) {
+		for (int i = 2; i < 8; i++)
+			result[i] = detexDivideMinus895To895By7((8 - i) * lum0 + (i - 1) * lum1);
+	}
+	else {
+		for (int i = 2; i < 6; i++)
+			result[i] = detexDivideMinus639To639By5((6 - i) * lum0 + (i - 1) * lum1);
+		result[6] = - 127;
+		result[7] = 127;
+	}
+	// Map from [-127, 127] to [-32768, 32767].
+	for (int i = 0; i < 8; i++)
+		palette[i] = (uint16_t)(int16_t)((result[i] + 127) * 65535 / 254 - 32768);
+	return true;
+}
+
+// For each pixel, decode an 16-bit integer and store as follows:
+// If shift and offset are zero, store each value in consecutive 16 bit values in pixel_buffer.
+// If shift is one, store each value in consecutive 32-bit words in pixel_buffer; if offset
+// is zero, store it in the first 16 bits, if offset is one store it in the last 16 bits of each
+// 32-bit word. Returns true if the compressed block is valid.
+static DETEX_INLINE_ONLY bool DecodeBlockSignedRGTC(const uint8_t * DETEX_RESTRICT bitstring, int shift,
+int offset, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	// LSBFirst byte order only.
+	uint64_t bits = (*(uint64_t *)&bitstring[0]) >> 16;
+	uint16_t palette[8];
+	if (!CalculatePaletteSignedRGTC(bitstring, palette))
+		return false;
 	uint16_t *pixel16_buffer = (uint16_t *)pixel_buffer;
 	for (int i = 0; i < 16; i++) {
-		int control_code = bits & 0x7;
-		int32_t result;
-		if (lum0 > lum1)
-			switch (control_code) {
-			case 0 : result = lum0; break;
-			case 1 : result = lum1; break;
-			case 2 : result = detexDivideMinus895To895By7(6 * lum0 + lum1); break;
-			case 3 : result = detexDivideMinus895To895By7(5 * lum0 + 2 * lum1); break;
-			case 4 : result = detexDivideMinus895To895By7(4 * lum0 + 3 * lum1); break;
-			case 5 : result = detexDivideMinus895To895By7(3 * lum0 + 4 * lum1); break;
-			case 6 : result = detexDivideMinus895To895By7(2 * lum0 + 5 * lum1); break;
-			case 7 : result = detexDivideMinus895To895By7(lum0 + 6 * lum1); break;
-			}
-		else
-			switch (control_code) {
-			case 0 : result = lum0; break;
-			case 1 : result = lum1; break;
-			case 2 : result = detexDivideMinus639To639By5(4 * lum0 + lum1); break;
-			case 3 : result = detexDivideMinus639To639By5(3 * lum0 + 2 * lum1); break;
-			case 4 : result = detexDivideMinus639To639By5(2 * lum0 + 3 * lum1); break;
-			case 5 : result = detexDivideMinus639To639By5(lum0 + 4 * lum1); break;
-			case 6 : result = - 127; break;
-			case 7 : result = 127; break;
-			}
-		// Map from [-127, 127] to [-32768, 32767].
-		pixel16_buffer[(i << shift) + offset] = (uint16_t)(int16_t)
-			((result + 127) * 65535 / 254 - 32768);
+		pixel16_buffer[(i << shift) + offset] = palette[bits & 0x7];
 		bits >>= 3;
 	}
 	return true;
@@ -146,3 +145,208 @@ uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
 	return DecodeBlockSignedRGTC(&bitstring[8], 1, 1, pixel_buffer);
 }
 
+
+// Batch decompression of consecutive RGTC1, RGTC2, SIGNED_RGTC1 and SIGNED_RGTC2 blocks.
+// The SIMD code path extracts the 16 3-bit control codes of a block channel in parallel and
+// looks up the values in the palette of the channel with byte shuffles. The results are
+// identical to the single block functions above.
+
+enum {
+	RGTC_BATCH_TYPE_RGTC1,
+	RGTC_BATCH_TYPE_RGTC2,
+	RGTC_BATCH_TYPE_SIGNED_RGTC1,
+	RGTC_BATCH_TYPE_SIGNED_RGTC2
+};
+
+#ifdef DETEX_USE_AVX2
+
+// Extract the 16 control codes of a block channel into bytes. The control code of pixel i
+// starts at bit 16 + 3 * i of the channel; the two bytes that contain it are gathered into
+// a 16-bit lane, and the code is shifted to the top of the lane by a multiplication.
+static DETEX_INLINE_ONLY DETEX_TARGET_SSSE3 __m128i ExtractControlCodesRGTCSSSE3(
+const uint8_t * DETEX_RESTRICT bitstring) {
+	__m128i channel = _mm_loadl_epi64((__m128i *)bitstring);
+	__m128i bytes0 = _mm_shuffle_epi8(channel, _mm_setr_epi8(
+		2, 3, 2, 3, 2, 3, 3, 4, 3, 4, 3, 4, 4, 5, 4, 5));
+	__m128i bytes1 = _mm_shuffle_epi8(channel, _mm_setr_epi8(
+		5, 6, 5, 6, 5, 6, 6, 7, 6, 7, 6, 7, 7, -1, 7, -1));
+	// Bit shifts of the control codes within the lanes are 0, 3, 6, 1, 4, 7, 2, 5.
+	__m128i multipliers = _mm_setr_epi16(1 << 13, 1 << 10, 1 << 7, 1 << 12, 1 << 9, 1 << 6,
+		1 << 11, 1 << 8);
+	__m128i codes0 = _mm_srli_epi16(_mm_mullo_epi16(bytes0, multipliers), 13);
+	__m128i codes1 = _mm_srli_epi16(_mm_mullo_epi16(bytes1, multipliers), 13);
+	return _mm_packus_epi16(codes0, codes1);
+}
+
+// Look up the 8-bit values of the pixels of an unsigned block channel.
+static DETEX_INLINE_ONLY DETEX_TARGET_SSSE3 __m128i DecodeChannelRGTCSSSE3(
+const uint8_t * DETEX_RESTRICT bitstring) {
+	uint8_t palette[8];
+	CalculatePaletteRGTC(bitstring, palette);
+	return _mm_shuffle_epi8(_mm_loadl_epi64((__m128i *)palette),
+		ExtractControlCodesRGTCSSSE3(bitstring));
+}
+
+// Look up the 16-bit values of the pixels of a signed block channel, with values_out[0]
+// holding pixels 0 to 7 and values_out[1] pixels 8 to 15. Returns false if the block is
+// invalid.
+static DETEX_INLINE_ONLY DETEX_TARGET_SSSE3 bool DecodeChannelSignedRGTCSSSE3(
+const uint8_t * DETEX_RESTRICT bitstring, __m128i *values_out) {
+	uint16_t palette[8];
+	if (!CalculatePaletteSignedRGTC(bitstring, palette))
+		return false;
+	__m128i palette128 = _mm_loadu_si128((__m128i *)palette);
+	// Convert the control codes into pairs of byte indices into the palette.
+	__m128i codes = ExtractControlCodesRGTCSSSE3(bitstring);
+	codes = _mm_add_epi8(codes, codes);
+	__m128i codes_plus_1 = _mm_add_epi8(codes, _mm_set1_epi8(1));
+	values_out[0] = _mm_shuffle_epi8(palette128, _mm_unpacklo_epi8(codes, codes_plus_1));
+	values_out[1] = _mm_shuffle_epi8(palette128, _mm_unpackhi_epi8(codes, codes_plus_1));
+	return true;
+}
+
+// Decompress consecutive blocks until a block is encountered that is not handled by the
+// SIMD code path. Returns the number of blocks decompressed.
+static DETEX_TARGET_SSSE3 int DecompressBlocksRGTCSSSE3(const uint8_t * DETEX_RESTRICT bitstring,
+int nu_blocks, int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	int i;
+	for (i = 0; i < nu_blocks; i++) {
+		if (type == RGTC_BATCH_TYPE_RGTC1) {
+			_mm_storeu_si128((__m128i *)pixel_buffer, DecodeChannelRGTCSSSE3(bitstring));
+			bitstring += 8;
+			pixel_buffer += 16;
+		}
+		else if (type == RGTC_BATCH_TYPE_RGTC2) {
+			__m128i red = DecodeChannelRGTCSSSE3(bitstring);
+			__m128i green = DecodeChannelRGTCSSSE3(bitstring + 8);
+			_mm_storeu_si128((__m128i *)pixel_buffer, _mm_unpacklo_epi8(red, green));
+			_mm_storeu_si128((__m128i *)(pixel_buffer + 16), _mm_unpackhi_epi8(red, green));
+			bitstring += 16;
+			pixel_buffer += 32;
+		}
+		else if (type == RGTC_BATCH_TYPE_SIGNED_RGTC1) {
+			__m128i red[2];
+			if (!DecodeChannelSignedRGTCSSSE3(bitstring, red))
+				break;
+			_mm_storeu_si128((__m128i *)pixel_buffer, red[0]);
+			_mm_storeu_si128((__m128i *)(pixel_buffer + 16), red[1]);
+			bitstring += 8;
+			pixel_buffer += 32;
+		}
+		else {
+			__m128i red[2], green[2];
+			if (!DecodeChannelSignedRGTCSSSE3(bitstring, red) ||
+			!DecodeChannelSignedRGTCSSSE3(bitstring + 8, green))
+				break;
+			for (int j = 0; j < 2; j++) {
+				_mm_storeu_si128((__m128i *)(pixel_buffer + j * 32),
+					_mm_unpacklo_epi16(red[j], green[j]));
+				_mm_storeu_si128((__m128i *)(pixel_buffer + j * 32 + 16),
+					_mm_unpackhi_epi16(red[j], green[j]));
+			}
+			bitstring += 16;
+			pixel_buffer += 64;
+		}
+	}
+	return i;
+}
+
+#endif
+
+// Without SIMD, all blocks are decompressed by the scalar code.
+static int DecompressBlocksRGTCNone(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+int type, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return 0;
+}
+
+DETEX_DEFINE_KERNEL(DecompressBlocksRGTCKernel, int, (const uint8_t * DETEX_RESTRICT bitstring,
+	int nu_blocks, int type, uint8_t * DETEX_RESTRICT pixel_buffer),
+	(bitstring, nu_blocks, type, pixel_buffer))
+
+void detexSelectRGTCKernels(int level) {
+	int (*kernel)(const uint8_t * DETEX_RESTRICT, int, int, uint8_t * DETEX_RESTRICT) =
+		DecompressBlocksRGTCNone;
+#ifdef DETEX_USE_AVX2
+	if (level >= DETEX_SIMD_LEVEL_SSSE3)
+		kernel = DecompressBlocksRGTCSSSE3;
+#endif
+	DETEX_SET_KERNEL(DecompressBlocksRGTCKernel, kernel);
+}
+
+static bool DecompressBlocksRGTC(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer, int type) {
+	int block_size = (type == RGTC_BATCH_TYPE_RGTC1 || type == RGTC_BATCH_TYPE_SIGNED_RGTC1) ?
+		8 : 16;
+	// The output pixel formats are R8, RG8, SIGNED_R16 and SIGNED_RG16.
+	int pixel_block_size = (type == RGTC_BATCH_TYPE_RGTC1) ? 16 :
+		(type == RGTC_BATCH_TYPE_SIGNED_RGTC2) ? 64 : 32;
+	int (*kernel)(const uint8_t * DETEX_RESTRICT, int, int, uint8_t * DETEX_RESTRICT) =
+		DETEX_GET_KERNEL(DecompressBlocksRGTCKernel);
+	bool use_simd = kernel != DecompressBlocksRGTCNone;
+	bool result = true;
+	int i = 0;
+	while (i < nu_blocks) {
+		if (use_simd) {
+			i += kernel(bitstring + i * block_size, nu_blocks - i, type,
+				pixel_buffer + i * pixel_block_size);
+			if (i == nu_blocks)
+				break;
+		}
+		// Decompress the next block, which was not handled by the SIMD code path.
+		const uint8_t *block = bitstring + i * block_size;
+		uint8_t *pixels = pixel_buffer + i * pixel_block_size;
+		bool r;
+		switch (type) {
+		case RGTC_BATCH_TYPE_RGTC1 :
+			r = detexDecompressBlockRGTC1(block, mode_mask, flags, pixels);
+			break;
+		case RGTC_BATCH_TYPE_RGTC2 :
+			r = detexDecompressBlockRGTC2(block, mode_mask, flags, pixels);
+			break;
+		case RGTC_BATCH_TYPE_SIGNED_RGTC1 :
+			r = detexDecompressBlockSIGNED_RGTC1(block, mode_mask, flags, pixels);
+			break;
+		default :
+			r = detexDecompressBlockSIGNED_RGTC2(block, mode_mask, flags, pixels);
+			break;
+		}
+		if (!r) {
+			result = false;
+			memset(pixels, 0, pixel_block_size);
+		}
+		i++;
+	}
+	return result;
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the */
+/* unsigned RGTC1 (BC4) format. */
+bool detexDecompressBlocksRGTC1(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksRGTC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		RGTC_BATCH_TYPE_RGTC1);
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the */
+/* unsigned RGTC2 (BC5) format. */
+bool detexDecompressBlocksRGTC2(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksRGTC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		RGTC_BATCH_TYPE_RGTC2);
+}
+
+/* Decompress nu_blocks consecutive 64-bit blocks compressed using the */
+/* signed RGTC1 (signed BC4) format. */
+bool detexDecompressBlocksSIGNED_RGTC1(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksRGTC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		RGTC_BATCH_TYPE_SIGNED_RGTC1);
+}
+
+/* Decompress nu_blocks consecutive 128-bit blocks compressed using the */
+/* signed RGTC2 (signed BC5) format. */
+bool detexDecompressBlocksSIGNED_RGTC2(const uint8_t * DETEX_RESTRICT bitstring, int nu_blocks,
+uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
+	return DecompressBlocksRGTC(bitstring, nu_blocks, mode_mask, flags, pixel_buffer,
+		RGTC_BATCH_TYPE_SIGNED_RGTC2);
+}
@@ -0,0 +1,540 @@
+/*
+
+Copyright (c) 2015 Harm Hanemaaijer <fgenfb@yahoo.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+
+/* Micro-benchmarks for block decompression and pixel format conversion. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "detex.h"
+
+static char *output_file;
+static char *compare_file;
+static char *filter;
+static const char *data_dir = ".";
+static double threshold = 5.0;
+static double min_time = 0.2;
+static int texture_size = 1024;
+static int nu_threads = 0;
+
+// The compressed formats, in the order of the library's decompression function table,
+// with the name of the test texture file that provides representative blocks.
+static const struct {
+	uint32_t format;
+	const char *sample_name;
+} compressed_formats[] = {
+	{ DETEX_TEXTURE_FORMAT_BC1, "BC1" },
+	{ DETEX_TEXTURE_FORMAT_BC1A, "BC1A" },
+	{ DETEX_TEXTURE_FORMAT_BC2, "BC2" },
+	{ DETEX_TEXTURE_FORMAT_BC3, "BC3" },
+	{ DETEX_TEXTURE_FORMAT_RGTC1, "RGTC1" },
+	{ DETEX_TEXTURE_FORMAT_SIGNED_RGTC1, "SIGNED_RGTC1" },
+	{ DETEX_TEXTURE_FORMAT_RGTC2, "RGTC2" },
+	{ DETEX_TEXTURE_FORMAT_SIGNED_RGTC2, "SIGNED_RGTC2" },
+	{ DETEX_TEXTURE_FORMAT_BPTC_FLOAT, "BPTC_FLOAT" },
+	{ DETEX_TEXTURE_FORMAT_BPTC_SIGNED_FLOAT, "BPTC_SIGNED_FLOAT" },
+	{ DETEX_TEXTURE_FORMAT_BPTC, "BPTC" },
+	{ DETEX_TEXTURE_FORMAT_ETC1, "ETC1" },
+	{ DETEX_TEXTURE_FORMAT_ETC2, "ETC2" },
+	{ DETEX_TEXTURE_FORMAT_ETC2_PUNCHTHROUGH, "ETC2_PUNCHTHROUGH" },
+	{ DETEX_TEXTURE_FORMAT_ETC2_EAC, "ETC2_EAC" },
+	{ DETEX_TEXTURE_FORMAT_EAC_R11, "EAC_R11" },
+	{ DETEX_TEXTURE_FORMAT_EAC_SIGNED_R11, "EAC_SIGNED_R11" },
+	{ DETEX_TEXTURE_FORMAT_EAC_RG11, "EAC_RG11" },
+	{ DETEX_TEXTURE_FORMAT_EAC_SIGNED_RG11, "EAC_SIGNED_RG11" },
+};
+
+#define NU_COMPRESSED_FORMATS (sizeof(compressed_formats) / sizeof(compressed_formats[0]))
+
+// Number of pixels converted by each conversion benchmark.
+#define NU_CONVERSION_PIXELS 65536
+
+static const struct option long_options[] = {
+	// Option name, argument flag, NULL, equivalent short option character.
+	{ "output", required_argument, NULL, 'o' },
+	{ "compare", required_argument, NULL, 'c' },
+	{ "threshold", required_argument, NULL, 't' },
+	{ "filter", required_argument, NULL, 'f' },
+	{ "size", required_argument, NULL, 's' },
+	{ "threads", required_argument, NULL, 'j' },
+	{ "min-time", required_argument, NULL, 'm' },
+	{ "data-dir", required_argument, NULL, 'd' },
+	{ "help", no_argument, NULL, 'h' },
+	{ NULL, 0, NULL, 0 }
+};
+
+// Benchmark results. The rate is expressed in units (blocks or pixels) per second, the
+// bandwidth in megabytes per second of decompressed or converted pixel data.
+typedef struct {
+	char name[80];
+	const char *unit;
+	double seconds;
+	double units_per_second;
+	double mb_per_second;
+} BenchmarkResult;
+
+static BenchmarkResult *results;
+static int nu_results;
+static int max_results;
+
+static __attribute ((noreturn)) void FatalError(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	exit(1);
+}
+
+static void Usage() {
+	printf("Usage: detex-bench [<OPTIONS>]\n");
+	printf("Measure block decompression and pixel format conversion performance.\n");
+	printf("Options:\n");
+	printf("    -o, --output <FILE>       Write the results to FILE in JSON format\n");
+	printf("    -c, --compare <FILE>      Compare with the results in FILE written by --output\n");
+	printf("    -t, --threshold <PCT>     Report a regression when slower by more than PCT\n");
+	printf("                              percent (default 5)\n");
+	printf("    -f, --filter <STRING>     Only run benchmarks whose name contains STRING\n");
+	printf("    -s, --size <PIXELS>       Width and height of the decompressed textures\n");
+	printf("                              (default 1024)\n");
+	printf("    -j, --threads <N>         Threads for parallel decompression (default: number\n");
+	printf("                              of processors)\n");
+	printf("    -m, --min-time <SECONDS>  Minimum measuring time per benchmark (default 0.2)\n");
+	printf("    -d, --data-dir <DIR>      Directory with the test-texture-*.ktx files\n");
+	printf("                              (default .)\n");
+	printf("The DETEX_SIMD_LEVEL environment variable limits the SIMD code paths used.\n");
+}
+
+static void ParseArguments(int argc, char **argv) {
+	while (true) {
+		int option_index = 0;
+		int c = getopt_long(argc, argv, "o:c:t:f:s:j:m:d:h", long_options, &option_index);
+		if (c == -1)
+			break;
+		switch (c) {
+		case 'o' :	// -o, --output
+			output_file = optarg;
+			break;
+		case 'c' :	// -c, --compare
+			compare_file = optarg;
+			break;
+		case 't' :	// -t, --threshold
+			threshold = atof(optarg);
+			break;
+		case 'f' :	// -f, --filter
+			filter = optarg;
+			break;
+		case 's' :	// -s, --size
+			texture_size = atoi(optarg);
+			if (texture_size < 4 || (texture_size & 3) != 0)
+				FatalError("Fatal error: Texture size must be a positive multiple of 4\n");
+			break;
+		case 'j' :	// -j, --threads
+			nu_threads = atoi(optarg);
+			break;
+		case 'm' :	// -m, --min-time
+			min_time = atof(optarg);
+			break;
+		case 'd' :	// -d, --data-dir
+			data_dir = optarg;
+			break;
+		case 'h' :	// -h, --help
+			Usage();
+			exit(0);
+		default :
+			FatalError("");
+			break;
+		}
+	}
+	if (optind < argc)
+		FatalError("Fatal error: Unexpected argument %s\n", argv[optind]);
+	if (nu_threads <= 0)
+		nu_threads = sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static double GetTime() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef bool (*BenchmarkFunc)(void *data);
+
+// Run a benchmark function repeatedly for at least the minimum measuring time and return
+// the shortest time of a single call, which is the least sensitive to system noise. The
+// reset function, when not NULL, is called before each run outside the measured time.
+static double MeasureBestTime(const char *name, BenchmarkFunc func, BenchmarkFunc reset,
+void *data) {
+	// Warm-up run, which also checks that the function succeeds.
+	if (reset != NULL)
+		reset(data);
+	if (!func(data))
+		printf("%s: %s\n", name, detexGetErrorMessage());
+	double best_time = 1e30;
+	double total_time = 0;
+	for (int i = 0; i < 3 || total_time < min_time; i++) {
+		if (reset != NULL)
+			reset(data);
+		double start_time = GetTime();
+		func(data);
+		double time = GetTime() - start_time;
+		if (time < best_time)
+			best_time = time;
+		total_time += time;
+	}
+	return best_time;
+}
+
+static bool MatchesFilter(const char *name) {
+	return filter == NULL || strstr(name, filter) != NULL;
+}
+
+static void AddResult(const char *name, const char *unit, double seconds, double nu_units,
+double nu_bytes) {
+	if (nu_results == max_results) {
+		max_results = max_results == 0 ? 64 : max_results * 2;
+		results = (BenchmarkResult *)realloc(results, max_results * sizeof(BenchmarkResult));
+	}
+	BenchmarkResult *result = &results[nu_results++];
+	snprintf(result->name, sizeof(result->name), "%s", name);
+	result->unit = unit;
+	result->seconds = seconds;
+	result->units_per_second = nu_units / seconds;
+	result->mb_per_second = nu_bytes / seconds / (1024.0 * 1024.0);
+	printf("%-56s %12.4g %s/s %10.1f MB/s\n", result->name, result->units_per_second, unit,
+		result->mb_per_second);
+	fflush(stdout);
+}
+
+// Simple deterministic pseudo-random number generator (xorshift), so that runs are
+// reproducible.
+static uint32_t random_state = 0x12345678;
+
+static uint32_t Random() {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+static void FillRandom(uint8_t *buffer, size_t size) {
+	for (size_t i = 0; i < size; i++)
+		buffer[i] = Random() >> 24;
+}
+
+// Create a compressed texture of the benchmark size by repeating the blocks of a test
+// texture, or with random blocks when the test texture is not available or does not have
+// the expected format.
+static void CreateCompressedTexture(int index, detexTexture *texture) {
+	uint32_t format = compressed_formats[index].format;
+	int block_size = detexGetCompressedBlockSize(format);
+	texture->format = format;
+	texture->width = texture_size;
+	texture->height = texture_size;
+	texture->width_in_blocks = texture_size / 4;
+	texture->height_in_blocks = texture_size / 4;
+	texture->data = (uint8_t *)malloc((size_t)texture->width_in_blocks *
+		texture->height_in_blocks * block_size);
+	char filename[256];
+	snprintf(filename, sizeof(filename), "%s/test-texture-%s.ktx", data_dir,
+		compressed_formats[index].sample_name);
+	detexTexture *sample = NULL;
+	if (access(filename, R_OK) == 0 && detexLoadTextureFile(filename, &sample) &&
+	sample->format != format) {
+		free(sample->data);
+		free(sample);
+		sample = NULL;
+	}
+	if (sample == NULL) {
+		FillRandom(texture->data, (size_t)texture->width_in_blocks * texture->height_in_blocks *
+			block_size);
+		return;
+	}
+	for (int y = 0; y < texture->height_in_blocks; y++)
+		for (int x = 0; x < texture->width_in_blocks; x++) {
+			int sample_x = x % sample->width_in_blocks;
+			int sample_y = y % sample->height_in_blocks;
+			memcpy(texture->data + ((size_t)y * texture->width_in_blocks + x) * block_size,
+				sample->data + (sample_y * sample->width_in_blocks + sample_x) * block_size,
+				block_size);
+		}
+	free(sample->data);
+	free(sample);
+}
+
+typedef struct {
+	detexTexture texture;
+	uint32_t pixel_format;
+	uint8_t *pixel_buffer;
+} DecompressionBenchmark;
+
+static bool DecompressSingleBlocks(void *data) {
+	DecompressionBenchmark *benchmark = (DecompressionBenchmark *)data;
+	const detexTexture *texture = &benchmark->texture;
+	int nu_blocks = texture->width_in_blocks * texture->height_in_blocks;
+	int block_size = detexGetCompressedBlockSize(texture->format);
+	int pixel_block_size = detexGetPixelSize(benchmark->pixel_format) * 16;
+	bool result = true;
+	for (int i = 0; i < nu_blocks; i++)
+		result &= detexDecompressBlock(texture->data + (size_t)i * block_size, texture->format,
+			DETEX_MODE_MASK_ALL, 0, benchmark->pixel_buffer + (size_t)i * pixel_block_size,
+			benchmark->pixel_format);
+	return result;
+}
+
+static bool DecompressTiled(void *data) {
+	DecompressionBenchmark *benchmark = (DecompressionBenchmark *)data;
+	return detexDecompressTextureTiled(&benchmark->texture, benchmark->pixel_buffer,
+		benchmark->pixel_format);
+}
+
+static bool DecompressLinear(void *data) {
+	DecompressionBenchmark *benchmark = (DecompressionBenchmark *)data;
+	return detexDecompressTextureLinear(&benchmark->texture, benchmark->pixel_buffer,
+		benchmark->pixel_format);
+}
+
+static bool DecompressLinearParallel(void *data) {
+	DecompressionBenchmark *benchmark = (DecompressionBenchmark *)data;
+	return detexDecompressTextureLinearParallel(&benchmark->texture, benchmark->pixel_buffer,
+		benchmark->pixel_format, nu_threads, NULL);
+}
+
+static const struct {
+	const char *name;
+	BenchmarkFunc func;
+} decompression_variants[] = {
+	{ "single", DecompressSingleBlocks },
+	{ "tiled", DecompressTiled },
+	{ "linear", DecompressLinear },
+	{ "parallel", DecompressLinearParallel },
+};
+
+#define NU_DECOMPRESSION_VARIANTS (sizeof(decompression_variants) / sizeof(decompression_variants[0]))
+
+static void RunDecompressionBenchmarks() {
+	for (int i = 0; i < NU_COMPRESSED_FORMATS; i++) {
+		const char *format_name = detexGetTextureFormatText(compressed_formats[i].format);
+		char name[80];
+		bool selected = false;
+		for (int j = 0; j < NU_DECOMPRESSION_VARIANTS; j++) {
+			snprintf(name, sizeof(name), "decompress/%s/%s", format_name,
+				decompression_variants[j].name);
+			selected |= MatchesFilter(name);
+		}
+		if (!selected)
+			continue;
+		DecompressionBenchmark benchmark;
+		CreateCompressedTexture(i, &benchmark.texture);
+		benchmark.pixel_format = detexGetPixelFormat(benchmark.texture.format);
+		size_t pixel_buffer_size = (size_t)texture_size * texture_size *
+			detexGetPixelSize(benchmark.pixel_format);
+		benchmark.pixel_buffer = (uint8_t *)malloc(pixel_buffer_size);
+		double nu_blocks = (double)benchmark.texture.width_in_blocks *
+			benchmark.texture.height_in_blocks;
+		for (int j = 0; j < NU_DECOMPRESSION_VARIANTS; j++) {
+			snprintf(name, sizeof(name), "decompress/%s/%s", format_name,
+				decompression_variants[j].name);
+			if (!MatchesFilter(name))
+				continue;
+			double seconds = MeasureBestTime(name, decompression_variants[j].func, NULL,
+				&benchmark);
+			AddResult(name, "blocks", seconds, nu_blocks, pixel_buffer_size);
+		}
+		free(benchmark.pixel_buffer);
+		free(benchmark.texture.data);
+	}
+}
+
+typedef struct {
+	detexConversionPlan *plan;
+	uint8_t *source_pixels;
+	uint8_t *pixel_buffer;
+	uint8_t *target_pixel_buffer;
+	size_t source_size;
+} ConversionBenchmark;
+
+// The conversion functions may modify the source pixel buffer, so the source pixels are
+// restored before each run.
+static bool ResetConversion(void *data) {
+	ConversionBenchmark *benchmark = (ConversionBenchmark *)data;
+	memcpy(benchmark->pixel_buffer, benchmark->source_pixels, benchmark->source_size);
+	return true;
+}
+
+static bool Convert(void *data) {
+	ConversionBenchmark *benchmark = (ConversionBenchmark *)data;
+	return detexConvertPixelsWithPlan(benchmark->plan, benchmark->pixel_buffer,
+		NU_CONVERSION_PIXELS, benchmark->target_pixel_buffer);
+}
+
+// Pixel formats used in conversions that have no text description in the library,
+// because they are not used in texture files.
+static const struct {
+	uint32_t format;
+	const char *name;
+} additional_pixel_formats[] = {
+	{ DETEX_PIXEL_FORMAT_BGRA8, "BGRA8" },
+	{ DETEX_PIXEL_FORMAT_BGR8, "BGR8" },
+	{ DETEX_PIXEL_FORMAT_RGBX16, "RGBX16" },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX16_HDR, "FLOAT_RGBX16_HDR" },
+	{ DETEX_PIXEL_FORMAT_FLOAT_BGRX16_HDR, "FLOAT_BGRX16_HDR" },
+	{ DETEX_PIXEL_FORMAT_SIGNED_FLOAT_RGBX16, "SIGNED_FLOAT_RGBX16" },
+	{ DETEX_PIXEL_FORMAT_SIGNED_FLOAT_BGRX16, "SIGNED_FLOAT_BGRX16" },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX32, "FLOAT_RGBX32" },
+	{ DETEX_PIXEL_FORMAT_FLOAT_RGBX32_HDR, "FLOAT_RGBX32_HDR" },
+};
+
+#define NU_ADDITIONAL_PIXEL_FORMATS (sizeof(additional_pixel_formats) / sizeof(additional_pixel_formats[0]))
+
+static const char *GetPixelFormatName(uint32_t pixel_format) {
+	for (int i = 0; i < NU_ADDITIONAL_PIXEL_FORMATS; i++)
+		if (additional_pixel_formats[i].format == pixel_format)
+			return additional_pixel_formats[i].name;
+	return detexGetTextureFormatText(pixel_format);
+}
+
+// Create the source pixels of a conversion benchmark. They are derived from random RGBA8
+// pixels where possible, so that floating point formats have values in a normal range.
+static void CreateSourcePixels(uint32_t pixel_format, uint8_t *pixels) {
+	size_t size = (size_t)NU_CONVERSION_PIXELS * detexGetPixelSize(pixel_format);
+	uint8_t *rgba8_pixels = (uint8_t *)malloc(NU_CONVERSION_PIXELS * 4);
+	FillRandom(rgba8_pixels, NU_CONVERSION_PIXELS * 4);
+	bool converted;
+	if (detexGetPixelSize(pixel_format) == 4) {
+		converted = detexConvertPixels(rgba8_pixels, NU_CONVERSION_PIXELS,
+			DETEX_PIXEL_FORMAT_RGBA8, NULL, pixel_format);
+		memcpy(pixels, rgba8_pixels, size);
+	}
+	else
+		converted = detexConvertPixels(rgba8_pixels, NU_CONVERSION_PIXELS,
+			DETEX_PIXEL_FORMAT_RGBA8, pixels, pixel_format);
+	if (!converted)
+		FillRandom(pixels, size);
+	free(rgba8_pixels);
+}
+
+static void RunConversionBenchmarks() {
+	uint32_t source_format, target_format;
+	for (int i = 0; detexGetConversion(i, &source_format, &target_format); i++) {
+		char name[80];
+		snprintf(name, sizeof(name), "convert/%s/%s", GetPixelFormatName(source_format),
+			GetPixelFormatName(target_format));
+		if (!MatchesFilter(name))
+			continue;
+		ConversionBenchmark benchmark;
+		benchmark.plan = detexCreateConversionPlan(source_format, target_format);
+		if (benchmark.plan == NULL)
+			FatalError("Fatal error: %s\n", detexGetErrorMessage());
+		int source_pixel_size = detexGetPixelSize(source_format);
+		int target_pixel_size = detexGetPixelSize(target_format);
+		benchmark.source_size = (size_t)NU_CONVERSION_PIXELS * source_pixel_size;
+		benchmark.source_pixels = (uint8_t *)malloc(benchmark.source_size);
+		benchmark.pixel_buffer = (uint8_t *)malloc(benchmark.source_size);
+		benchmark.target_pixel_buffer = NULL;
+		if (target_pixel_size != source_pixel_size)
+			benchmark.target_pixel_buffer = (uint8_t *)malloc((size_t)NU_CONVERSION_PIXELS *
+				target_pixel_size);
+		CreateSourcePixels(source_format, benchmark.source_pixels);
+		double seconds = MeasureBestTime(name, Convert, ResetConversion, &benchmark);
+		AddResult(name, "pixels", seconds, NU_CONVERSION_PIXELS,
+			(double)NU_CONVERSION_PIXELS * target_pixel_size);
+		free(benchmark.target_pixel_buffer);
+		free(benchmark.pixel_buffer);
+		free(benchmark.source_pixels);
+		detexFreeConversionPlan(benchmark.plan);
+	}
+}
+
+static void WriteResults(const char *filename) {
+	FILE *f = fopen(filename, "w");
+	if (f == NULL)
+		FatalError("Fatal error: Could not open %s for writing\n", filename);
+	fprintf(f, "{\n");
+	fprintf(f, "  \"simd_level\": \"%s\",\n", detexGetSIMDLevelName(detexGetSIMDLevel()));
+	fprintf(f, "  \"threads\": %d,\n", nu_threads);
+	fprintf(f, "  \"texture_size\": %d,\n", texture_size);
+	fprintf(f, "  \"conversion_pixels\": %d,\n", NU_CONVERSION_PIXELS);
+	fprintf(f, "  \"results\": [\n");
+	// Each result is written on a single line, which is what the compare mode relies on.
+	for (int i = 0; i < nu_results; i++)
+		fprintf(f, "    { \"name\": \"%s\", \"unit\": \"%s\", \"seconds\": %.6g, "
+			"\"per_second\": %.6g, \"mb_per_second\": %.6g }%s\n", results[i].name,
+			results[i].unit, results[i].seconds, results[i].units_per_second,
+			results[i].mb_per_second, i < nu_results - 1 ? "," : "");
+	fprintf(f, "  ]\n");
+	fprintf(f, "}\n");
+	if (fclose(f) != 0)
+		FatalError("Fatal error: Error writing to %s\n", filename);
+}
+
+// Compare the results with those in a file written earlier with --output. Returns the
+// number of benchmarks that are slower by more than the threshold.
+static int CompareResults(const char *filename) {
+	FILE *f = fopen(filename, "r");
+	if (f == NULL)
+		FatalError("Fatal error: Could not open %s\n", filename);
+	printf("\n%-56s %10s %10s %8s\n", "Comparison with baseline (MB/s)", "baseline", "current",
+		"change");
+	int nu_compared = 0;
+	int nu_regressions = 0;
+	char line[512];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char name[80];
+		const char *s = strstr(line, "\"name\": \"");
+		if (s == NULL || sscanf(s, "\"name\": \"%79[^\"]\"", name) != 1)
+			continue;
+		double baseline;
+		s = strstr(line, "\"mb_per_second\": ");
+		if (s == NULL || sscanf(s, "\"mb_per_second\": %lf", &baseline) != 1)
+			continue;
+		for (int i = 0; i < nu_results; i++) {
+			if (strcmp(results[i].name, name) != 0)
+				continue;
+			double change = (results[i].mb_per_second / baseline - 1.0) * 100.0;
+			bool regression = change < - threshold;
+			printf("%-56s %10.1f %10.1f %+7.1f%%%s\n", name, baseline, results[i].mb_per_second,
+				change, regression ? "  REGRESSION" : "");
+			nu_compared++;
+			if (regression)
+				nu_regressions++;
+			break;
+		}
+	}
+	fclose(f);
+	printf("%d benchmarks compared, %d regressions (threshold %.1f%%)\n", nu_compared,
+		nu_regressions, threshold);
+	return nu_regressions;
+}
+
+int main(int argc, char **argv) {
+	ParseArguments(argc, argv);
+	printf("detex-bench: SIMD level %s, %d threads, %dx%d textures\n",
+		detexGetSIMDLevelName(detexGetSIMDLevel()), nu_threads, texture_size, texture_size);
+	RunDecompressionBenchmarks();
+	RunConversionBenchmarks();
+	if (output_file != NULL)
+		WriteResults(output_file);
+	if (compare_file != NULL && CompareResults(compare_file) > 0)
+		exit(1);
+	exit(0);
+}
@@ -24,9 +24,20 @@ extern "C" {
 /* The texture is allocated, free with free(). */
 bool detexLoadPNGFile(const char *filename, detexTexture **texture_out);
 
+/* Load texture from PNG file data in memory or read from a stream (first mip-map */
+/* only). Returns true if successful. The texture is allocated, free with free(). */
+bool detexLoadPNGMemory(const uint8_t *data, size_t size, detexTexture **texture_out);
+bool detexLoadPNGStream(detexReadFunc read_func, void *user_data, detexTexture **texture_out);
+
 /* Save texture to PNG file (single mip-map level). Returns true if succesful. */
 bool detexSavePNGFile(detexTexture *texture, const char *filename);
 
+/* Save texture in PNG format (single mip-map level) to memory or to a stream. Returns */
+/* true if succesful. For memory, data_out returns the allocated file data, free with */
+/* free(), and size_out returns its size in bytes. */
+bool detexSavePNGMemory(detexTexture *texture, uint8_t **data_out, size_t *size_out);
+bool detexSavePNGStream(detexTexture *texture, detexWriteFunc write_func, void *user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -446,6 +446,19 @@ DETEX_API bool detexDecompressBlockETC2_PUNCHTHROUGH(const uint8_t *bitstring,
 /* format. */
 DETEX_API bool detexDecompressBlockETC2_EAC(const uint8_t *bitstring, uint32_t mode_mask,
 	uint32_t flags, uint8_t *pixel_buffer);
+/* Batch versions of the ETC1, ETC2, ETC2_PUNCHTHROUGH and ETC2_EAC decompression */
+/* functions that decompress nu_blocks consecutive blocks, storing the 16 pixels */
+/* of each block consecutively in pixel_buffer. SIMD code paths are used when */
+/* available. Returns false if any block could not be decompressed, in which case */
+/* the pixels of the failed blocks are set to zero. */
+DETEX_API bool detexDecompressBlocksETC1(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksETC2(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksETC2_PUNCHTHROUGH(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksETC2_EAC(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
 
 
 /* Decompress a 64-bit 4x4 pixel texture block compressed using the BC1 */
@@ -464,6 +477,19 @@ DETEX_API bool detexDecompressBlockBC2(const uint8_t *bitstring, uint32_t mode_m
 /* format. */
 DETEX_API bool detexDecompressBlockBC3(const uint8_t *bitstring, uint32_t mode_mask,
 	uint32_t flags, uint8_t *pixel_buffer);
+/* Batch versions of the BC1, BC1A, BC2 and BC3 decompression functions that */
+/* decompress nu_blocks consecutive blocks, storing the 16 pixels of each block */
+/* consecutively in pixel_buffer. SIMD code paths are used when available. */
+/* Returns false if any block could not be decompressed, in which case the */
+/* pixels of the failed blocks are set to zero. */
+DETEX_API bool detexDecompressBlocksBC1(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksBC1A(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksBC2(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksBC3(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
 /* Decompress a 128-bit 4x4 pixel texture block compressed using the BPTC */
 /* (BC7) format. */
 DETEX_API bool detexDecompressBlockBPTC(const uint8_t *bitstring, uint32_t mode_mask,
@@ -482,6 +508,15 @@ DETEX_API bool detexDecompressBlockRGTC1(const uint8_t *bitstring, uint32_t mode
 /* unsigned RGTC2 (BC5) format. */
 DETEX_API bool detexDecompressBlockRGTC2(const uint8_t *bitstring, uint32_t mode_mask,
 	uint32_t flags, uint8_t *pixel_buffer);
+/* Batch versions of the RGTC1 and RGTC2 decompression functions that decompress */
+/* nu_blocks consecutive blocks, storing the 16 pixels of each block consecutively */
+/* in pixel_buffer. SIMD code paths are used when available. Returns false if any */
+/* block could not be decompressed, in which case the pixels of the failed blocks */
+/* are set to zero. */
+DETEX_API bool detexDecompressBlocksRGTC1(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksRGTC2(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
 
 /*
  * Decompression functions for 16-bit unsigned/signed R and RG formats. The
@@ -497,6 +532,15 @@ DETEX_API bool detexDecompressBlockSIGNED_RGTC1(const uint8_t *bitstring, uint32
 /* signed RGTC2 (signed BC5) format. */
 DETEX_API bool detexDecompressBlockSIGNED_RGTC2(const uint8_t *bitstring, uint32_t mode_mask,
 	uint32_t flags, uint8_t *pixel_buffer);
+/* Batch versions of the SIGNED_RGTC1 and SIGNED_RGTC2 decompression functions */
+/* that decompress nu_blocks consecutive blocks, storing the 16 pixels of each */
+/* block consecutively in pixel_buffer. SIMD code paths are used when available. */
+/* Returns false if any block could not be decompressed, in which case the */
+/* pixels of the failed blocks are set to zero. */
+DETEX_API bool detexDecompressBlocksSIGNED_RGTC1(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksSIGNED_RGTC2(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
 /* Decompress a 64-bit 4x4 pixel texture block compressed using the */
 /* ETC2_R11_EAC format. */
 DETEX_API bool detexDecompressBlockEAC_R11(const uint8_t *bitstring, uint32_t mode_mask,
@@ -513,6 +557,19 @@ DETEX_API bool detexDecompressBlockEAC_RG11(const uint8_t *bitstring, uint32_t m
 /* ETC2_SIGNED_RG11_EAC format. */
 DETEX_API bool detexDecompressBlockEAC_SIGNED_RG11(const uint8_t *bitstring,
 	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+/* Batch versions of the EAC_R11, EAC_SIGNED_R11, EAC_RG11 and EAC_SIGNED_RG11 */
+/* decompression functions that decompress nu_blocks consecutive blocks, storing */
+/* the 16 pixels of each block consecutively in pixel_buffer. SIMD code paths are */
+/* used when available. Returns false if any block could not be decompressed, in */
+/* which case the pixels of the failed blocks are set to zero. */
+DETEX_API bool detexDecompressBlocksEAC_R11(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksEAC_SIGNED_R11(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksEAC_RG11(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksEAC_SIGNED_RG11(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
 
 /*
  * Decompression functions for 16-bit half-float formats. The output format is
@@ -529,6 +586,14 @@ DETEX_API bool detexDecompressBlockBPTC_FLOAT(const uint8_t *bitstring, uint32_t
 /* DETEX_PIXEL_FORMAT_SIGNED_FLOAT_RGBX16. */
 DETEX_API bool detexDecompressBlockBPTC_SIGNED_FLOAT(const uint8_t *bitstring,
 	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+/* Batch versions of the BPTC_FLOAT and BPTC_SIGNED_FLOAT decompression functions */
+/* that decompress nu_blocks consecutive blocks, storing the 16 pixels of each */
+/* block consecutively in pixel_buffer. Returns false if any block could not be */
+/* decompressed, in which case the pixels of the failed blocks are set to zero. */
+DETEX_API bool detexDecompressBlocksBPTC_FLOAT(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+DETEX_API bool detexDecompressBlocksBPTC_SIGNED_FLOAT(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
 
 
 /*
@@ -764,6 +829,73 @@ DETEX_API bool detexDecompressTextureTiled(const detexTexture *texture, uint8_t
 DETEX_API bool detexDecompressTextureLinear(const detexTexture *texture, uint8_t *pixel_buffer,
 	uint32_t pixel_format);
 
+/*
+ * Versions of detexDecompressTextureTiled and detexDecompressTextureLinear that
+ * write to an output buffer with padded rows, such as a mapped GPU staging buffer.
+ * row_stride is the distance in bytes between the starts of consecutive pixel rows
+ * (linear) or rows of tiles (tiled) in pixel_buffer; when it is zero, rows are
+ * tightly packed. Bytes between rows are not written. Returns false if row_stride
+ * is smaller than the packed row size.
+ */
+DETEX_API bool detexDecompressTextureTiledStride(const detexTexture *texture, uint8_t *pixel_buffer,
+	int row_stride, uint32_t pixel_format);
+
+DETEX_API bool detexDecompressTextureLinearStride(const detexTexture *texture, uint8_t *pixel_buffer,
+	int row_stride, uint32_t pixel_format);
+
+/*
+ * Decode a rectangular region of a texture. The region with top-left corner
+ * (x, y) and size width x height (in pixels) must lie inside the texture; it
+ * does not have to be aligned to block boundaries. Only the compressed blocks
+ * overlapping the region are decompressed. Pixel (x, y) of the texture is stored
+ * at the start of pixel_buffer in the given pixel format, with consecutive rows
+ * row_stride bytes apart (when row_stride is zero, rows are tightly packed).
+ * Returns false if the region is invalid or a block failed to decompress (the
+ * pixels of such blocks are cleared to zero).
+ */
+DETEX_API bool detexDecompressTextureRegion(const detexTexture *texture, int x, int y, int width,
+	int height, uint8_t *pixel_buffer, int row_stride, uint32_t pixel_format);
+
+/* Task function called by a worker pool for each band of a parallel decompression. */
+typedef void (*detexBandFunc)(void *band_data, int band);
+
+/*
+ * Caller-supplied worker pool for the parallel decompression functions. The
+ * dispatch function must call func(band_data, i) exactly once for each i in
+ * [0, nu_bands), in any order and on any threads, and return only when all
+ * calls have completed.
+ */
+typedef struct {
+	void (*dispatch)(void *pool_data, int nu_bands, detexBandFunc func, void *band_data);
+	void *pool_data;
+} detexWorkerPool;
+
+/*
+ * Parallel versions of detexDecompressTextureTiled and detexDecompressTextureLinear.
+ * The texture is split into nu_threads bands of block rows that are decompressed
+ * concurrently, with output identical to the serial functions. When nu_threads is
+ * zero or negative, the number of online processors is used. When pool is NULL,
+ * threads are created for the duration of the call; otherwise the bands are
+ * dispatched to the given worker pool. Returns false if any band contained a block
+ * that failed to decompress (such blocks are cleared to zero), in which case the
+ * error message identifies the failed bands. The linear version converts
+ * uncompressed textures on the calling thread.
+ */
+DETEX_API bool detexDecompressTextureTiledParallel(const detexTexture *texture, uint8_t *pixel_buffer,
+	uint32_t pixel_format, int nu_threads, const detexWorkerPool *pool);
+
+DETEX_API bool detexDecompressTextureLinearParallel(const detexTexture *texture, uint8_t *pixel_buffer,
+	uint32_t pixel_format, int nu_threads, const detexWorkerPool *pool);
+
+/* Parallel versions of the decompression functions with a row stride. */
+DETEX_API bool detexDecompressTextureTiledStrideParallel(const detexTexture *texture,
+	uint8_t *pixel_buffer, int row_stride, uint32_t pixel_format, int nu_threads,
+	const detexWorkerPool *pool);
+
+DETEX_API bool detexDecompressTextureLinearStrideParallel(const detexTexture *texture,
+	uint8_t *pixel_buffer, int row_stride, uint32_t pixel_format, int nu_threads,
+	const detexWorkerPool *pool);
+
 
 /*
  * Miscellaneous functions.
@@ -778,11 +910,61 @@ DETEX_API bool detexConvertPixels(uint8_t *source_pixel_buffer, uint32_t nu_pixe
 	uint32_t source_pixel_format, uint8_t *target_pixel_buffer,
 	uint32_t target_pixel_format);
 
+/*
+ * Conversion plan between two pixel formats, created once with
+ * detexCreateConversionPlan() and then used for any number of conversions. The
+ * contents are internal to the library.
+ */
+typedef struct detexConversionPlan detexConversionPlan;
+
+/*
+ * HDR parameters passed explicitly to the conversion functions, as an alternative
+ * to the thread-local parameters set with detexSetHDRParameters(). HDR pixel values
+ * are gamma-corrected with the given gamma and mapped from the range
+ * [range_min, range_max] to [0, 1].
+ */
+typedef struct {
+	float gamma;
+	float range_min;
+	float range_max;
+} detexHDRParameters;
+
+/* Create a conversion plan between two pixel formats. Returns NULL if there is no */
+/* conversion path or memory could not be allocated. */
+DETEX_API detexConversionPlan *detexCreateConversionPlan(uint32_t source_pixel_format,
+	uint32_t target_pixel_format);
+
+/* Free a conversion plan created with detexCreateConversionPlan(). */
+DETEX_API void detexFreeConversionPlan(detexConversionPlan *plan);
+
+/* Return the source and target pixel formats of a conversion plan. */
+DETEX_API uint32_t detexGetConversionPlanSourceFormat(const detexConversionPlan *plan);
+DETEX_API uint32_t detexGetConversionPlanTargetFormat(const detexConversionPlan *plan);
+
+/* Convert pixels using a conversion plan, as with detexConvertPixels. When */
+/* target_pixel_buffer is NULL, the conversion is performed in-place if possible. */
+DETEX_API bool detexConvertPixelsWithPlan(const detexConversionPlan *plan,
+	uint8_t *source_pixel_buffer, uint32_t nu_pixels, uint8_t *target_pixel_buffer);
+
+/* Convert pixels using explicit HDR parameters, which are used instead of the thread-local */
+/* parameters set with detexSetHDRParameters() for the duration of the call. */
+DETEX_API bool detexConvertPixelsHDR(uint8_t *source_pixel_buffer, uint32_t nu_pixels,
+	uint32_t source_pixel_format, uint8_t *target_pixel_buffer,
+	uint32_t target_pixel_format, const detexHDRParameters *params);
+DETEX_API bool detexConvertPixelsWithPlanHDR(const detexConversionPlan *plan,
+	uint8_t *source_pixel_buffer, uint32_t nu_pixels, uint8_t *target_pixel_buffer,
+	const detexHDRParameters *params);
+
 /* Convert in-place, modifying the source pixel buffer only. If any conversion step changes the */
 /* pixel size, the function will not be succesful and return false. */
 DETEX_API bool detexConvertPixelsInPlace(uint8_t * DETEX_RESTRICT source_pixel_buffer,
 	uint32_t nu_pixels, uint32_t source_pixel_format, uint32_t target_pixel_format);
 
+/* Return the source and target pixel formats of the built-in elementary conversion with */
+/* the given index, starting from zero. Returns false if the index is out of range. */
+DETEX_API bool detexGetConversion(int index, uint32_t *source_pixel_format,
+	uint32_t *target_pixel_format);
+
 /* Return the component bitfield masks for a pixel format (pixel size must be at most 64 bits). */
 /* Return true if succesful. */
 DETEX_API bool detexGetComponentMasks(uint32_t texture_format, uint64_t *red_mask, uint64_t *green_mask,
@@ -806,11 +988,40 @@ DETEX_API bool detexGetDX10Parameters(uint32_t texture_format, uint32_t *dx10_fo
 DETEX_API const char *detexGetErrorMessage();
 
 
+/*
+ * SIMD code path selection.
+ */
+
+/* SIMD instruction set levels of the decompression and conversion code paths. The */
+/* AVX2 level also requires the F16C half-float conversion instructions. */
+enum {
+	DETEX_SIMD_LEVEL_NONE = 0,
+	DETEX_SIMD_LEVEL_SSE2 = 1,
+	DETEX_SIMD_LEVEL_SSSE3 = 2,
+	DETEX_SIMD_LEVEL_AVX2 = 3
+};
+
+/* Return the highest SIMD level used. The processor features are detected at first */
+/* use; the level can be limited by setting the DETEX_SIMD_LEVEL environment variable */
+/* to none, sse2, ssse3 or avx2. */
+DETEX_API int detexGetSIMDLevel();
+
+/* Limit the SIMD level, for example for testing. Levels that are not supported by the */
+/* processor are reduced to the highest supported level. Should not be called while */
+/* other threads are using the library. Returns the level now in effect. */
+DETEX_API int detexSetSIMDLevel(int level);
+
+/* Return the name of a SIMD level ("none", "sse2", "ssse3" or "avx2"). */
+DETEX_API const char *detexGetSIMDLevelName(int level);
+
+
 /*
  * HDR-related functions.
  */
 
-/* Set HDR gamma curve parameters. */
+/* Set HDR gamma curve parameters. The parameters are thread-local and apply to the */
+/* conversions performed by the calling thread, including texture decompression (the */
+/* threads of the parallel decompression functions use the parameters of the caller). */
 DETEX_API void detexSetHDRParameters(float gamma, float range_min, float range_max);
 
 /* Calculate the dynamic range of a pixel buffer. Valid for float and half-float formats. */
@@ -818,11 +1029,22 @@ DETEX_API void detexSetHDRParameters(float gamma, float range_min, float range_m
 DETEX_API bool detexCalculateDynamicRange(uint8_t *pixel_buffer, int nu_pixels, uint32_t pixel_format,
 	float *range_min_out, float *range_max_out);
 
+/* Calculate the dynamic range of a pixel buffer and store it in the range of an HDR */
+/* parameter object, leaving the gamma unchanged. Returns true if successful. */
+DETEX_API bool detexCalculateDynamicRangeParameters(uint8_t *pixel_buffer, int nu_pixels,
+	uint32_t pixel_format, detexHDRParameters *params);
+
 
 /*
  * Texture file loading.
  */
 
+/* Callbacks used by the stream load and save functions. A read function reads size bytes */
+/* into buffer and a write function writes size bytes from buffer. Both return the number */
+/* of bytes transferred; a smaller number than size indicates an error or end of data. */
+typedef size_t (*detexReadFunc)(void *user_data, void *buffer, size_t size);
+typedef size_t (*detexWriteFunc)(void *user_data, const void *buffer, size_t size);
+
 /* Load texture from KTX file with mip-maps. Returns true if successful. */
 /* nu_levels is a return parameter that returns the number of mipmap levels found. */
 /* textures_out is a return parameter for an array of detexTexture pointers that is allocated, */
@@ -835,9 +1057,25 @@ DETEX_API bool detexLoadKTXFileWithMipmaps(const char *filename, int max_mipmaps
 /* The texture is allocated, free with free(). */
 DETEX_API bool detexLoadKTXFile(const char *filename, detexTexture **texture_out);
 
+/* Load texture from KTX file data in memory or read from a stream with mip-maps. */
+/* Returns true if successful. The data is copied; textures_out and nu_levels_out */
+/* are return parameters as with detexLoadKTXFileWithMipmaps. */
+DETEX_API bool detexLoadKTXMemoryWithMipmaps(const uint8_t *data, size_t size, int max_mipmaps,
+	detexTexture ***textures_out, int *nu_levels_out);
+DETEX_API bool detexLoadKTXStreamWithMipmaps(detexReadFunc read_func, void *user_data, int max_mipmaps,
+	detexTexture ***textures_out, int *nu_levels_out);
+
 /* Save textures to KTX file (multiple mip-maps levels). Return true if succesful. */
 DETEX_API bool detexSaveKTXFileWithMipmaps(detexTexture **textures, int nu_levels, const char *filename);
 
+/* Save textures in KTX format (multiple mip-maps levels) to memory or to a stream. */
+/* Return true if succesful. For memory, data_out returns the allocated file data, */
+/* free with free(), and size_out returns its size in bytes. */
+DETEX_API bool detexSaveKTXMemoryWithMipmaps(detexTexture **textures, int nu_levels, uint8_t **data_out,
+	size_t *size_out);
+DETEX_API bool detexSaveKTXStreamWithMipmaps(detexTexture **textures, int nu_levels, detexWriteFunc write_func,
+	void *user_data);
+
 /* Save texture to KTX file (single mip-map level). Returns true if succesful. */
 DETEX_API bool detexSaveKTXFile(detexTexture *texture, const char *filename);
 
@@ -853,9 +1091,25 @@ DETEX_API bool detexLoadDDSFileWithMipmaps(const char *filename, int max_mipmaps
 /* The texture is allocated, free with free(). */
 DETEX_API bool detexLoadDDSFile(const char *filename, detexTexture **texture_out);
 
+/* Load texture from DDS file data in memory or read from a stream with mip-maps. */
+/* Returns true if successful. The data is copied; textures_out and nu_levels_out */
+/* are return parameters as with detexLoadDDSFileWithMipmaps. */
+DETEX_API bool detexLoadDDSMemoryWithMipmaps(const uint8_t *data, size_t size, int max_mipmaps,
+	detexTexture ***textures_out, int *nu_levels_out);
+DETEX_API bool detexLoadDDSStreamWithMipmaps(detexReadFunc read_func, void *user_data, int max_mipmaps,
+	detexTexture ***textures_out, int *nu_levels_out);
+
 /* Save textures to DDS file (multiple mip-maps levels). Return true if succesful. */
 DETEX_API bool detexSaveDDSFileWithMipmaps(detexTexture **textures, int nu_levels, const char *filename);
 
+/* Save textures in DDS format (multiple mip-maps levels) to memory or to a stream. */
+/* Return true if succesful. For memory, data_out returns the allocated file data, */
+/* free with free(), and size_out returns its size in bytes. */
+DETEX_API bool detexSaveDDSMemoryWithMipmaps(detexTexture **textures, int nu_levels, uint8_t **data_out,
+	size_t *size_out);
+DETEX_API bool detexSaveDDSStreamWithMipmaps(detexTexture **textures, int nu_levels, detexWriteFunc write_func,
+	void *user_data);
+
 /* Save texture to DDS file (single mip-map level). Returns true if succesful. */
 DETEX_API bool detexSaveDDSFile(detexTexture *texture, const char *filename);
 
@@ -866,6 +1120,58 @@ DETEX_API bool detexLoadTextureFileWithMipmaps(const char *filename, int max_mip
 /* Load texture file (type autodetected from extension). */
 DETEX_API bool detexLoadTextureFile(const char *filename, detexTexture **texture_out);
 
+/* Load texture from KTX or DDS file data in memory (type autodetected from the file */
+/* signature) with mipmaps. The data is copied. */
+DETEX_API bool detexLoadTextureMemoryWithMipmaps(const uint8_t *data, size_t size, int max_mipmaps,
+	detexTexture ***textures_out, int *nu_levels_out);
+
+/* A memory-mapped texture file. */
+typedef struct detexMappedTextureFile detexMappedTextureFile;
+
+/* Map a KTX, DDS or autodetected (from extension) texture file into memory with */
+/* mip-maps. Returns true if successful. Instead of being copied, the data of the */
+/* returned textures references the mapped file (with copy-on-write semantics), */
+/* except for levels whose data is not 8-byte aligned in the file, which are copied. */
+/* textures_out and nu_levels_out are return parameters as with the load functions, */
+/* but the textures and the array are owned by the mapped file returned in file_out, */
+/* and must not be freed with free(). */
+DETEX_API bool detexMapKTXFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
+	int *nu_levels_out, detexMappedTextureFile **file_out);
+DETEX_API bool detexMapDDSFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
+	int *nu_levels_out, detexMappedTextureFile **file_out);
+DETEX_API bool detexMapTextureFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
+	int *nu_levels_out, detexMappedTextureFile **file_out);
+
+/* Release a mapped texture file, freeing the textures returned by the map function */
+/* and unmapping the file. */
+DETEX_API void detexReleaseMappedTextureFile(detexMappedTextureFile *file);
+
+/* Function called by the streaming decompression functions for each decoded strip */
+/* of nu_rows (at most four) pixel rows starting at pixel row y. The strip is stored */
+/* in pixel_buffer with rows tightly packed. texture describes the first mipmap */
+/* level being decompressed (its data field is NULL). Returning false aborts the */
+/* decompression. */
+typedef bool (*detexStripFunc)(void *user_data, const detexTexture *texture, int y, int nu_rows,
+	const uint8_t *pixel_buffer);
+
+/* Decompress the first mipmap level of a KTX, DDS or autodetected (from extension) */
+/* texture file, or of KTX or DDS file data read from a stream, into the given pixel */
+/* format without loading the whole level. The data is read and decoded one row of */
+/* compressed blocks at a time, and each decoded strip is passed to strip_func, so */
+/* that the memory used is proportional to the texture width only. Returns true if */
+/* successful. Blocks that fail to decompress are cleared to zero and cause false to */
+/* be returned after all strips have been passed on. */
+DETEX_API bool detexDecompressKTXFileStrips(const char *filename, uint32_t pixel_format,
+	detexStripFunc strip_func, void *user_data);
+DETEX_API bool detexDecompressDDSFileStrips(const char *filename, uint32_t pixel_format,
+	detexStripFunc strip_func, void *user_data);
+DETEX_API bool detexDecompressTextureFileStrips(const char *filename, uint32_t pixel_format,
+	detexStripFunc strip_func, void *user_data);
+DETEX_API bool detexDecompressKTXStreamStrips(detexReadFunc read_func, void *read_user_data,
+	uint32_t pixel_format, detexStripFunc strip_func, void *user_data);
+DETEX_API bool detexDecompressDDSStreamStrips(detexReadFunc read_func, void *read_user_data,
+	uint32_t pixel_format, detexStripFunc strip_func, void *user_data);
+
 /* Load texture from raw file (first mip-map only) given the format and dimensions */
 /* in texture. Returns true if successful. */
 /* The texture->data is allocated, free with free(). */
@@ -879,9 +1185,20 @@ DETEX_API bool detexSaveRawFile(detexTexture *texture, const char *filename);
 /* The texture is allocated, free with free(). */
 DETEX_API bool detexLoadPNGFile(const char *filename, detexTexture **texture_out);
 
+/* Load texture from PNG file data in memory or read from a stream (first mip-map */
+/* only). Returns true if successful. The texture is allocated, free with free(). */
+DETEX_API bool detexLoadPNGMemory(const uint8_t *data, size_t size, detexTexture **texture_out);
+DETEX_API bool detexLoadPNGStream(detexReadFunc read_func, void *user_data, detexTexture **texture_out);
+
 /* Save texture to PNG file (single mip-map level). Returns true if succesful. */
 DETEX_API bool detexSavePNGFile(detexTexture *texture, const char *filename);
 
+/* Save texture in PNG format (single mip-map level) to memory or to a stream. Returns */
+/* true if succesful. For memory, data_out returns the allocated file data, free with */
+/* free(), and size_out returns its size in bytes. */
+DETEX_API bool detexSavePNGMemory(detexTexture *texture, uint8_t **data_out, size_t *size_out);
+DETEX_API bool detexSavePNGStream(detexTexture *texture, detexWriteFunc write_func, void *user_data);
+
 /* Return pixel size in bytes for pixel format or texture format (decompressed). */
 static DETEX_INLINE_ONLY int detexGetPixelSize(uint32_t pixel_format) {
 	return 1 + ((pixel_format & 0xF00) >> 8);
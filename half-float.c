@@ -24,6 +24,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 #include "detex.h"
 #include "half-float.h"
+#include "simd.h"
 
 /******************************************************************************
  *
@@ -266,38 +267,210 @@ void * DETEX_RESTRICT source, int numel)
     }
 }
 
-// Precalculated half-float table management.
+// SIMD half-float conversion. The kernels produce exactly the same results as
+// halfp2singles and singles2halfp above, including the canonical NaN patterns and the
+// rounding of ties away from zero. Because the F16C float to half-float instruction
+// rounds ties to even, the float to half-float direction is emulated with integer
+// operations (eight lanes with AVX2, four with SSE2). Each kernel returns the number of
+// values converted; the remainder is converted with the scalar functions.
 
-float *detex_half_float_table = NULL;
+#ifdef DETEX_USE_SSE2
 
-static void detexCalculateHalfFloatTable() {
-	detex_half_float_table = (float *)malloc(65536 * sizeof(float));
-	uint16_t *hf_buffer = (uint16_t *)malloc(65536 * sizeof(uint16_t));
-	for (int i = 0; i <= 0xFFFF; i++)
-		hf_buffer[i] = i;
-	halfp2singles(detex_half_float_table, hf_buffer, 65536);
-	free(hf_buffer);
+static DETEX_INLINE_ONLY __m128i SelectSSE2(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
 }
 
-static pthread_mutex_t mutex_half_float_table = PTHREAD_MUTEX_INITIALIZER;
+// Convert four half-floats stored in the low 16 bits of 32-bit lanes to float bit patterns.
+static DETEX_INLINE_ONLY __m128i ConvertHalfFloatToFloatLanesSSE2(__m128i h) {
+	__m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+	__m128i exponent = _mm_and_si128(h, _mm_set1_epi32(0x7C00));
+	__m128i mantissa = _mm_and_si128(h, _mm_set1_epi32(0x03FF));
+	// Rebias the exponent of normalized numbers.
+	__m128i normal = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13),
+		_mm_set1_epi32((127 - 15) << 23));
+	// Zero and denormals are exactly mantissa * 2^-24.
+	__m128i denormal = _mm_castps_si128(_mm_mul_ps(_mm_cvtepi32_ps(mantissa),
+		_mm_set1_ps(1.0f / 16777216.0f)));
+	__m128i special = SelectSSE2(_mm_cmpeq_epi32(mantissa, _mm_setzero_si128()),
+		_mm_set1_epi32(0x7F800000), _mm_set1_epi32(0xFFC00000));
+	__m128i x = SelectSSE2(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()), denormal,
+		SelectSSE2(_mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7C00)), special, normal));
+	return _mm_or_si128(x, sign);
+}
+
+static int ConvertHalfFloatToFloatSSE2(const uint16_t * DETEX_RESTRICT source_buffer, int n,
+float * DETEX_RESTRICT target_buffer) {
+	int i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i h = _mm_loadu_si128((__m128i *)&source_buffer[i]);
+		_mm_storeu_si128((__m128i *)&target_buffer[i], ConvertHalfFloatToFloatLanesSSE2(
+			_mm_unpacklo_epi16(h, _mm_setzero_si128())));
+		_mm_storeu_si128((__m128i *)&target_buffer[i + 4], ConvertHalfFloatToFloatLanesSSE2(
+			_mm_unpackhi_epi16(h, _mm_setzero_si128())));
+	}
+	return i;
+}
+
+// Convert four float bit patterns to half-floats stored in the low 16 bits of 32-bit lanes.
+static DETEX_INLINE_ONLY __m128i ConvertFloatToHalfFloatLanesSSE2(__m128i x) {
+	__m128i sign = _mm_and_si128(_mm_srli_epi32(x, 16), _mm_set1_epi32(0x8000));
+	__m128i a = _mm_and_si128(x, _mm_set1_epi32(0x7FFFFFFF));
+	// Rebias the exponent and round using the highest discarded mantissa bit. A carry
+	// out of the mantissa correctly increments the exponent, up to infinity.
+	__m128i normal = _mm_add_epi32(_mm_sub_epi32(_mm_srli_epi32(a, 13), _mm_set1_epi32((127 - 15) << 10)),
+		_mm_and_si128(_mm_srli_epi32(a, 12), _mm_set1_epi32(1)));
+	// Values that become half-float denormals (or zero) are rounded from |x| * 2^24, which
+	// is exact. The fraction after truncation is also exact.
+	__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(a), _mm_set1_ps(16777216.0f));
+	__m128i truncated = _mm_cvttps_epi32(scaled);
+	__m128i round = _mm_castps_si128(_mm_cmpge_ps(_mm_sub_ps(scaled, _mm_cvtepi32_ps(truncated)),
+		_mm_set1_ps(0.5f)));
+	__m128i denormal = _mm_sub_epi32(truncated, round);
+	__m128i h = SelectSSE2(_mm_cmplt_epi32(a, _mm_set1_epi32(0x38800000)), denormal,
+		SelectSSE2(_mm_cmplt_epi32(a, _mm_set1_epi32(0x47800000)), normal, _mm_set1_epi32(0x7C00)));
+	h = _mm_or_si128(h, sign);
+	return SelectSSE2(_mm_cmpgt_epi32(a, _mm_set1_epi32(0x7F800000)), _mm_set1_epi32(0xFE00), h);
+}
+
+// Pack the low 16 bits of the 32-bit lanes of two vectors.
+static DETEX_INLINE_ONLY __m128i Pack32To16SSE2(__m128i a, __m128i b) {
+	a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+	b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+	return _mm_packs_epi32(a, b);
+}
+
+static int ConvertFloatToHalfFloatSSE2(const float * DETEX_RESTRICT source_buffer, int n,
+uint16_t * DETEX_RESTRICT target_buffer) {
+	int i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i h0 = ConvertFloatToHalfFloatLanesSSE2(_mm_loadu_si128((__m128i *)&source_buffer[i]));
+		__m128i h1 = ConvertFloatToHalfFloatLanesSSE2(_mm_loadu_si128((__m128i *)&source_buffer[i + 4]));
+		_mm_storeu_si128((__m128i *)&target_buffer[i], Pack32To16SSE2(h0, h1));
+	}
+	return i;
+}
+
+#endif
+
+#ifdef DETEX_USE_AVX2
+
+static DETEX_TARGET_F16C int ConvertHalfFloatToFloatF16C(const uint16_t * DETEX_RESTRICT source_buffer, int n,
+float * DETEX_RESTRICT target_buffer) {
+	int i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i h = _mm_loadu_si128((__m128i *)&source_buffer[i]);
+		// The instruction preserves the sign and payload of NaNs; replace them with the
+		// half-float NaN that converts to the canonical 0xFFC00000 pattern.
+		__m128i nan = _mm_cmpgt_epi16(_mm_and_si128(h, _mm_set1_epi16(0x7FFF)), _mm_set1_epi16(0x7C00));
+		h = SelectSSE2(nan, _mm_set1_epi16((short)0xFE00), h);
+		_mm256_storeu_ps(&target_buffer[i], _mm256_cvtph_ps(h));
+	}
+	return i;
+}
+
+static DETEX_TARGET_AVX2 int ConvertFloatToHalfFloatAVX2(const float * DETEX_RESTRICT source_buffer, int n,
+uint16_t * DETEX_RESTRICT target_buffer) {
+	int i;
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i h[2];
+		for (int j = 0; j < 2; j++) {
+			__m256i x = _mm256_loadu_si256((__m256i *)&source_buffer[i + j * 8]);
+			__m256i sign = _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(0x8000));
+			__m256i a = _mm256_and_si256(x, _mm256_set1_epi32(0x7FFFFFFF));
+			__m256i normal = _mm256_add_epi32(_mm256_sub_epi32(_mm256_srli_epi32(a, 13),
+				_mm256_set1_epi32((127 - 15) << 10)),
+				_mm256_and_si256(_mm256_srli_epi32(a, 12), _mm256_set1_epi32(1)));
+			__m256 scaled = _mm256_mul_ps(_mm256_castsi256_ps(a), _mm256_set1_ps(16777216.0f));
+			__m256i truncated = _mm256_cvttps_epi32(scaled);
+			__m256i round = _mm256_castps_si256(_mm256_cmp_ps(_mm256_sub_ps(scaled,
+				_mm256_cvtepi32_ps(truncated)), _mm256_set1_ps(0.5f), _CMP_GE_OQ));
+			__m256i denormal = _mm256_sub_epi32(truncated, round);
+			__m256i v = _mm256_blendv_epi8(
+				_mm256_blendv_epi8(_mm256_set1_epi32(0x7C00), normal,
+					_mm256_cmpgt_epi32(_mm256_set1_epi32(0x47800000), a)),
+				denormal, _mm256_cmpgt_epi32(_mm256_set1_epi32(0x38800000), a));
+			v = _mm256_or_si256(v, sign);
+			h[j] = _mm256_blendv_epi8(v, _mm256_set1_epi32(0xFE00),
+				_mm256_cmpgt_epi32(a, _mm256_set1_epi32(0x7F800000)));
+		}
+		// The lane values fit in 16 bits, so unsigned saturation does not alter them.
+		_mm256_storeu_si256((__m256i *)&target_buffer[i],
+			_mm256_permute4x64_epi64(_mm256_packus_epi32(h[0], h[1]), 0xD8));
+	}
+	// Convert the remaining group of eight values, if any.
+	return i + ConvertFloatToHalfFloatSSE2(source_buffer + i, n - i, target_buffer + i);
+}
+
+#endif
+
+// Without SIMD, all values are converted by the scalar code.
+static int ConvertHalfFloatToFloatNone(const uint16_t * DETEX_RESTRICT source_buffer, int n,
+float * DETEX_RESTRICT target_buffer) {
+	return 0;
+}
+
+static int ConvertFloatToHalfFloatNone(const float * DETEX_RESTRICT source_buffer, int n,
+uint16_t * DETEX_RESTRICT target_buffer) {
+	return 0;
+}
+
+DETEX_DEFINE_KERNEL(ConvertHalfFloatToFloatKernel, int, (const uint16_t * DETEX_RESTRICT source_buffer,
+	int n, float * DETEX_RESTRICT target_buffer), (source_buffer, n, target_buffer))
+DETEX_DEFINE_KERNEL(ConvertFloatToHalfFloatKernel, int, (const float * DETEX_RESTRICT source_buffer,
+	int n, uint16_t * DETEX_RESTRICT target_buffer), (source_buffer, n, target_buffer))
+
+void detexSelectHalfFloatKernels(int level) {
+	int (*to_float_kernel)(const uint16_t * DETEX_RESTRICT, int, float * DETEX_RESTRICT) =
+		ConvertHalfFloatToFloatNone;
+	int (*to_half_float_kernel)(const float * DETEX_RESTRICT, int, uint16_t * DETEX_RESTRICT) =
+		ConvertFloatToHalfFloatNone;
+#ifdef DETEX_USE_SSE2
+	if (level >= DETEX_SIMD_LEVEL_SSE2) {
+		to_float_kernel = ConvertHalfFloatToFloatSSE2;
+		to_half_float_kernel = ConvertFloatToHalfFloatSSE2;
+	}
+#endif
+#ifdef DETEX_USE_AVX2
+	// The F16C instructions are part of the AVX2 level.
+	if (level >= DETEX_SIMD_LEVEL_AVX2) {
+		to_float_kernel = ConvertHalfFloatToFloatF16C;
+		to_half_float_kernel = ConvertFloatToHalfFloatAVX2;
+	}
+#endif
+	DETEX_SET_KERNEL(ConvertHalfFloatToFloatKernel, to_float_kernel);
+	DETEX_SET_KERNEL(ConvertFloatToHalfFloatKernel, to_half_float_kernel);
+}
+
+// Precalculated half-float table management. The table is calculated once, the first
+// time it is validated; afterwards validation is a lock-free check of the once control.
+
+float detex_half_float_table[65536];
+
+static pthread_once_t half_float_table_once = PTHREAD_ONCE_INIT;
+
+static void CalculateHalfFloatTable() {
+	uint16_t hf_buffer[256];
+	for (int i = 0; i <= 0xFFFF; i += 256) {
+		for (int j = 0; j < 256; j++)
+			hf_buffer[j] = i + j;
+		halfp2singles(&detex_half_float_table[i], hf_buffer, 256);
+	}
+}
 
 void detexValidateHalfFloatTable() {
-	pthread_mutex_lock(&mutex_half_float_table);
-	if (detex_half_float_table == NULL)
-		detexCalculateHalfFloatTable();
-	pthread_mutex_unlock(&mutex_half_float_table);
+	pthread_once(&half_float_table_once, CalculateHalfFloatTable);
 }
 
 // Conversion functions.
 
 void detexConvertHalfFloatToFloat(uint16_t *source_buffer, int n, float *target_buffer) {
-	detexValidateHalfFloatTable();
-	for (int i = 0; i < n; i++)
-		target_buffer[i] = detexGetFloatFromHalfFloat(source_buffer[i]);
+	int i = DETEX_GET_KERNEL(ConvertHalfFloatToFloatKernel)(source_buffer, n, target_buffer);
+	halfp2singles(target_buffer + i, source_buffer + i, n - i);
 }
  
 void detexConvertFloatToHalfFloat(float *source_buffer, int n, uint16_t *target_buffer) {
-	singles2halfp(target_buffer, source_buffer, n);
+	int i = DETEX_GET_KERNEL(ConvertFloatToHalfFloatKernel)(source_buffer, n, target_buffer);
+	singles2halfp(target_buffer + i, source_buffer + i, n - i);
 }
 
 // Convert normalized half floats to unsigned 16-bit integers in place.
@@ -24,7 +24,7 @@ void detexConvertNormalizedHalfFloatToUInt16(uint16_t *buffer, int n);
 
 void detexConvertNormalizedFloatToUInt16(float *source_buffer, int n, uint16_t *target_buffer);
 
-extern float *detex_half_float_table;
+extern float detex_half_float_table[65536];
 
 void detexValidateHalfFloatTable();
 
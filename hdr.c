@@ -21,49 +21,345 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <math.h>
 #include <float.h>
 #include <fenv.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "detex.h"
 #include "half-float.h"
 #include "hdr.h"
 #include "misc.h"
+#include "simd.h"
 
 // Gamma/HDR parameters.
 
-__thread float detex_gamma = 1.0f;
-__thread float detex_gamma_range_min = 0.0f;
-__thread float detex_gamma_range_max = 1.0f;
-__thread float *detex_gamma_corrected_half_float_table = NULL;
-__thread float detex_corrected_half_float_table_gamma;
+__thread detexHDRParameters detex_hdr_parameters = { 1.0f, 0.0f, 1.0f };
+__thread const detexHDRParameters *detex_active_hdr_parameters = NULL;
 
 void detexSetHDRParameters(float gamma, float range_min, float range_max) {
-	detex_gamma = gamma;
-	detex_gamma_range_min = range_min;
-	detex_gamma_range_max = range_max;
-	detex_gamma_corrected_half_float_table = NULL;
+	detex_hdr_parameters.gamma = gamma;
+	detex_hdr_parameters.range_min = range_min;
+	detex_hdr_parameters.range_max = range_max;
 }
 
-// Update gamma-corrected half-float table when required.
-static void ValidateGammaCorrectedHalfFloatTable(float gamma) {
-	if (detex_gamma_corrected_half_float_table != NULL &&
-	detex_corrected_half_float_table_gamma == gamma)
-		return;
-	if (detex_gamma_corrected_half_float_table == NULL)
-		detex_gamma_corrected_half_float_table = malloc(65536 * sizeof(float));
-	float *float_table = detex_gamma_corrected_half_float_table;
-	detexValidateHalfFloatTable();
-	memcpy(float_table, detex_half_float_table, 65536 * sizeof(float));
-	for (int i = 0; i <= 0xFFFF; i++)
-		if (float_table[i] >= 0.0f)
-			float_table[i] = powf(float_table[i], 1.0f / gamma);
-		else
-			float_table[i] = - powf(- float_table[i], 1.0f / gamma);
+const detexHDRParameters *detexSetActiveHDRParameters(const detexHDRParameters *params) {
+	const detexHDRParameters *previous_params = detex_active_hdr_parameters;
+	detex_active_hdr_parameters = params;
+	return previous_params;
+}
+
+// Gamma-corrected half-float tables. The tables are shared by all threads in a
+// process-wide list, keyed by gamma value and reference-counted. Each thread references
+// the tables for the last few gamma values it used, so that alternating between the
+// parameters of several textures does not recalculate tables. A thread releases its
+// references when they are replaced or when it exits, and a table is freed when it is
+// no longer referenced.
+
+#define NU_THREAD_GAMMA_TABLES 4
+
+typedef struct GammaCorrectedHalfFloatTable {
+	struct GammaCorrectedHalfFloatTable *next;
+	float gamma;
+	int nu_references;
+	float table[65536];
+} GammaCorrectedHalfFloatTable;
+
+static GammaCorrectedHalfFloatTable *gamma_corrected_half_float_tables = NULL;
+static pthread_mutex_t mutex_gamma_corrected_half_float_tables = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t gamma_corrected_half_float_table_key;
+static pthread_once_t gamma_corrected_half_float_table_key_once = PTHREAD_ONCE_INIT;
+
+// The tables referenced by the thread, most recently used first.
+static __thread GammaCorrectedHalfFloatTable *thread_gamma_tables[NU_THREAD_GAMMA_TABLES];
+
+static void ReleaseGammaCorrectedHalfFloatTable(GammaCorrectedHalfFloatTable *t) {
+	pthread_mutex_lock(&mutex_gamma_corrected_half_float_tables);
+	t->nu_references--;
+	if (t->nu_references == 0) {
+		GammaCorrectedHalfFloatTable **p = &gamma_corrected_half_float_tables;
+		while (*p != t)
+			p = &(*p)->next;
+		*p = t->next;
+		free(t);
+	}
+	pthread_mutex_unlock(&mutex_gamma_corrected_half_float_tables);
+}
+
+// Key destructor that releases the references of a thread when it exits.
+static void ReleaseThreadGammaCorrectedHalfFloatTables(void *tables) {
+	GammaCorrectedHalfFloatTable **t = (GammaCorrectedHalfFloatTable **)tables;
+	for (int i = 0; i < NU_THREAD_GAMMA_TABLES; i++)
+		if (t[i] != NULL) {
+			ReleaseGammaCorrectedHalfFloatTable(t[i]);
+			t[i] = NULL;
+		}
+}
+
+static void CreateGammaCorrectedHalfFloatTableKey() {
+	pthread_key_create(&gamma_corrected_half_float_table_key, ReleaseThreadGammaCorrectedHalfFloatTables);
+}
+
+static DETEX_INLINE_ONLY float GetGammaCorrectedFloat(float f, float gamma) {
+	if (f >= 0.0f)
+		return powf(f, 1.0f / gamma);
+	else
+		return - powf(- f, 1.0f / gamma);
+}
+
+// Return a reference to the table for a gamma value, calculating it if no thread
+// references it yet. The calculation is done with the lock held, so that threads that
+// need the same table concurrently calculate it only once. Returns NULL when out of
+// memory.
+static GammaCorrectedHalfFloatTable *AcquireGammaCorrectedHalfFloatTable(float gamma) {
+	pthread_mutex_lock(&mutex_gamma_corrected_half_float_tables);
+	GammaCorrectedHalfFloatTable *t = gamma_corrected_half_float_tables;
+	while (t != NULL && t->gamma != gamma)
+		t = t->next;
+	if (t == NULL) {
+		t = (GammaCorrectedHalfFloatTable *)malloc(sizeof(GammaCorrectedHalfFloatTable));
+		if (t == NULL) {
+			pthread_mutex_unlock(&mutex_gamma_corrected_half_float_tables);
+			detexSetErrorMessage("AcquireGammaCorrectedHalfFloatTable: Out of memory, "
+				"gamma correction is calculated without a table");
+			return NULL;
+		}
+		t->gamma = gamma;
+		t->nu_references = 0;
+		float *float_table = t->table;
+		detexValidateHalfFloatTable();
+		memcpy(float_table, detex_half_float_table, 65536 * sizeof(float));
+		// Use the default rounding mode, so that the shared table does not depend on the
+		// rounding mode of the thread that happens to calculate it.
+		int rounding_mode = fegetround();
+		fesetround(FE_TONEAREST);
+		for (int i = 0; i <= 0xFFFF; i++)
+			float_table[i] = GetGammaCorrectedFloat(float_table[i], gamma);
+		fesetround(rounding_mode);
+		t->next = gamma_corrected_half_float_tables;
+		gamma_corrected_half_float_tables = t;
+	}
+	t->nu_references++;
+	pthread_mutex_unlock(&mutex_gamma_corrected_half_float_tables);
+	return t;
 }
 
-static DETEX_INLINE_ONLY void CalculateRangeFloat(float *buffer, int n,
+// Return the gamma-corrected half-float table for a gamma value, acquiring a reference
+// for the thread when required. Returns NULL when the table could not be allocated.
+static const float *ValidateGammaCorrectedHalfFloatTable(float gamma) {
+	GammaCorrectedHalfFloatTable **tables = thread_gamma_tables;
+	if (tables[0] != NULL && tables[0]->gamma == gamma)
+		return tables[0]->table;
+	int i;
+	for (i = 1; i < NU_THREAD_GAMMA_TABLES; i++)
+		if (tables[i] != NULL && tables[i]->gamma == gamma)
+			break;
+	GammaCorrectedHalfFloatTable *t;
+	if (i < NU_THREAD_GAMMA_TABLES)
+		t = tables[i];
+	else {
+		pthread_once(&gamma_corrected_half_float_table_key_once, CreateGammaCorrectedHalfFloatTableKey);
+		t = AcquireGammaCorrectedHalfFloatTable(gamma);
+		if (t == NULL)
+			return NULL;
+		i = NU_THREAD_GAMMA_TABLES - 1;
+		if (tables[i] != NULL)
+			ReleaseGammaCorrectedHalfFloatTable(tables[i]);
+		pthread_setspecific(gamma_corrected_half_float_table_key, tables);
+	}
+	// Move the table to the front.
+	for (; i > 0; i--)
+		tables[i] = tables[i - 1];
+	tables[0] = t;
+	return t->table;
+}
+
+// Dynamic range calculation. NaNs are ignored. Half-float values are compared as
+// integers without conversion to float: mapping the sign and magnitude to a signed
+// 16-bit key (negative values become negative keys) preserves their order, so that
+// eight or sixteen values are compared with a single SIMD instruction. Large buffers are
+// divided between threads.
+
+// Keys outside the range of non-NaN half-floats ([-0x7C00, 0x7C00]) used as the initial
+// minimum and maximum.
+#define HALF_FLOAT_KEY_MIN_INITIAL 0x7FFF
+#define HALF_FLOAT_KEY_MAX_INITIAL (- 0x7FFF)
+
+// Buffers with fewer values than this are processed by the calling thread only.
+#define PARALLEL_RANGE_VALUES_PER_THREAD (1 << 20)
+#define MAX_RANGE_THREADS 64
+
+typedef struct {
+	const void *buffer;
+	size_t n;
+	bool half_float;
+	// For half-floats, the minimum and maximum keys are stored as floats (exactly).
+	float range_min;
+	float range_max;
+} RangeTask;
+
+static DETEX_INLINE_ONLY int GetHalfFloatKey(uint16_t hf) {
+	int magnitude = hf & 0x7FFF;
+	return (hf & 0x8000) ? - magnitude : magnitude;
+}
+
+static DETEX_INLINE_ONLY float GetFloatFromHalfFloatKey(int key) {
+	uint16_t hf = key < 0 ? (uint16_t)(0x8000 | - key) : (uint16_t)key;
+	return detexGetFloatFromHalfFloat(hf);
+}
+
+#ifdef DETEX_USE_SSE2
+
+static size_t CalculateRangeFloatSSE2(const float *buffer, size_t n, float *range_min_out,
+float *range_max_out) {
+	__m128 range_min = _mm_set1_ps(*range_min_out);
+	__m128 range_max = _mm_set1_ps(*range_max_out);
+	size_t i;
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128 f = _mm_loadu_ps(&buffer[i]);
+		// When f is NaN, the second operand is returned.
+		range_min = _mm_min_ps(f, range_min);
+		range_max = _mm_max_ps(f, range_max);
+	}
+	float m[4], M[4];
+	_mm_storeu_ps(m, range_min);
+	_mm_storeu_ps(M, range_max);
+	for (int j = 0; j < 4; j++) {
+		if (m[j] < *range_min_out)
+			*range_min_out = m[j];
+		if (M[j] > *range_max_out)
+			*range_max_out = M[j];
+	}
+	return i;
+}
+
+// Return the keys of eight half-floats, replacing NaNs with the given key.
+static DETEX_INLINE_ONLY __m128i GetHalfFloatKeysSSE2(__m128i h, __m128i nan_key) {
+	__m128i magnitude = _mm_and_si128(h, _mm_set1_epi16(0x7FFF));
+	__m128i sign = _mm_srai_epi16(h, 15);
+	__m128i key = _mm_sub_epi16(_mm_xor_si128(magnitude, sign), sign);
+	__m128i nan = _mm_cmpgt_epi16(magnitude, _mm_set1_epi16(0x7C00));
+	return _mm_or_si128(_mm_and_si128(nan, nan_key), _mm_andnot_si128(nan, key));
+}
+
+static size_t CalculateRangeHalfFloatSSE2(const uint16_t *buffer, size_t n, int *min_key_out,
+int *max_key_out) {
+	__m128i min_key = _mm_set1_epi16(HALF_FLOAT_KEY_MIN_INITIAL);
+	__m128i max_key = _mm_set1_epi16(HALF_FLOAT_KEY_MAX_INITIAL);
+	size_t i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i h = _mm_loadu_si128((__m128i *)&buffer[i]);
+		min_key = _mm_min_epi16(min_key, GetHalfFloatKeysSSE2(h, _mm_set1_epi16(HALF_FLOAT_KEY_MIN_INITIAL)));
+		max_key = _mm_max_epi16(max_key, GetHalfFloatKeysSSE2(h, _mm_set1_epi16(HALF_FLOAT_KEY_MAX_INITIAL)));
+	}
+	int16_t m[8], M[8];
+	_mm_storeu_si128((__m128i *)m, min_key);
+	_mm_storeu_si128((__m128i *)M, max_key);
+	for (int j = 0; j < 8; j++) {
+		if (m[j] < *min_key_out)
+			*min_key_out = m[j];
+		if (M[j] > *max_key_out)
+			*max_key_out = M[j];
+	}
+	return i;
+}
+
+#endif
+
+#ifdef DETEX_USE_AVX2
+
+static DETEX_TARGET_AVX2 size_t CalculateRangeFloatAVX2(const float *buffer, size_t n,
 float *range_min_out, float *range_max_out) {
+	__m256 range_min = _mm256_set1_ps(*range_min_out);
+	__m256 range_max = _mm256_set1_ps(*range_max_out);
+	size_t i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256 f = _mm256_loadu_ps(&buffer[i]);
+		range_min = _mm256_min_ps(f, range_min);
+		range_max = _mm256_max_ps(f, range_max);
+	}
+	float m[8], M[8];
+	_mm256_storeu_ps(m, range_min);
+	_mm256_storeu_ps(M, range_max);
+	for (int j = 0; j < 8; j++) {
+		if (m[j] < *range_min_out)
+			*range_min_out = m[j];
+		if (M[j] > *range_max_out)
+			*range_max_out = M[j];
+	}
+	return i;
+}
+
+static DETEX_TARGET_AVX2 size_t CalculateRangeHalfFloatAVX2(const uint16_t *buffer, size_t n,
+int *min_key_out, int *max_key_out) {
+	__m256i min_key = _mm256_set1_epi16(HALF_FLOAT_KEY_MIN_INITIAL);
+	__m256i max_key = _mm256_set1_epi16(HALF_FLOAT_KEY_MAX_INITIAL);
+	size_t i;
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i h = _mm256_loadu_si256((__m256i *)&buffer[i]);
+		__m256i magnitude = _mm256_and_si256(h, _mm256_set1_epi16(0x7FFF));
+		__m256i sign = _mm256_srai_epi16(h, 15);
+		__m256i key = _mm256_sub_epi16(_mm256_xor_si256(magnitude, sign), sign);
+		__m256i nan = _mm256_cmpgt_epi16(magnitude, _mm256_set1_epi16(0x7C00));
+		min_key = _mm256_min_epi16(min_key, _mm256_blendv_epi8(key,
+			_mm256_set1_epi16(HALF_FLOAT_KEY_MIN_INITIAL), nan));
+		max_key = _mm256_max_epi16(max_key, _mm256_blendv_epi8(key,
+			_mm256_set1_epi16(HALF_FLOAT_KEY_MAX_INITIAL), nan));
+	}
+	int16_t m[16], M[16];
+	_mm256_storeu_si256((__m256i *)m, min_key);
+	_mm256_storeu_si256((__m256i *)M, max_key);
+	for (int j = 0; j < 16; j++) {
+		if (m[j] < *min_key_out)
+			*min_key_out = m[j];
+		if (M[j] > *max_key_out)
+			*max_key_out = M[j];
+	}
+	return i;
+}
+
+#endif
+
+// Without SIMD, the range is calculated by the scalar code.
+static size_t CalculateRangeFloatNone(const float *buffer, size_t n, float *range_min_out,
+float *range_max_out) {
+	return 0;
+}
+
+static size_t CalculateRangeHalfFloatNone(const uint16_t *buffer, size_t n, int *min_key_out,
+int *max_key_out) {
+	return 0;
+}
+
+DETEX_DEFINE_KERNEL(CalculateRangeFloatKernel, size_t, (const float *buffer, size_t n,
+	float *range_min_out, float *range_max_out), (buffer, n, range_min_out, range_max_out))
+DETEX_DEFINE_KERNEL(CalculateRangeHalfFloatKernel, size_t, (const uint16_t *buffer, size_t n,
+	int *min_key_out, int *max_key_out), (buffer, n, min_key_out, max_key_out))
+
+void detexSelectHDRKernels(int level) {
+	size_t (*float_kernel)(const float *, size_t, float *, float *) = CalculateRangeFloatNone;
+	size_t (*half_float_kernel)(const uint16_t *, size_t, int *, int *) =
+		CalculateRangeHalfFloatNone;
+#ifdef DETEX_USE_SSE2
+	if (level >= DETEX_SIMD_LEVEL_SSE2) {
+		float_kernel = CalculateRangeFloatSSE2;
+		half_float_kernel = CalculateRangeHalfFloatSSE2;
+	}
+#endif
+#ifdef DETEX_USE_AVX2
+	if (level >= DETEX_SIMD_LEVEL_AVX2) {
+		float_kernel = CalculateRangeFloatAVX2;
+		half_float_kernel = CalculateRangeHalfFloatAVX2;
+	}
+#endif
+	DETEX_SET_KERNEL(CalculateRangeFloatKernel, float_kernel);
+	DETEX_SET_KERNEL(CalculateRangeHalfFloatKernel, half_float_kernel);
+}
+
+static void CalculateRangeFloat(const float *buffer, size_t n, float *range_min_out,
+float *range_max_out) {
 	float range_min = FLT_MAX;
 	float range_max = - FLT_MAX;
-	for (int i = 0; i < n; i++) {
+	size_t i = DETEX_GET_KERNEL(CalculateRangeFloatKernel)(buffer, n, &range_min, &range_max);
+	for (; i < n; i++) {
 		float f = buffer[i];
 		if (f < range_min)
 			range_min = f;
@@ -74,39 +370,107 @@ float *range_min_out, float *range_max_out) {
 	*range_max_out = range_max;
 }
 
-static DETEX_INLINE_ONLY void CalculateRangeHalfFloat(uint16_t *buffer, int n,
-float *range_min_out, float *range_max_out) {
-	detexValidateHalfFloatTable();
-	float range_min = FLT_MAX;
-	float range_max = - FLT_MAX;
-	for (int i = 0; i < n; i ++) {
-		float f = detexGetFloatFromHalfFloat(buffer[i]);
-		if (f < range_min)
-			range_min = f;
-		if (f > range_max)
-			range_max = f;
+static void CalculateRangeHalfFloat(const uint16_t *buffer, size_t n, int *min_key_out,
+int *max_key_out) {
+	int min_key = HALF_FLOAT_KEY_MIN_INITIAL;
+	int max_key = HALF_FLOAT_KEY_MAX_INITIAL;
+	size_t i = DETEX_GET_KERNEL(CalculateRangeHalfFloatKernel)(buffer, n, &min_key, &max_key);
+	for (; i < n; i++) {
+		if ((buffer[i] & 0x7FFF) > 0x7C00)
+			// NaN.
+			continue;
+		int key = GetHalfFloatKey(buffer[i]);
+		if (key < min_key)
+			min_key = key;
+		if (key > max_key)
+			max_key = key;
+	}
+	*min_key_out = min_key;
+	*max_key_out = max_key;
+}
+
+static void *RangeTaskThread(void *data) {
+	RangeTask *task = (RangeTask *)data;
+	if (task->half_float) {
+		int min_key, max_key;
+		CalculateRangeHalfFloat((const uint16_t *)task->buffer, task->n, &min_key, &max_key);
+		task->range_min = min_key;
+		task->range_max = max_key;
+	}
+	else
+		CalculateRangeFloat((const float *)task->buffer, task->n, &task->range_min, &task->range_max);
+	return NULL;
+}
+
+static void CalculateRange(const void *buffer, size_t n, bool half_float, float *range_min_out,
+float *range_max_out) {
+	long nu_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int nu_threads = nu_cpus > 0 ? (int)nu_cpus : 1;
+	if ((size_t)nu_threads > n / PARALLEL_RANGE_VALUES_PER_THREAD)
+		nu_threads = (int)(n / PARALLEL_RANGE_VALUES_PER_THREAD);
+	if (nu_threads > MAX_RANGE_THREADS)
+		nu_threads = MAX_RANGE_THREADS;
+	if (nu_threads < 1)
+		nu_threads = 1;
+	RangeTask tasks[MAX_RANGE_THREADS];
+	pthread_t threads[MAX_RANGE_THREADS];
+	bool thread_created[MAX_RANGE_THREADS];
+	int value_size = half_float ? 2 : 4;
+	for (int i = 0; i < nu_threads; i++) {
+		size_t start = n * i / nu_threads;
+		tasks[i].buffer = (const uint8_t *)buffer + start * value_size;
+		tasks[i].n = n * (i + 1) / nu_threads - start;
+		tasks[i].half_float = half_float;
+		thread_created[i] = false;
+		if (i > 0)
+			thread_created[i] = (pthread_create(&threads[i], NULL, RangeTaskThread, &tasks[i]) == 0);
+	}
+	RangeTaskThread(&tasks[0]);
+	for (int i = 1; i < nu_threads; i++)
+		if (thread_created[i])
+			pthread_join(threads[i], NULL);
+		else
+			// Thread creation failed; process the part on the calling thread.
+			RangeTaskThread(&tasks[i]);
+	float range_min = tasks[0].range_min;
+	float range_max = tasks[0].range_max;
+	for (int i = 1; i < nu_threads; i++) {
+		if (tasks[i].range_min < range_min)
+			range_min = tasks[i].range_min;
+		if (tasks[i].range_max > range_max)
+			range_max = tasks[i].range_max;
+	}
+	if (half_float) {
+		// Convert the keys. As with floats, infinities do not replace the initial values
+		// FLT_MAX and - FLT_MAX in the comparisons.
+		detexValidateHalfFloatTable();
+		range_min = range_min == HALF_FLOAT_KEY_MIN_INITIAL ? FLT_MAX :
+			GetFloatFromHalfFloatKey((int)range_min);
+		range_max = range_max == HALF_FLOAT_KEY_MAX_INITIAL ? - FLT_MAX :
+			GetFloatFromHalfFloatKey((int)range_max);
+		if (range_min > FLT_MAX)
+			range_min = FLT_MAX;
+		if (range_max < - FLT_MAX)
+			range_max = - FLT_MAX;
 	}
 	*range_min_out = range_min;
 	*range_max_out = range_max;
 }
 
-
 bool detexCalculateDynamicRange(uint8_t *pixel_buffer, int nu_pixels, uint32_t pixel_format,
 float *range_min_out, float *range_max_out) {
-	if (~(pixel_format & DETEX_PIXEL_FORMAT_FLOAT_BIT)) {
+	if (!(pixel_format & DETEX_PIXEL_FORMAT_FLOAT_BIT)) {
 		detexSetErrorMessage("detexCalculateDynamicRange: Pixel buffer not in float format");
 		return false;
 	}
 	if (pixel_format & DETEX_PIXEL_FORMAT_16BIT_COMPONENT_BIT) {
-		CalculateRangeHalfFloat((uint16_t *)pixel_buffer,
-			nu_pixels * detexGetPixelSize(pixel_format) / 2,
-			range_min_out, range_max_out);
+		CalculateRange(pixel_buffer, (size_t)nu_pixels * detexGetPixelSize(pixel_format) / 2,
+			true, range_min_out, range_max_out);
 		return true;
 	}
 	else if (pixel_format & DETEX_PIXEL_FORMAT_32BIT_COMPONENT_BIT) {
-		CalculateRangeFloat((float *)pixel_buffer,
-			nu_pixels * detexGetPixelSize(pixel_format) / 4,
-			range_min_out, range_max_out);
+		CalculateRange(pixel_buffer, (size_t)nu_pixels * detexGetPixelSize(pixel_format) / 4,
+			false, range_min_out, range_max_out);
 		return true;
 	}
 	else {
@@ -115,11 +479,22 @@ float *range_min_out, float *range_max_out) {
 	}
 }
 
+bool detexCalculateDynamicRangeParameters(uint8_t *pixel_buffer, int nu_pixels, uint32_t pixel_format,
+detexHDRParameters *params) {
+	float range_min, range_max;
+	if (!detexCalculateDynamicRange(pixel_buffer, nu_pixels, pixel_format, &range_min, &range_max))
+		return false;
+	params->range_min = range_min;
+	params->range_max = range_max;
+	return true;
+}
+
 // Convert half floats to unsigned 16-bit integers in place with gamma value of 1.
-static DETEX_INLINE_ONLY void detexConvertHDRHalfFloatToUInt16Gamma1(uint16_t *buffer, int n) {
+static DETEX_INLINE_ONLY void detexConvertHDRHalfFloatToUInt16Gamma1(uint16_t *buffer, int n,
+const detexHDRParameters *params) {
 	detexValidateHalfFloatTable();
-	float range_min = detex_gamma_range_min;
-	float range_max = detex_gamma_range_max;
+	float range_min = params->range_min;
+	float range_max = params->range_max;
 	fesetround(FE_DOWNWARD);
 	if (range_min == 0.0f && range_max == 1.0f) {
 		for (int i = 0; i < n; i++) {
@@ -137,12 +512,12 @@ static DETEX_INLINE_ONLY void detexConvertHDRHalfFloatToUInt16Gamma1(uint16_t *b
 	}
 }
 
-static DETEX_INLINE_ONLY void detexConvertHDRHalfFloatToUInt16SpecialGamma(uint16_t *buffer, int n) {
-	float gamma = detex_gamma;
-	float range_min = detex_gamma_range_min;
-	float range_max = detex_gamma_range_max;
-	ValidateGammaCorrectedHalfFloatTable(gamma);
-	float *corrected_half_float_table = detex_gamma_corrected_half_float_table;
+static DETEX_INLINE_ONLY void detexConvertHDRHalfFloatToUInt16SpecialGamma(uint16_t *buffer, int n,
+const detexHDRParameters *params) {
+	float gamma = params->gamma;
+	float range_min = params->range_min;
+	float range_max = params->range_max;
+	const float *corrected_half_float_table = ValidateGammaCorrectedHalfFloatTable(gamma);
 	float corrected_range_min, corrected_range_max;
 	if (range_min >= 0.0f)
 		corrected_range_min = powf(range_min, 1.0f / gamma);
@@ -153,6 +528,27 @@ static DETEX_INLINE_ONLY void detexConvertHDRHalfFloatToUInt16SpecialGamma(uint1
 	else
 		corrected_range_max = - powf(- range_max, 1.0f / gamma);
 	float factor = 1.0f / (corrected_range_max - corrected_range_min);
+	if (corrected_half_float_table == NULL) {
+		// Out of memory; apply the gamma correction to each value, in the rounding mode
+		// that the table is calculated in.
+		float corrected[64];
+		detexValidateHalfFloatTable();
+		int rounding_mode = fegetround();
+		for (int i = 0; i < n; i += 64) {
+			int nu_values = n - i < 64 ? n - i : 64;
+			fesetround(FE_TONEAREST);
+			for (int j = 0; j < nu_values; j++)
+				corrected[j] = GetGammaCorrectedFloat(detexGetFloatFromHalfFloat(buffer[i + j]),
+					gamma);
+			fesetround(rounding_mode);
+			for (int j = 0; j < nu_values; j++) {
+				float f = corrected[j];
+				int u = lrintf(detexClamp0To1((f - corrected_range_min) * factor) * 65535.0f + 0.5f);
+				buffer[i + j] = (uint16_t)u;
+			}
+		}
+		return;
+	}
 	for (int i = 0; i < n; i++) {
 		float f = corrected_half_float_table[buffer[i]];
 		int u = lrintf(detexClamp0To1((f - corrected_range_min) * factor) * 65535.0f + 0.5f);
@@ -160,16 +556,17 @@ static DETEX_INLINE_ONLY void detexConvertHDRHalfFloatToUInt16SpecialGamma(uint1
 	}
 }
 
-void detexConvertHDRHalfFloatToUInt16(uint16_t *buffer, int n) {
-	if (detex_gamma == 1.0f)
-		detexConvertHDRHalfFloatToUInt16Gamma1(buffer, n);
+void detexConvertHDRHalfFloatToUInt16(uint16_t *buffer, int n, const detexHDRParameters *params) {
+	if (params->gamma == 1.0f)
+		detexConvertHDRHalfFloatToUInt16Gamma1(buffer, n, params);
 	else
-		detexConvertHDRHalfFloatToUInt16SpecialGamma(buffer, n);
+		detexConvertHDRHalfFloatToUInt16SpecialGamma(buffer, n, params);
 }
 
-static DETEX_INLINE_ONLY void detexConvertHDRFloatToFloatGamma1(float *buffer, int n) {
-	float range_min = detex_gamma_range_min;
-	float range_max = detex_gamma_range_max;
+static DETEX_INLINE_ONLY void detexConvertHDRFloatToFloatGamma1(float *buffer, int n,
+const detexHDRParameters *params) {
+	float range_min = params->range_min;
+	float range_max = params->range_max;
 	fesetround(FE_DOWNWARD);
 	if (range_min == 0.0f && range_max == 1.0f) {
 		for (int i = 0; i < n; i++) {
@@ -185,10 +582,11 @@ static DETEX_INLINE_ONLY void detexConvertHDRFloatToFloatGamma1(float *buffer, i
 	}
 }
 
-static DETEX_INLINE_ONLY void detexConvertHDRFloatToFloatSpecialGamma(float *buffer, int n) {
-	float gamma = detex_gamma;
-	float range_min = detex_gamma_range_min;
-	float range_max = detex_gamma_range_max;
+static DETEX_INLINE_ONLY void detexConvertHDRFloatToFloatSpecialGamma(float *buffer, int n,
+const detexHDRParameters *params) {
+	float gamma = params->gamma;
+	float range_min = params->range_min;
+	float range_max = params->range_max;
 	float corrected_range_min, corrected_range_max;
 	if (range_min >= 0.0f)
 		corrected_range_min = powf(range_min, 1.0f / gamma);
@@ -205,10 +603,10 @@ static DETEX_INLINE_ONLY void detexConvertHDRFloatToFloatSpecialGamma(float *buf
 	}
 }
 
-void detexConvertHDRFloatToFloat(float *buffer, int n) {
-	if (detex_gamma == 1.0f)
-		detexConvertHDRFloatToFloatGamma1(buffer, n);
+void detexConvertHDRFloatToFloat(float *buffer, int n, const detexHDRParameters *params) {
+	if (params->gamma == 1.0f)
+		detexConvertHDRFloatToFloatGamma1(buffer, n, params);
 	else
-		detexConvertHDRFloatToFloatSpecialGamma(buffer, n);
+		detexConvertHDRFloatToFloatSpecialGamma(buffer, n, params);
 }
 
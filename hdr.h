@@ -16,7 +16,25 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 */
 
-void detexConvertHDRHalfFloatToUInt16(uint16_t *buffer, int n);
+// Thread-local gamma/HDR parameters set with detexSetHDRParameters().
+extern __thread detexHDRParameters detex_hdr_parameters;
 
-void detexConvertHDRFloatToFloat(float *buffer, int n);
+// HDR parameters passed explicitly to the function being executed by the thread, which
+// override the thread-local parameters, or NULL.
+extern __thread const detexHDRParameters *detex_active_hdr_parameters;
+
+// Set the explicit HDR parameters for the current thread (NULL to use the thread-local
+// parameters), returning the previous value so that it can be restored afterwards.
+const detexHDRParameters *detexSetActiveHDRParameters(const detexHDRParameters *params);
+
+// Return the HDR parameters in effect for the current thread.
+static DETEX_INLINE_ONLY const detexHDRParameters *detexGetHDRParameters() {
+	if (detex_active_hdr_parameters != NULL)
+		return detex_active_hdr_parameters;
+	return &detex_hdr_parameters;
+}
+
+void detexConvertHDRHalfFloatToUInt16(uint16_t *buffer, int n, const detexHDRParameters *params);
+
+void detexConvertHDRFloatToFloat(float *buffer, int n, const detexHDRParameters *params);
 
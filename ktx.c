@@ -23,38 +23,40 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "detex.h"
 #include "file-info.h"
 #include "misc.h"
+#include "stream.h"
 
 static const uint8_t ktx_id[12] = {
 	0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
 };
 
-// Load texture from KTX file with mip-maps. Returns true if successful.
-// nu_mipmaps is a return parameter that returns the number of mipmap levels found.
-// textures_out is a return parameter for an array of detexTexture pointers that is allocated,
-// free with free(). textures_out[i] are allocated textures corresponding to each level, free
-// with free();
-bool detexLoadKTXFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
-int *nu_levels_out) {
-	FILE *f = fopen(filename, "rb");
-	if (f == NULL) {
-		detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Could not open file %s", filename);
-		return false;
-	}
+// Properties of a KTX file read from its header.
+typedef struct {
+	const detexTextureFileInfo *info;
+	int width;
+	int height;
+	int nu_file_mipmaps;
+	bool wrong_endian;
+} KTXHeader;
+
+// Read the header of a KTX file, leaving the input source positioned at the image size
+// field of the first mipmap level. func_name and filename (NULL when not loading from a
+// file) are used in error messages.
+static bool ReadKTXHeader(detexInputSource *source, const char *func_name, const char *filename,
+KTXHeader *ktx_header) {
 	int header[16];
-	size_t s = fread(header, 1, 64, f);
-	if (s != 64) {
-		detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Error reading file %s", filename);
+	if (!detexReadInputSource(source, header, 64)) {
+		detexSetReadErrorMessage(func_name, filename);
 		return false;
 	}
 	if (memcmp(header, ktx_id, 12) != 0) {
 		// KTX signature not found.
-		detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Couldn't find KTX signature");
+		detexSetErrorMessage("%s: Couldn't find KTX signature", func_name);
 		return false;
 	}
-	int wrong_endian = 0;
+	ktx_header->wrong_endian = false;
 	if (header[3] == 0x01020304) {
 		// Wrong endian .ktx file.
-		wrong_endian = 1;
+		ktx_header->wrong_endian = true;
 		for (int i = 3; i < 16; i++) {
 			uint8_t *b = (uint8_t *)&header[i];
 			uint8_t temp = b[0];
@@ -69,112 +71,212 @@ int *nu_levels_out) {
 	int glFormat = header[6];
 	int glInternalFormat = header[7];
 //	int pixel_depth = header[11];
-	const detexTextureFileInfo *info = detexLookupKTXFileInfo(glInternalFormat, glFormat, glType);
-	if (info == NULL) {
-		detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Unsupported format in .ktx file "
-			"(glInternalFormat = 0x%04X)", glInternalFormat);
+	ktx_header->info = detexLookupKTXFileInfo(glInternalFormat, glFormat, glType);
+	if (ktx_header->info == NULL) {
+		detexSetErrorMessage("%s: Unsupported format in .ktx file "
+			"(glInternalFormat = 0x%04X)", func_name, glInternalFormat);
 		return false;
 	}
-	int bytes_per_block;
-	if (detexFormatIsCompressed(info->texture_format))
-		bytes_per_block = detexGetCompressedBlockSize(info->texture_format);
-	else
-		bytes_per_block = detexGetPixelSize(info->texture_format);
-	int block_width = info->block_width;
-	int block_height = info->block_height;
 //	printf("File is %s texture.\n", info->text1);
-	int width = header[9];
-	int height = header[10];
-	int extended_width = ((width + block_width - 1) / block_width) * block_width;
-	int extended_height = ((height + block_height - 1) / block_height) * block_height;
-	int nu_file_mipmaps = header[14];
+	ktx_header->width = header[9];
+	ktx_header->height = header[10];
+	ktx_header->nu_file_mipmaps = header[14];
 //	if (nu_file_mipmaps > 1 && max_mipmaps == 1) {
 //		detexSetErrorMessage("Disregarding mipmaps beyond the first level.\n");
 //	}
-	int nu_mipmaps;
-	if (nu_file_mipmaps > max_mipmaps)
-		nu_mipmaps = max_mipmaps;
-	else
-		nu_mipmaps = nu_file_mipmaps;
  	if (header[15] > 0) {
 		// Skip metadata.
-		uint8_t *metadata = (unsigned char *)malloc(header[15]);
-		if (fread(metadata, 1, header[15], f) < header[15]) {
-			detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Error reading file %s", filename);
+		if (!detexSkipInputSource(source, header[15])) {
+			detexSetReadErrorMessage(func_name, filename);
 			return false;
 		}
-		free(metadata);
 	}
+	return true;
+}
+
+// Set the properties of a mipmap level texture of the given size, without data.
+static void SetKTXLevel(const KTXHeader *ktx_header, int width, int height, detexTexture *texture) {
+	int block_width = ktx_header->info->block_width;
+	int block_height = ktx_header->info->block_height;
+	texture->format = ktx_header->info->texture_format;
+	texture->width = width;
+	texture->height = height;
+	texture->width_in_blocks = (width + block_width - 1) / block_width;
+	texture->height_in_blocks = (height + block_height - 1) / block_height;
+	texture->data = NULL;
+}
+
+// Read and check the image size field of a mipmap level.
+static bool ReadKTXImageSize(detexInputSource *source, const char *func_name, const char *filename,
+const KTXHeader *ktx_header, const detexTexture *texture, int level) {
+	uint32_t image_size_buffer[1];
+	if (!detexReadInputSource(source, image_size_buffer, 4)) {
+		detexSetReadErrorMessage(func_name, filename);
+		return false;
+	}
+	if (ktx_header->wrong_endian) {
+		uint8_t *image_size_bytep = (uint8_t *)&image_size_buffer[0];
+		unsigned char temp = image_size_buffer[0];
+		image_size_bytep[0] = image_size_bytep[3];
+		image_size_bytep[3] = temp;
+		temp = image_size_bytep[1];
+		image_size_bytep[1] = image_size_bytep[2];
+		image_size_bytep[2] = temp;
+	}
+	int image_size = image_size_buffer[0];
+	int data_size = texture->width_in_blocks * texture->height_in_blocks *
+		detexGetFileBytesPerBlock(texture->format);
+	if (image_size != data_size) {
+		if (filename != NULL)
+			detexSetErrorMessage("%s: Error loading file %s: "
+				"Image size field of mipmap level %d does not match (%d vs %d)",
+				func_name, filename, level, image_size, data_size);
+		else
+			detexSetErrorMessage("%s: Image size field of mipmap level %d does not match "
+				"(%d vs %d)", func_name, level, image_size, data_size);
+		return false;
+	}
+	return true;
+}
+
+// Load texture from KTX input source with mip-maps. When reference_data is true, the
+// texture data references the memory of the input source instead of being copied.
+// func_name and filename (NULL when not loading from a file) are used in error messages.
+static bool LoadKTXWithMipmaps(detexInputSource *source, const char *func_name, const char *filename,
+int max_mipmaps, bool reference_data, detexTexture ***textures_out, int *nu_levels_out) {
+	KTXHeader ktx_header;
+	if (!ReadKTXHeader(source, func_name, filename, &ktx_header))
+		return false;
+	int width = ktx_header.width;
+	int height = ktx_header.height;
+	int nu_mipmaps;
+	if (ktx_header.nu_file_mipmaps > max_mipmaps)
+		nu_mipmaps = max_mipmaps;
+	else
+		nu_mipmaps = ktx_header.nu_file_mipmaps;
 	detexTexture **textures = (detexTexture **)malloc(sizeof(detexTexture *) * nu_mipmaps);
 	for (int i = 0; i < nu_mipmaps; i++) {
-		uint32_t image_size_buffer[1];
-		size_t r = fread(image_size_buffer, 1, 4, f);
-		if (r != 4) {
-			for (int j = 0; j < i; j++)
-				free(textures[j]);
-			free(textures);
-			detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Error reading file %s", filename);
+		// Allocate texture.
+		textures[i] = (detexTexture *)malloc(sizeof(detexTexture));
+		SetKTXLevel(&ktx_header, width, height, textures[i]);
+		if (!ReadKTXImageSize(source, func_name, filename, &ktx_header, textures[i], i)) {
+			detexFreeLoadedTextures(textures, i + 1, reference_data ? source : NULL);
 			return false;
 		}
-		if (wrong_endian) {
-			uint8_t *image_size_bytep = (uint8_t *)&image_size_buffer[0];
-			unsigned char temp = image_size_buffer[0];
-			image_size_bytep[0] = image_size_bytep[3];
-			image_size_bytep[3] = temp;
-			temp = image_size_bytep[1];
-			image_size_bytep[1] = image_size_bytep[2];
-			image_size_bytep[2] = temp;
+		int image_size = textures[i]->width_in_blocks * textures[i]->height_in_blocks *
+			detexGetFileBytesPerBlock(textures[i]->format);
+		bool r;
+		if (reference_data) {
+			textures[i]->data = detexReferenceTextureData(source, image_size);
+			r = (textures[i]->data != NULL);
 		}
-		int image_size = image_size_buffer[0];
-		int n = (extended_height / block_height) * (extended_width / block_width);
-		if (image_size != n * bytes_per_block) {
-			for (int j = 0; j < i; j++)
-				free(textures[j]);
-			free(textures);
-			detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Error loading file %s: "
-				"Image size field of mipmap level %d does not match (%d vs %d)",
-				filename, i, image_size, n * bytes_per_block);
-			return false;
+		else {
+			textures[i]->data = (uint8_t *)malloc(image_size);
+			r = detexReadInputSource(source, textures[i]->data, image_size);
 		}
-		// Allocate texture.
-		textures[i] = (detexTexture *)malloc(sizeof(detexTexture));
-		textures[i]->format = info->texture_format;
-		textures[i]->data = (uint8_t *)malloc(n * bytes_per_block);
-		textures[i]->width = width;
-		textures[i]->height = height;
-		textures[i]->width_in_blocks = extended_width / block_width;
-		textures[i]->height_in_blocks = extended_height / block_height;
-		if (fread(textures[i]->data, 1, n * bytes_per_block, f) < n * bytes_per_block) {
-			for (int j = 0; j <= i; j++)
-				free(textures[j]);
-			free(textures);
-			detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Error reading file %s", filename);
+		if (!r) {
+			detexFreeLoadedTextures(textures, i + 1, reference_data ? source : NULL);
+			detexSetReadErrorMessage(func_name, filename);
 			return false;
 		}
 		// Divide by two for the next mipmap level, rounding down.
 		width >>= 1;
 		height >>= 1;
-		extended_width = ((width + block_width - 1) / block_width) * block_width;
-		extended_height = ((height + block_height - 1) / block_height) * block_height;
 		// Read mipPadding. But not if we have already read everything specified.
-		char buffer[4];
 		if (i + 1 < nu_mipmaps) {
 			int nu_bytes = 3 - ((image_size + 3) % 4);
-			if (fread(buffer, 1, nu_bytes, f) != nu_bytes) {
-				for (int j = 0; j <= i; j++)
-					free(textures[j]);
-				free(textures);
-				detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Error reading file %s", filename);
+			if (!detexSkipInputSource(source, nu_bytes)) {
+				detexFreeLoadedTextures(textures, i + 1, reference_data ? source : NULL);
+				detexSetReadErrorMessage(func_name, filename);
 				return false;
 			}
 		}
 	}
-	fclose(f);
 	*nu_levels_out = nu_mipmaps;
 	*textures_out = textures;
 	return true;
 }
 
+// Read the header of a KTX file from an input source, leaving the source positioned at
+// the data of the first mipmap level, the properties of which are returned in
+// texture_out (with data set to NULL).
+bool detexReadKTXFirstLevel(detexInputSource *source, const char *func_name, const char *filename,
+detexTexture *texture_out) {
+	KTXHeader ktx_header;
+	if (!ReadKTXHeader(source, func_name, filename, &ktx_header))
+		return false;
+	if (ktx_header.nu_file_mipmaps < 1) {
+		detexSetErrorMessage("%s: No mipmap levels in .ktx file", func_name);
+		return false;
+	}
+	SetKTXLevel(&ktx_header, ktx_header.width, ktx_header.height, texture_out);
+	return ReadKTXImageSize(source, func_name, filename, &ktx_header, texture_out, 0);
+}
+
+// Load texture from KTX file with mip-maps. Returns true if successful.
+// nu_mipmaps is a return parameter that returns the number of mipmap levels found.
+// textures_out is a return parameter for an array of detexTexture pointers that is allocated,
+// free with free(). textures_out[i] are allocated textures corresponding to each level, free
+// with free();
+bool detexLoadKTXFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
+int *nu_levels_out) {
+	FILE *f = fopen(filename, "rb");
+	if (f == NULL) {
+		detexSetErrorMessage("detexLoadKTXFileWithMipmaps: Could not open file %s", filename);
+		return false;
+	}
+	detexInputSource source;
+	detexInitFileInputSource(&source, f);
+	bool r = LoadKTXWithMipmaps(&source, "detexLoadKTXFileWithMipmaps", filename, max_mipmaps, false,
+		textures_out, nu_levels_out);
+	fclose(f);
+	return r;
+}
+
+// Map KTX file into memory with mip-maps. Returns true if successful. The texture data
+// references the mapped file. textures_out and nu_levels_out are return parameters as with
+// detexLoadKTXFileWithMipmaps, but the textures are owned by the mapped file that is
+// returned in file_out and must be released with detexReleaseMappedTextureFile().
+bool detexMapKTXFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
+int *nu_levels_out, detexMappedTextureFile **file_out) {
+	detexMappedTextureFile *file = detexMapFile(filename, "detexMapKTXFileWithMipmaps");
+	if (file == NULL)
+		return false;
+	detexInputSource source;
+	detexInitMemoryInputSource(&source, (const uint8_t *)file->mapping, file->size);
+	if (!LoadKTXWithMipmaps(&source, "detexMapKTXFileWithMipmaps", filename, max_mipmaps, true,
+	&file->textures, &file->nu_levels)) {
+		detexReleaseMappedTextureFile(file);
+		return false;
+	}
+	*textures_out = file->textures;
+	*nu_levels_out = file->nu_levels;
+	*file_out = file;
+	return true;
+}
+
+// Load texture from KTX file data in memory with mip-maps. Returns true if successful.
+// The texture data is copied; textures_out and nu_levels_out are return parameters as with
+// detexLoadKTXFileWithMipmaps.
+bool detexLoadKTXMemoryWithMipmaps(const uint8_t *data, size_t size, int max_mipmaps,
+detexTexture ***textures_out, int *nu_levels_out) {
+	detexInputSource source;
+	detexInitMemoryInputSource(&source, data, size);
+	return LoadKTXWithMipmaps(&source, "detexLoadKTXMemoryWithMipmaps", NULL, max_mipmaps, false,
+		textures_out, nu_levels_out);
+}
+
+// Load texture from KTX file data read from a stream with mip-maps. Returns true if
+// successful. textures_out and nu_levels_out are return parameters as with
+// detexLoadKTXFileWithMipmaps.
+bool detexLoadKTXStreamWithMipmaps(detexReadFunc read_func, void *user_data, int max_mipmaps,
+detexTexture ***textures_out, int *nu_levels_out) {
+	detexInputSource source;
+	detexInitStreamInputSource(&source, read_func, user_data);
+	return LoadKTXWithMipmaps(&source, "detexLoadKTXStreamWithMipmaps", NULL, max_mipmaps, false,
+		textures_out, nu_levels_out);
+}
+
 // Load texture from KTX file (first mip-map only). Returns true if successful.
 // The texture is allocated, free with free().
 bool detexLoadKTXFile(const char *filename, detexTexture **texture_out) {
@@ -203,24 +305,22 @@ static const char ktx_orientation_key_up[24] = {
 	'S', '=', 'r', ',', 'T', '=', 'u', 0, 0		// Includes one byte of padding.
 };
 
-// Save textures to KTX file (multiple mip-maps levels). Return true if succesful.
-bool detexSaveKTXFileWithMipmaps(detexTexture **textures, int nu_levels, const char *filename) {
-	FILE *f = fopen(filename, "wb");
-	if (f == NULL) {
-		detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Could not open file %s for writing", filename);
-		return false;
-	}
+// Save textures in KTX format (multiple mip-maps levels) using a write callback. Return true
+// if succesful. func_name and filename (NULL when not saving to a file) are used in error
+// messages.
+static bool SaveKTXWithMipmaps(detexTexture **textures, int nu_levels, detexWriteFunc write_func,
+void *user_data, const char *func_name, const char *filename) {
 	uint32_t header[16];
 	memset(header, 0, 64);
 	memcpy(header, ktx_id, 12);	// Set id.
 	header[3] = 0x04030201;
 	const detexTextureFileInfo *info = detexLookupTextureFormatFileInfo(textures[0]->format);
 	if (info == NULL) {
-		detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Could not match texture format with file format");
+		detexSetErrorMessage("%s: Could not match texture format with file format", func_name);
 		return false;
 	}
 	if (!info->ktx_support) {
-		detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Could not match texture format with KTX file format");
+		detexSetErrorMessage("%s: Could not match texture format with KTX file format", func_name);
 		return false;
 	}
 	int glType = 0;
@@ -242,31 +342,31 @@ bool detexSaveKTXFileWithMipmaps(detexTexture **textures, int nu_levels, const c
 	const int option_orientation = 0;
 	if (option_orientation == 0) {
 		header[15] = 0;
-		size_t r = fwrite(header, 1, 64, f);
+		size_t r = write_func(user_data, header, 64);
 		if (r != 64) {
-			detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Error writing to file %s", filename);
+			detexSetWriteErrorMessage(func_name, filename);
 			return false;
 		}
 	}
 	else {
 		header[15] = 28;	// Key value data bytes.
-		size_t r = fwrite(header, 1, 64, f);
+		size_t r = write_func(user_data, header, 64);
 		if (r != 64) {
-			detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Error writing to file %s", filename);
+			detexSetWriteErrorMessage(func_name, filename);
 			return false;
 		}
 		data[0] = 27;		// Key and value size.
-		r = fwrite(data, 1, 4, f);
+		r = write_func(user_data, data, 4);
 		if (r != 4) {
-			detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Error writing to file %s", filename);
+			detexSetWriteErrorMessage(func_name, filename);
 			return false;
 		}
 		if (option_orientation == DETEX_ORIENTATION_DOWN)
-			r = fwrite(ktx_orientation_key_down, 1, 24, f);
+			r = write_func(user_data, ktx_orientation_key_down, 24);
 		else
-			r = fwrite(ktx_orientation_key_up, 1, 24, f);
+			r = write_func(user_data, ktx_orientation_key_up, 24);
 		if (r != 24) {
-			detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Error writing to file %s", filename);
+			detexSetWriteErrorMessage(func_name, filename);
 			return false;
 		}
 	}
@@ -291,10 +391,10 @@ bool detexSaveKTXFileWithMipmaps(detexTexture **textures, int nu_levels, const c
 		if (detexFormatIsCompressed(textures[i]->format) || (pixel_size & 3) == 0) {
 			// Regular 32-bit aligned texture.
 			data[0] = n * block_size;	// Image size.
-			size_t r1 = fwrite(data, 1, 4, f);
-			size_t r2 = fwrite(textures[i]->data, 1, n * block_size, f);
+			size_t r1 = write_func(user_data, data, 4);
+			size_t r2 = write_func(user_data, textures[i]->data, n * block_size);
 			if (r1 != 4 || r2 != n * block_size) {
-				detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Error writing to file %s", filename);
+				detexSetWriteErrorMessage(func_name, filename);
 				return false;
 			}
 		}
@@ -302,9 +402,9 @@ bool detexSaveKTXFileWithMipmaps(detexTexture **textures, int nu_levels, const c
 			// Uncompressed texture with pixel size that is not a multiple of four.
 			int row_size = (textures[i]->width * pixel_size  + 3) & (~3);
 			data[0] = textures[i]->height * row_size;	// Image size.
-			size_t r1 = fwrite(data, 1, 4, f);
+			size_t r1 = write_func(user_data, data, 4);
 			if (r1 != 4) {
-				detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Error writing to file %s", filename);
+				detexSetWriteErrorMessage(func_name, filename);
 				return false;
 			}
 			uint8_t *row = (uint8_t *)malloc(row_size);
@@ -313,19 +413,55 @@ bool detexSaveKTXFileWithMipmaps(detexTexture **textures, int nu_levels, const c
 					textures[i]->width * pixel_size);
 				for (int j = textures[i]->width * pixel_size; j < row_size; j++)
 					row[j] = 0;
-				size_t r2 = fwrite(row, 1, row_size, f);
+				size_t r2 = write_func(user_data, row, row_size);
 				if (r2 != row_size) {
-					detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Error writing to file %s", 							filename);
+					free(row);
+					detexSetWriteErrorMessage(func_name, filename);
 					return false;
 				}
 			}
 			free(row);
 		}
 	}
+	return true;
+}
+
+// Save textures to KTX file (multiple mip-maps levels). Return true if succesful.
+bool detexSaveKTXFileWithMipmaps(detexTexture **textures, int nu_levels, const char *filename) {
+	FILE *f = fopen(filename, "wb");
+	if (f == NULL) {
+		detexSetErrorMessage("detexSaveKTXFileWithMipmaps: Could not open file %s for writing", filename);
+		return false;
+	}
+	bool r = SaveKTXWithMipmaps(textures, nu_levels, detexWriteFile, f, "detexSaveKTXFileWithMipmaps",
+		filename);
 	fclose(f);
+	return r;
+}
+
+// Save textures in KTX format (multiple mip-maps levels) to memory. Return true if succesful.
+// data_out is a return parameter for the allocated file data, free with free(); size_out
+// returns its size in bytes.
+bool detexSaveKTXMemoryWithMipmaps(detexTexture **textures, int nu_levels, uint8_t **data_out,
+size_t *size_out) {
+	detexOutputBuffer output = { NULL, 0, 0 };
+	if (!SaveKTXWithMipmaps(textures, nu_levels, detexWriteOutputBuffer, &output,
+	"detexSaveKTXMemoryWithMipmaps", NULL)) {
+		free(output.data);
+		return false;
+	}
+	*data_out = output.data;
+	*size_out = output.size;
 	return true;
 }
 
+// Save textures in KTX format (multiple mip-maps levels) to a stream. Return true if succesful.
+bool detexSaveKTXStreamWithMipmaps(detexTexture **textures, int nu_levels, detexWriteFunc write_func,
+void *user_data) {
+	return SaveKTXWithMipmaps(textures, nu_levels, write_func, user_data, "detexSaveKTXStreamWithMipmaps",
+		NULL);
+}
+
 // Save texture to KTX file (single mip-map level). Returns true if succesful.
 bool detexSaveKTXFile(detexTexture *texture, const char *filename) {
 	detexTexture *textures[1];
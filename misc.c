@@ -92,6 +92,13 @@ const char *detexGetErrorMessage() {
 	return detex_error_message;
 }
 
+// Free the error message of the calling thread. Used by worker threads before they exit,
+// since the thread-local message would otherwise be leaked.
+void detexFreeErrorMessage() {
+	free(detex_error_message);
+	detex_error_message = NULL;
+}
+
 // General texture file loading.
 
 // Load texture file (type autodetected from extension) with mipmaps.
@@ -108,6 +115,36 @@ int *nu_levels_out) {
 	}
 }
 
+// Load texture from KTX or DDS file data in memory (type autodetected from the file
+// signature) with mipmaps.
+bool detexLoadTextureMemoryWithMipmaps(const uint8_t *data, size_t size, int max_mipmaps,
+detexTexture ***textures_out, int *nu_levels_out) {
+	if (size >= 4 && data[0] == 0xAB && data[1] == 'K' && data[2] == 'T' && data[3] == 'X')
+		return detexLoadKTXMemoryWithMipmaps(data, size, max_mipmaps, textures_out, nu_levels_out);
+	else if (size >= 4 && memcmp(data, "DDS ", 4) == 0)
+		return detexLoadDDSMemoryWithMipmaps(data, size, max_mipmaps, textures_out, nu_levels_out);
+	else {
+		detexSetErrorMessage("detexLoadTextureMemoryWithMipmaps: Do not recognize file signature");
+		return false;
+	}
+}
+
+// Map texture file (type autodetected from extension) into memory with mipmaps.
+bool detexMapTextureFileWithMipmaps(const char *filename, int max_mipmaps, detexTexture ***textures_out,
+int *nu_levels_out, detexMappedTextureFile **file_out) {
+	int filename_length = strlen(filename);
+	if (filename_length > 4 && strncasecmp(filename + filename_length - 4, ".ktx", 4) == 0)
+		return detexMapKTXFileWithMipmaps(filename, max_mipmaps, textures_out, nu_levels_out,
+			file_out);
+	else if (filename_length > 4 && strncasecmp(filename + filename_length - 4, ".dds", 4) == 0)
+		return detexMapDDSFileWithMipmaps(filename, max_mipmaps, textures_out, nu_levels_out,
+			file_out);
+	else {
+		detexSetErrorMessage("detexMapTextureFileWithMipmaps: Do not recognize filename extension");
+		return false;
+	}
+}
+
 // Load texture file (type autodetected from extension).
 bool detexLoadTextureFile(const char *filename, detexTexture **texture_out) {
 	int nu_mipmaps;
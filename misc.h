@@ -19,3 +19,5 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 void detexSetErrorMessage(const char *format, ...);
 
+void detexFreeErrorMessage();
+
@@ -25,10 +25,17 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 #include "detex.h"
 #include "detex-png.h"
+#include "stream.h"
 
-// Load texture from PNG file (first mip-map only). Returns true if successful.
-// The texture is allocated, free with free().
-bool detexLoadPNGFile(const char *filename, detexTexture **texture_out) {
+// libpng read callback that reads from a detex input source.
+static void ReadPNGData(png_structp png_ptr, png_bytep data, png_size_t length) {
+	detexInputSource *source = (detexInputSource *)png_get_io_ptr(png_ptr);
+	if (!detexReadInputSource(source, data, length))
+		png_error(png_ptr, "Read error");
+}
+
+// Load texture from PNG input source. filename is NULL when not loading from a file.
+static bool LoadPNG(detexInputSource *source, const char *filename, detexTexture **texture_out) {
 	int png_width, png_height;
 	png_byte color_type;
 	png_byte bit_depth;
@@ -39,19 +46,19 @@ bool detexLoadPNGFile(const char *filename, detexTexture **texture_out) {
 
 	png_byte header[8];    // 8 is the maximum size that can be checked
 
-        FILE *fp = fopen(filename, "rb");
-	if (!fp) {
-		printf("Error - file %s could not be opened for reading.\n", filename);
-		return false;
-	}
 	// Read header.
-	size_t r = fread(header, 1, 8, fp);
-	if (r != 8) {
-		printf("Error reading file %s\n", filename);
+	if (!detexReadInputSource(source, header, 8)) {
+		if (filename != NULL)
+			printf("Error reading file %s\n", filename);
+		else
+			printf("Error reading PNG data\n");
 		return false;
 	}
 	if (png_sig_cmp(header, 0, 8)) {
-		printf("Error - file %s is not recognized as a PNG file.\n", filename);
+		if (filename != NULL)
+			printf("Error - file %s is not recognized as a PNG file.\n", filename);
+		else
+			printf("Error - data is not recognized as a PNG file.\n");
 		return false;
 	}
 
@@ -64,16 +71,18 @@ bool detexLoadPNGFile(const char *filename, detexTexture **texture_out) {
 
 	info_ptr = png_create_info_struct(png_ptr);
 	if (!info_ptr) {
+		png_destroy_read_struct(&png_ptr, NULL, NULL);
 		printf("png_create_info_struct failed\n");
 		return false;
 	}
 
 	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 		printf("Error during PNG I/O initialization.");
 		return false;
 	}
 
-	png_init_io(png_ptr, fp);
+	png_set_read_fn(png_ptr, source, ReadPNGData);
 	png_set_sig_bytes(png_ptr, 8);
 
 	png_read_info(png_ptr, info_ptr);
@@ -83,28 +92,34 @@ bool detexLoadPNGFile(const char *filename, detexTexture **texture_out) {
 	color_type = png_get_color_type(png_ptr, info_ptr);
 	bit_depth = png_get_bit_depth(png_ptr, info_ptr);
 	if (bit_depth != 8 && bit_depth != 16) {
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 		printf("Error - unexpected bit depth in PNG file\n");
 		return false;
 	}
 
 	number_of_passes = png_set_interlace_handling(png_ptr);
 	if (number_of_passes > 1) {
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 		printf("Error - interlaced PNG files not supported\n");
 		return false;
 	}
 	png_read_update_info(png_ptr, info_ptr);
 
-        /* Read pixel data. */
-	if (setjmp(png_jmpbuf(png_ptr))) {
-		printf("Error during png_read_image.\n");
-		return false;
-        }
+	// Read pixel data.
 	row_pointers = (png_bytep *)malloc(sizeof(png_bytep) * png_height);
 	int row_bytes = png_get_rowbytes(png_ptr, info_ptr);
 	for (int y = 0; y < png_height; y++)
 		row_pointers[y] = (png_byte *)malloc(row_bytes);
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		for (int y = 0; y < png_height; y++)
+			free(row_pointers[y]);
+		free(row_pointers);
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+		printf("Error during png_read_image.\n");
+		return false;
+	}
 	png_read_image(png_ptr, row_pointers);
-	fclose(fp);
+	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
 	uint32_t format;
 	if (color_type == PNG_COLOR_TYPE_GRAY)
@@ -123,6 +138,9 @@ bool detexLoadPNGFile(const char *filename, detexTexture **texture_out) {
 		else
 			format = DETEX_PIXEL_FORMAT_RGBA16;
 	else {
+		for (int y = 0; y < png_height; y++)
+			free(row_pointers[y]);
+		free(row_pointers);
 		printf("Error - unexpected bit color type in PNG file\n");
 		return false;
 	}
@@ -144,8 +162,57 @@ bool detexLoadPNGFile(const char *filename, detexTexture **texture_out) {
 	return true;
 }
 
-// Save texture to PNG file (single mip-map level). Returns true if succesful.
-bool detexSavePNGFile(detexTexture *texture, const char *filename) {
+// Load texture from PNG file (first mip-map only). Returns true if successful.
+// The texture is allocated, free with free().
+bool detexLoadPNGFile(const char *filename, detexTexture **texture_out) {
+	FILE *fp = fopen(filename, "rb");
+	if (!fp) {
+		printf("Error - file %s could not be opened for reading.\n", filename);
+		return false;
+	}
+	detexInputSource source;
+	detexInitFileInputSource(&source, fp);
+	bool r = LoadPNG(&source, filename, texture_out);
+	fclose(fp);
+	return r;
+}
+
+// Load texture from PNG file data in memory. Returns true if successful.
+// The texture is allocated, free with free().
+bool detexLoadPNGMemory(const uint8_t *data, size_t size, detexTexture **texture_out) {
+	detexInputSource source;
+	detexInitMemoryInputSource(&source, data, size);
+	return LoadPNG(&source, NULL, texture_out);
+}
+
+// Load texture from PNG file data read from a stream. Returns true if successful.
+// The texture is allocated, free with free().
+bool detexLoadPNGStream(detexReadFunc read_func, void *user_data, detexTexture **texture_out) {
+	detexInputSource source;
+	detexInitStreamInputSource(&source, read_func, user_data);
+	return LoadPNG(&source, NULL, texture_out);
+}
+
+// Destination of the libpng write callback.
+typedef struct {
+	detexWriteFunc write_func;
+	void *user_data;
+} PNGWriteDestination;
+
+// libpng write callback that writes to a detex write function.
+static void WritePNGData(png_structp png_ptr, png_bytep data, png_size_t length) {
+	PNGWriteDestination *destination = (PNGWriteDestination *)png_get_io_ptr(png_ptr);
+	if (destination->write_func(destination->user_data, data, length) != length)
+		png_error(png_ptr, "Write error");
+}
+
+static void FlushPNGData(png_structp png_ptr) {
+}
+
+// Save texture in PNG format using a write callback. filename is NULL when not saving to a
+// file.
+static bool SavePNG(detexTexture *texture, detexWriteFunc write_func, void *user_data,
+const char *filename) {
 	int color_type;
 	int bit_depth = 0;
         if (detexGetNumberOfComponents(texture->format) == 1) {
@@ -179,14 +246,8 @@ bool detexSavePNGFile(detexTexture *texture, const char *filename) {
 		printf("detexSavePNGFile: Cannot handle texture format\n");
 		return false;
 	}
-	FILE *fp;
 	png_structp png_ptr;
 	png_infop info_ptr;
-	fp = fopen(filename, "wb");
-	if (fp == NULL) {
-		printf("Error - file %s could not be opened for writing\n", filename);
-		return false;
-	}
 	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	if (png_ptr == NULL) {
 		printf("Error using libpng\n");
@@ -194,15 +255,23 @@ bool detexSavePNGFile(detexTexture *texture, const char *filename) {
 	}
 	info_ptr = png_create_info_struct(png_ptr);
 	if (info_ptr == NULL) {
+		png_destroy_write_struct(&png_ptr, NULL);
 		printf("Error using libpng\n");
 		return false;
 	}
+	PNGWriteDestination destination;
+	destination.write_func = write_func;
+	destination.user_data = user_data;
 	if (setjmp(png_jmpbuf(png_ptr))) {
 		/* If we get here, we had a problem writing the file. */
-		printf("Error writing png file %s\n", filename);
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		if (filename != NULL)
+			printf("Error writing png file %s\n", filename);
+		else
+			printf("Error writing png data\n");
 		return false;
 	}
-	png_init_io(png_ptr, fp);
+	png_set_write_fn(png_ptr, &destination, WritePNGData, FlushPNGData);
 	png_set_IHDR(png_ptr, info_ptr, texture->width, texture->height, bit_depth, color_type,
 		PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
 	png_write_info(png_ptr, info_ptr);
@@ -213,8 +282,38 @@ bool detexSavePNGFile(detexTexture *texture, const char *filename) {
 		row_pointers[y] = (png_byte *)(texture->data + y * row_size);
 	png_write_image(png_ptr, row_pointers);
 	png_write_end(png_ptr, info_ptr);
-	png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	return true;
+}
+
+// Save texture to PNG file (single mip-map level). Returns true if succesful.
+bool detexSavePNGFile(detexTexture *texture, const char *filename) {
+	FILE *fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		printf("Error - file %s could not be opened for writing\n", filename);
+		return false;
+	}
+	bool r = SavePNG(texture, detexWriteFile, fp, filename);
 	fclose(fp);
+	return r;
+}
+
+// Save texture in PNG format (single mip-map level) to memory. Returns true if succesful.
+// data_out is a return parameter for the allocated file data, free with free(); size_out
+// returns its size in bytes.
+bool detexSavePNGMemory(detexTexture *texture, uint8_t **data_out, size_t *size_out) {
+	detexOutputBuffer output = { NULL, 0, 0 };
+	if (!SavePNG(texture, detexWriteOutputBuffer, &output, NULL)) {
+		free(output.data);
+		return false;
+	}
+	*data_out = output.data;
+	*size_out = output.size;
 	return true;
 }
 
+// Save texture in PNG format (single mip-map level) to a stream. Returns true if succesful.
+bool detexSavePNGStream(detexTexture *texture, detexWriteFunc write_func, void *user_data) {
+	return SavePNG(texture, write_func, user_data, NULL);
+}
+
@@ -0,0 +1,96 @@
+/*
+
+Copyright (c) 2015 Harm Hanemaaijer <fgenfb@yahoo.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include <strings.h>
+#include <pthread.h>
+
+#include "detex.h"
+#include "simd.h"
+
+static const char *simd_level_name[] = { "none", "sse2", "ssse3", "avx2" };
+
+static pthread_once_t simd_level_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t simd_level_mutex = PTHREAD_MUTEX_INITIALIZER;
+// The highest level supported by the processor, and the level in effect.
+static int cpu_simd_level;
+static int simd_level;
+
+static void SelectKernels(int level) {
+	detexSelectConversionKernels(level);
+	detexSelectHalfFloatKernels(level);
+	detexSelectHDRKernels(level);
+	detexSelectBCKernels(level);
+	detexSelectETCKernels(level);
+	detexSelectEACKernels(level);
+	detexSelectRGTCKernels(level);
+}
+
+static void DetectSIMDLevel() {
+	int level = DETEX_SIMD_LEVEL_NONE;
+#ifdef DETEX_USE_SSE2
+	level = DETEX_SIMD_LEVEL_SSE2;
+#endif
+#ifdef DETEX_USE_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("ssse3")) {
+		level = DETEX_SIMD_LEVEL_SSSE3;
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+			level = DETEX_SIMD_LEVEL_AVX2;
+	}
+#endif
+	cpu_simd_level = level;
+	// The environment variable can only lower the level.
+	const char *s = getenv("DETEX_SIMD_LEVEL");
+	if (s != NULL)
+		for (int i = DETEX_SIMD_LEVEL_NONE; i < level; i++)
+			if (strcasecmp(s, simd_level_name[i]) == 0) {
+				level = i;
+				break;
+			}
+	SelectKernels(level);
+	__atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+}
+
+/* Return the highest SIMD level used. */
+int detexGetSIMDLevel() {
+	pthread_once(&simd_level_once, DetectSIMDLevel);
+	return __atomic_load_n(&simd_level, __ATOMIC_RELAXED);
+}
+
+/* Limit the SIMD level. Returns the level now in effect. */
+int detexSetSIMDLevel(int level) {
+	pthread_once(&simd_level_once, DetectSIMDLevel);
+	if (level < DETEX_SIMD_LEVEL_NONE)
+		level = DETEX_SIMD_LEVEL_NONE;
+	if (level > cpu_simd_level)
+		level = cpu_simd_level;
+	// Serialize changes, so that the selected kernels match the level stored last.
+	pthread_mutex_lock(&simd_level_mutex);
+	SelectKernels(level);
+	__atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&simd_level_mutex);
+	return level;
+}
+
+/* Return the name of a SIMD level. */
+const char *detexGetSIMDLevelName(int level) {
+	if (level < DETEX_SIMD_LEVEL_NONE || level > DETEX_SIMD_LEVEL_AVX2)
+		return "unknown";
+	return simd_level_name[level];
+}
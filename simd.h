@@ -0,0 +1,60 @@
+/*
+
+Copyright (c) 2015 Harm Hanemaaijer <fgenfb@yahoo.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+
+// Definitions for the optional SIMD code paths. SSE2 is always available on
+// x86-64; SSSE3 and AVX2 functions are compiled using a function target attribute, so
+// that the library still runs on older processors. The SIMD kernels are called through
+// function pointers, which are selected for the SIMD level when it is detected at first
+// use and again when it is changed with detexSetSIMDLevel() (see detexGetSIMDLevel()).
+
+#if defined(__SSE2__)
+#define DETEX_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(DETEX_USE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DETEX_USE_AVX2
+#include <immintrin.h>
+#define DETEX_TARGET_AVX2 __attribute__((target("avx2")))
+#define DETEX_TARGET_F16C __attribute__((target("avx,f16c")))
+#define DETEX_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+// The kernel pointers are accessed atomically, since the level can be changed while other
+// threads are converting.
+#define DETEX_GET_KERNEL(kernel) __atomic_load_n(&(kernel), __ATOMIC_RELAXED)
+#define DETEX_SET_KERNEL(kernel, func) __atomic_store_n(&(kernel), (func), __ATOMIC_RELAXED)
+
+// Define a kernel pointer. Until the kernels are selected, it points to a function that
+// detects the SIMD level (which selects the kernels) and then calls the selected kernel.
+#define DETEX_DEFINE_KERNEL(kernel, return_type, params, args) \
+	static return_type kernel##_resolve params; \
+	static return_type (*kernel) params = kernel##_resolve; \
+	static return_type kernel##_resolve params { \
+		detexGetSIMDLevel(); \
+		return DETEX_GET_KERNEL(kernel) args; \
+	}
+
+// Select the kernels of each module for a SIMD level. Called from simd.c.
+void detexSelectConversionKernels(int level);
+void detexSelectHalfFloatKernels(int level);
+void detexSelectHDRKernels(int level);
+void detexSelectBCKernels(int level);
+void detexSelectETCKernels(int level);
+void detexSelectEACKernels(int level);
+void detexSelectRGTCKernels(int level);
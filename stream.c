@@ -0,0 +1,210 @@
+/*
+
+Copyright (c) 2015 Harm Hanemaaijer <fgenfb@yahoo.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "detex.h"
+#include "misc.h"
+#include "stream.h"
+
+static size_t ReadFile(void *user_data, void *buffer, size_t n) {
+	return fread(buffer, 1, n, (FILE *)user_data);
+}
+
+void detexInitFileInputSource(detexInputSource *source, FILE *f) {
+	detexInitStreamInputSource(source, ReadFile, f);
+}
+
+void detexInitStreamInputSource(detexInputSource *source, detexReadFunc read_func, void *user_data) {
+	source->read_func = read_func;
+	source->user_data = user_data;
+	source->data = NULL;
+	source->size = 0;
+	source->offset = 0;
+}
+
+void detexInitMemoryInputSource(detexInputSource *source, const uint8_t *data, size_t size) {
+	source->read_func = NULL;
+	source->user_data = NULL;
+	source->data = data;
+	source->size = size;
+	source->offset = 0;
+}
+
+bool detexReadInputSource(detexInputSource *source, void *buffer, size_t n) {
+	if (source->read_func != NULL)
+		return source->read_func(source->user_data, buffer, n) == n;
+	if (n > source->size - source->offset)
+		return false;
+	memcpy(buffer, source->data + source->offset, n);
+	source->offset += n;
+	return true;
+}
+
+bool detexSkipInputSource(detexInputSource *source, size_t n) {
+	if (source->read_func != NULL) {
+		// Read and discard, so that non-seekable streams are handled.
+		uint8_t buffer[256];
+		while (n > 0) {
+			size_t chunk = n < sizeof(buffer) ? n : sizeof(buffer);
+			if (source->read_func(source->user_data, buffer, chunk) != chunk)
+				return false;
+			n -= chunk;
+		}
+		return true;
+	}
+	if (n > source->size - source->offset)
+		return false;
+	source->offset += n;
+	return true;
+}
+
+const uint8_t *detexReferenceInputSource(detexInputSource *source, size_t n) {
+	if (source->read_func != NULL || n > source->size - source->offset)
+		return NULL;
+	const uint8_t *p = source->data + source->offset;
+	source->offset += n;
+	return p;
+}
+
+uint8_t *detexReferenceTextureData(detexInputSource *source, size_t n) {
+	const uint8_t *p = detexReferenceInputSource(source, n);
+	if (p == NULL || n == 0 || ((uintptr_t)p & 7) == 0)
+		return (uint8_t *)p;
+	uint8_t *data = (uint8_t *)malloc(n);
+	if (data != NULL)
+		memcpy(data, p, n);
+	return data;
+}
+
+// Return whether texture data lies within memory of the given size, as opposed to having
+// been copied by detexReferenceTextureData().
+static bool DataIsReferenced(const uint8_t *texture_data, const void *memory, size_t size) {
+	uintptr_t start = (uintptr_t)memory;
+	return (uintptr_t)texture_data >= start && (uintptr_t)texture_data <= start + size;
+}
+
+void detexSetReadErrorMessage(const char *func_name, const char *filename) {
+	if (filename != NULL)
+		detexSetErrorMessage("%s: Error reading file %s", func_name, filename);
+	else
+		detexSetErrorMessage("%s: Error reading input data", func_name);
+}
+
+void detexSetWriteErrorMessage(const char *func_name, const char *filename) {
+	if (filename != NULL)
+		detexSetErrorMessage("%s: Error writing to file %s", func_name, filename);
+	else
+		detexSetErrorMessage("%s: Error writing output data", func_name);
+}
+
+size_t detexWriteFile(void *user_data, const void *buffer, size_t n) {
+	return fwrite(buffer, 1, n, (FILE *)user_data);
+}
+
+size_t detexWriteOutputBuffer(void *user_data, const void *buffer, size_t n) {
+	detexOutputBuffer *output = (detexOutputBuffer *)user_data;
+	if (n > output->capacity - output->size) {
+		// Grow geometrically to keep the number of reallocations small.
+		size_t capacity = output->capacity * 2;
+		if (capacity < output->size + n)
+			capacity = output->size + n;
+		if (capacity < 4096)
+			capacity = 4096;
+		uint8_t *data = (uint8_t *)realloc(output->data, capacity);
+		if (data == NULL)
+			return 0;
+		output->data = data;
+		output->capacity = capacity;
+	}
+	memcpy(output->data + output->size, buffer, n);
+	output->size += n;
+	return n;
+}
+
+void detexFreeLoadedTextures(detexTexture **textures, int nu_textures,
+const detexInputSource *reference_source) {
+	for (int i = 0; i < nu_textures; i++) {
+		if (reference_source == NULL || !DataIsReferenced(textures[i]->data,
+		reference_source->data, reference_source->size))
+			free(textures[i]->data);
+		free(textures[i]);
+	}
+	free(textures);
+}
+
+int detexGetFileBytesPerBlock(uint32_t texture_format) {
+	if (detexFormatIsCompressed(texture_format))
+		return detexGetCompressedBlockSize(texture_format);
+	return detexGetPixelSize(texture_format);
+}
+
+// Memory-mapped texture files.
+
+detexMappedTextureFile *detexMapFile(const char *filename, const char *func_name) {
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		detexSetErrorMessage("%s: Could not open file %s", func_name, filename);
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		detexSetErrorMessage("%s: Error reading file %s", func_name, filename);
+		return NULL;
+	}
+	// Use a private writable mapping, so that the texture data can be modified like
+	// that of a loaded texture without affecting the file.
+	void *mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		detexSetErrorMessage("%s: Could not map file %s", func_name, filename);
+		return NULL;
+	}
+	detexMappedTextureFile *file = (detexMappedTextureFile *)malloc(sizeof(detexMappedTextureFile));
+	if (file == NULL) {
+		munmap(mapping, st.st_size);
+		detexSetErrorMessage("%s: Out of memory", func_name);
+		return NULL;
+	}
+	file->mapping = mapping;
+	file->size = st.st_size;
+	file->textures = NULL;
+	file->nu_levels = 0;
+	return file;
+}
+
+// Release a memory-mapped texture file, freeing the textures that reference it.
+void detexReleaseMappedTextureFile(detexMappedTextureFile *file) {
+	if (file == NULL)
+		return;
+	for (int i = 0; i < file->nu_levels; i++) {
+		if (!DataIsReferenced(file->textures[i]->data, file->mapping, file->size))
+			free(file->textures[i]->data);
+		free(file->textures[i]);
+	}
+	free(file->textures);
+	munmap(file->mapping, file->size);
+	free(file);
+}
@@ -0,0 +1,99 @@
+/*
+
+Copyright (c) 2015 Harm Hanemaaijer <fgenfb@yahoo.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+
+#include <stdio.h>
+
+// Input sources for the texture file loaders. A source is either a read callback
+// (used for files and user streams) or a memory buffer (such as a memory-mapped file).
+// Data from a memory source can be referenced directly instead of being copied.
+
+typedef struct {
+	detexReadFunc read_func;
+	void *user_data;
+	const uint8_t *data;
+	size_t size;
+	size_t offset;
+} detexInputSource;
+
+// A growable memory buffer that texture files are saved into.
+typedef struct {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+} detexOutputBuffer;
+
+// A memory-mapped texture file and the textures that reference it.
+struct detexMappedTextureFile {
+	void *mapping;
+	size_t size;
+	detexTexture **textures;
+	int nu_levels;
+};
+
+void detexInitFileInputSource(detexInputSource *source, FILE *f);
+
+void detexInitStreamInputSource(detexInputSource *source, detexReadFunc read_func, void *user_data);
+
+void detexInitMemoryInputSource(detexInputSource *source, const uint8_t *data, size_t size);
+
+// Read n bytes from a source. Returns false if fewer than n bytes are available.
+bool detexReadInputSource(detexInputSource *source, void *buffer, size_t n);
+
+// Skip n bytes of a source. Returns false if fewer than n bytes are available.
+bool detexSkipInputSource(detexInputSource *source, size_t n);
+
+// Return a pointer to the next n bytes of a memory source and advance past them, or
+// NULL if the source is not a memory source or fewer than n bytes are available.
+const uint8_t *detexReferenceInputSource(detexInputSource *source, size_t n);
+
+// Reference the next n bytes of a memory source as texture data. The block decoders load
+// 64-bit words from texture data, so data that is not 8-byte aligned is copied to an
+// allocated buffer instead. Returns NULL if not successful.
+uint8_t *detexReferenceTextureData(detexInputSource *source, size_t n);
+
+// Set the error message for a failed read or write. filename is NULL when the source or
+// destination is not a file.
+void detexSetReadErrorMessage(const char *func_name, const char *filename);
+void detexSetWriteErrorMessage(const char *func_name, const char *filename);
+
+// Write callbacks for files (user_data is the FILE pointer) and output buffers
+// (user_data is the detexOutputBuffer, which must initially be zeroed).
+size_t detexWriteFile(void *user_data, const void *buffer, size_t n);
+size_t detexWriteOutputBuffer(void *user_data, const void *buffer, size_t n);
+
+// Free the textures allocated by a loader, including the texture data. When reference_source
+// is not NULL, the texture data was obtained with detexReferenceTextureData() from that
+// source, and only the copied data is freed.
+void detexFreeLoadedTextures(detexTexture **textures, int nu_textures,
+	const detexInputSource *reference_source);
+
+// Memory-map a file. Returns NULL if not successful, setting the error message.
+detexMappedTextureFile *detexMapFile(const char *filename, const char *func_name);
+
+// Return the number of bytes per block stored in a texture file for a texture format (the
+// pixel size for uncompressed formats, which have 1x1 blocks).
+int detexGetFileBytesPerBlock(uint32_t texture_format);
+
+// Read the header of a KTX or DDS file from an input source, leaving the source positioned
+// at the data of the first mipmap level. The properties of the first level are returned in
+// texture_out, with data set to NULL. Returns false if not successful, setting the error
+// message.
+bool detexReadKTXFirstLevel(detexInputSource *source, const char *func_name, const char *filename,
+	detexTexture *texture_out);
+bool detexReadDDSFirstLevel(detexInputSource *source, const char *func_name, const char *filename,
+	detexTexture *texture_out);
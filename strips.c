@@ -0,0 +1,161 @@
+/*
+
+Copyright (c) 2015 Harm Hanemaaijer <fgenfb@yahoo.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "detex.h"
+#include "misc.h"
+#include "stream.h"
+
+// Streaming decompression. The first mipmap level of a texture file is read one row of
+// compressed blocks at a time, and each row is decompressed into a strip of up to four
+// pixel rows that is passed to the caller, so that neither the compressed level nor the
+// decompressed image has to be held in memory.
+
+// Upper limit on the size of one row of compressed blocks, which corresponds to a width of
+// four million pixels for 16-byte blocks. Larger values come from corrupt headers.
+#define MAX_BLOCK_ROW_SIZE (16 * 1024 * 1024)
+
+typedef bool (*ReadFirstLevelFuncType)(detexInputSource *source, const char *func_name,
+	const char *filename, detexTexture *texture_out);
+
+static bool DecompressStrips(detexInputSource *source, ReadFirstLevelFuncType read_first_level,
+const char *func_name, const char *filename, uint32_t pixel_format, detexStripFunc strip_func,
+void *user_data) {
+	detexTexture level;
+	if (!read_first_level(source, func_name, filename, &level))
+		return false;
+	bool compressed = detexFormatIsCompressed(level.format);
+	// Number of pixel rows in a row of blocks.
+	int block_height = compressed ? 4 : 1;
+	int strip_height = 4;
+	int nu_block_rows_per_strip = strip_height / block_height;
+	size_t block_row_size = (size_t)level.width_in_blocks * detexGetFileBytesPerBlock(level.format);
+	if (block_row_size == 0 || block_row_size > MAX_BLOCK_ROW_SIZE) {
+		detexSetErrorMessage("%s: Invalid row size of %zu bytes", func_name, block_row_size);
+		return false;
+	}
+	uint8_t *data = (uint8_t *)malloc(block_row_size * nu_block_rows_per_strip);
+	uint8_t *strip = (uint8_t *)malloc((size_t)level.width * strip_height *
+		detexGetPixelSize(pixel_format));
+	if (data == NULL || strip == NULL) {
+		free(strip);
+		free(data);
+		detexSetErrorMessage("%s: Out of memory", func_name);
+		return false;
+	}
+	// The strip is decompressed as a texture consisting of its rows of blocks.
+	detexTexture strip_texture = level;
+	strip_texture.data = data;
+	bool result = true;
+	for (int y = 0; y < level.height; y += strip_height) {
+		int nu_rows = level.height - y < strip_height ? level.height - y : strip_height;
+		strip_texture.height = nu_rows;
+		strip_texture.height_in_blocks = (nu_rows + block_height - 1) / block_height;
+		if (!detexReadInputSource(source, data, block_row_size * strip_texture.height_in_blocks)) {
+			detexSetReadErrorMessage(func_name, filename);
+			result = false;
+			break;
+		}
+		if (!detexDecompressTextureLinear(&strip_texture, strip, pixel_format)) {
+			if (!compressed) {
+				// Conversion failures apply to every strip.
+				result = false;
+				break;
+			}
+			detexSetErrorMessage("%s: Decompression failed for block row %d", func_name,
+				y / block_height);
+			result = false;
+		}
+		if (!strip_func(user_data, &level, y, nu_rows, strip)) {
+			detexSetErrorMessage("%s: Decompression aborted by strip function", func_name);
+			result = false;
+			break;
+		}
+	}
+	free(strip);
+	free(data);
+	return result;
+}
+
+static bool DecompressFileStrips(const char *filename, ReadFirstLevelFuncType read_first_level,
+const char *func_name, uint32_t pixel_format, detexStripFunc strip_func, void *user_data) {
+	FILE *f = fopen(filename, "rb");
+	if (f == NULL) {
+		detexSetErrorMessage("%s: Could not open file %s", func_name, filename);
+		return false;
+	}
+	detexInputSource source;
+	detexInitFileInputSource(&source, f);
+	bool r = DecompressStrips(&source, read_first_level, func_name, filename, pixel_format,
+		strip_func, user_data);
+	fclose(f);
+	return r;
+}
+
+// Decompress the first mipmap level of a KTX file in strips. Returns true if successful.
+bool detexDecompressKTXFileStrips(const char *filename, uint32_t pixel_format,
+detexStripFunc strip_func, void *user_data) {
+	return DecompressFileStrips(filename, detexReadKTXFirstLevel, "detexDecompressKTXFileStrips",
+		pixel_format, strip_func, user_data);
+}
+
+// Decompress the first mipmap level of a DDS file in strips. Returns true if successful.
+bool detexDecompressDDSFileStrips(const char *filename, uint32_t pixel_format,
+detexStripFunc strip_func, void *user_data) {
+	return DecompressFileStrips(filename, detexReadDDSFirstLevel, "detexDecompressDDSFileStrips",
+		pixel_format, strip_func, user_data);
+}
+
+// Decompress the first mipmap level of a texture file (type autodetected from extension) in
+// strips. Returns true if successful.
+bool detexDecompressTextureFileStrips(const char *filename, uint32_t pixel_format,
+detexStripFunc strip_func, void *user_data) {
+	int filename_length = strlen(filename);
+	if (filename_length > 4 && strncasecmp(filename + filename_length - 4, ".ktx", 4) == 0)
+		return detexDecompressKTXFileStrips(filename, pixel_format, strip_func, user_data);
+	else if (filename_length > 4 && strncasecmp(filename + filename_length - 4, ".dds", 4) == 0)
+		return detexDecompressDDSFileStrips(filename, pixel_format, strip_func, user_data);
+	else {
+		detexSetErrorMessage("detexDecompressTextureFileStrips: Do not recognize filename extension");
+		return false;
+	}
+}
+
+// Decompress the first mipmap level of KTX file data read from a stream in strips. Returns
+// true if successful.
+bool detexDecompressKTXStreamStrips(detexReadFunc read_func, void *read_user_data,
+uint32_t pixel_format, detexStripFunc strip_func, void *user_data) {
+	detexInputSource source;
+	detexInitStreamInputSource(&source, read_func, read_user_data);
+	return DecompressStrips(&source, detexReadKTXFirstLevel, "detexDecompressKTXStreamStrips", NULL,
+		pixel_format, strip_func, user_data);
+}
+
+// Decompress the first mipmap level of DDS file data read from a stream in strips. Returns
+// true if successful.
+bool detexDecompressDDSStreamStrips(detexReadFunc read_func, void *read_user_data,
+uint32_t pixel_format, detexStripFunc strip_func, void *user_data) {
+	detexInputSource source;
+	detexInitStreamInputSource(&source, read_func, read_user_data);
+	return DecompressStrips(&source, detexReadDDSFirstLevel, "detexDecompressDDSStreamStrips", NULL,
+		pixel_format, strip_func, user_data);
+}
@@ -16,9 +16,13 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 */
 
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "detex.h"
+#include "hdr.h"
 #include "misc.h"
 
 typedef bool (*detexDecompressBlockFuncType)(const uint8_t *bitstring,
@@ -47,6 +51,42 @@ static detexDecompressBlockFuncType decompress_function[] = {
 	detexDecompressBlockEAC_SIGNED_RG11,
 };
 
+typedef bool (*detexDecompressBlocksFuncType)(const uint8_t *bitstring, int nu_blocks,
+	uint32_t mode_mask, uint32_t flags, uint8_t *pixel_buffer);
+
+// Batch decompression functions for consecutive blocks.
+static detexDecompressBlocksFuncType decompress_blocks_function[] = {
+	NULL,
+	detexDecompressBlocksBC1,
+	detexDecompressBlocksBC1A,
+	detexDecompressBlocksBC2,
+	detexDecompressBlocksBC3,
+	detexDecompressBlocksRGTC1,
+	detexDecompressBlocksSIGNED_RGTC1,
+	detexDecompressBlocksRGTC2,
+	detexDecompressBlocksSIGNED_RGTC2,
+	detexDecompressBlocksBPTC_FLOAT,
+	detexDecompressBlocksBPTC_SIGNED_FLOAT,
+	NULL,
+	detexDecompressBlocksETC1,
+	detexDecompressBlocksETC2,
+	detexDecompressBlocksETC2_PUNCHTHROUGH,
+	detexDecompressBlocksETC2_EAC,
+	detexDecompressBlocksEAC_R11,
+	detexDecompressBlocksEAC_SIGNED_R11,
+	detexDecompressBlocksEAC_RG11,
+	detexDecompressBlocksEAC_SIGNED_RG11,
+};
+
+// Convert decompressed pixels to the target pixel format. Multi-step conversions between
+// common formats are performed in a single pass by detexConvertPixels.
+static DETEX_INLINE_ONLY bool ConvertDecompressedPixels(uint8_t * DETEX_RESTRICT source_pixel_buffer,
+int nu_pixels, uint32_t source_pixel_format, uint8_t * DETEX_RESTRICT target_pixel_buffer,
+uint32_t target_pixel_format) {
+	return detexConvertPixels(source_pixel_buffer, nu_pixels, source_pixel_format,
+		target_pixel_buffer, target_pixel_format);
+}
+
 /*
  * General block decompression function. Block is decompressed using the given
  * compressed format, and stored in the given pixel format. Returns true if
@@ -65,10 +105,220 @@ uint32_t pixel_format) {
 		return false;
 	}
 	/* Convert into desired pixel format. */
-	return detexConvertPixels(block_buffer, 16,
+	return ConvertDecompressedPixels(block_buffer, 16,
 		detexGetPixelFormat(texture_format), pixel_buffer, pixel_format); 
 }
 
+// The texture decompression functions decompress runs of up to BLOCKS_PER_BATCH blocks
+// in the pixel format of the compressed texture, and then convert the whole run at once.
+
+#define BLOCKS_PER_BATCH 16
+
+// Decompress nu_blocks consecutive blocks into pixel_buffer in the pixel format of the
+// texture. Failed blocks are recorded in block_failed. Returns false if any block failed.
+static bool DecompressBlockRun(const uint8_t * DETEX_RESTRICT data, uint32_t texture_format,
+int nu_blocks, uint8_t * DETEX_RESTRICT pixel_buffer, bool *block_failed) {
+	uint32_t compressed_format = detexGetCompressedFormat(texture_format);
+	uint32_t compressed_block_size = detexGetCompressedBlockSize(texture_format);
+	uint32_t block_size = detexGetPixelSize(texture_format) * 16;
+	detexDecompressBlocksFuncType decompress_blocks = decompress_blocks_function[compressed_format];
+	if (decompress_blocks != NULL && decompress_blocks(data, nu_blocks, DETEX_MODE_MASK_ALL, 0,
+	pixel_buffer)) {
+		for (int i = 0; i < nu_blocks; i++)
+			block_failed[i] = false;
+		return true;
+	}
+	// Decompress the blocks one at a time, which also determines which blocks failed
+	// when the batch function was not succesful.
+	bool result = true;
+	for (int i = 0; i < nu_blocks; i++) {
+		block_failed[i] = !decompress_function[compressed_format](data + i * compressed_block_size,
+			DETEX_MODE_MASK_ALL, 0, pixel_buffer + i * block_size);
+		if (block_failed[i]) {
+			result = false;
+			detexSetErrorMessage("detexDecompressBlock: Decompress function for format "
+				"0x%08X returned error", texture_format);
+		}
+	}
+	return result;
+}
+
+// Decompress and convert nu_blocks consecutive blocks into pixel_buffer in the given pixel
+// format, with the blocks stored consecutively. Failed blocks are cleared to zero. Returns
+// false if any block failed.
+static bool DecompressAndConvertBlockRun(const uint8_t * DETEX_RESTRICT data, uint32_t texture_format,
+int nu_blocks, uint8_t * DETEX_RESTRICT pixel_buffer, uint32_t pixel_format) {
+	uint8_t run_buffer[BLOCKS_PER_BATCH * DETEX_MAX_BLOCK_SIZE];
+	bool block_failed[BLOCKS_PER_BATCH];
+	uint32_t source_pixel_format = detexGetPixelFormat(texture_format);
+	uint32_t block_size = detexGetPixelSize(pixel_format) * 16;
+	bool result;
+	if (source_pixel_format == pixel_format)
+		// Decompress straight into the target buffer.
+		result = DecompressBlockRun(data, texture_format, nu_blocks, pixel_buffer, block_failed);
+	else {
+		result = DecompressBlockRun(data, texture_format, nu_blocks, run_buffer, block_failed);
+		if (!ConvertDecompressedPixels(run_buffer, nu_blocks * 16, source_pixel_format,
+		pixel_buffer, pixel_format)) {
+			memset(pixel_buffer, 0, nu_blocks * block_size);
+			return false;
+		}
+	}
+	if (!result)
+		for (int i = 0; i < nu_blocks; i++)
+			if (block_failed[i])
+				memset(pixel_buffer + i * block_size, 0, block_size);
+	return result;
+}
+
+// Decompress nu_blocks consecutive blocks in tiled order in runs of up to BLOCKS_PER_BATCH
+// blocks.
+static bool DecompressTiledBlocks(const uint8_t * DETEX_RESTRICT data, uint32_t texture_format,
+int nu_blocks_left, uint8_t * DETEX_RESTRICT pixel_buffer, uint32_t pixel_format) {
+	uint32_t compressed_block_size = detexGetCompressedBlockSize(texture_format);
+	uint32_t block_size = detexGetPixelSize(pixel_format) * 16;
+	bool result = true;
+	while (nu_blocks_left > 0) {
+		int nu_blocks = nu_blocks_left;
+		if (nu_blocks > BLOCKS_PER_BATCH)
+			nu_blocks = BLOCKS_PER_BATCH;
+		if (!DecompressAndConvertBlockRun(data, texture_format, nu_blocks, pixel_buffer,
+		pixel_format))
+			result = false;
+		data += nu_blocks * compressed_block_size;
+		pixel_buffer += nu_blocks * block_size;
+		nu_blocks_left -= nu_blocks;
+	}
+	return result;
+}
+
+// Decompress the block rows [y_start, y_end) of a texture in tiled order. pixel_buffer
+// points to the start of the whole tiled output buffer, in which consecutive block rows are
+// row_stride bytes apart. Returns false if any block failed to decompress; failed blocks are
+// cleared to zero.
+static bool DecompressTiledBlockRows(const detexTexture *texture, uint8_t * DETEX_RESTRICT pixel_buffer,
+size_t row_stride, uint32_t pixel_format, int y_start, int y_end) {
+	uint32_t compressed_block_size = detexGetCompressedBlockSize(texture->format);
+	size_t compressed_row_size = (size_t)texture->width_in_blocks * compressed_block_size;
+	size_t row_size = (size_t)texture->width_in_blocks * detexGetPixelSize(pixel_format) * 16;
+	const uint8_t *data = texture->data + (size_t)y_start * compressed_row_size;
+	pixel_buffer += (size_t)y_start * row_stride;
+	if (row_stride == row_size)
+		// Block rows are contiguous, so runs can cross row boundaries.
+		return DecompressTiledBlocks(data, texture->format, (y_end - y_start) *
+			texture->width_in_blocks, pixel_buffer, pixel_format);
+	bool result = true;
+	for (int y = y_start; y < y_end; y++) {
+		if (!DecompressTiledBlocks(data, texture->format, texture->width_in_blocks, pixel_buffer,
+		pixel_format))
+			result = false;
+		data += compressed_row_size;
+		pixel_buffer += row_stride;
+	}
+	return result;
+}
+
+// Decompress the pixel rectangle (x, y, width, height) of a compressed texture into a linear
+// image. pixel_buffer points to the output location of pixel (x, y), and consecutive pixel rows
+// are row_stride bytes apart. Only the blocks overlapping the rectangle are decompressed.
+// Returns false if any block failed to decompress; the pixels of failed blocks are cleared to zero.
+static bool DecompressLinearRegion(const detexTexture *texture, int x, int y, int width, int height,
+uint8_t * DETEX_RESTRICT pixel_buffer, size_t row_stride, uint32_t pixel_format) {
+	uint8_t run_buffer[BLOCKS_PER_BATCH * DETEX_MAX_BLOCK_SIZE];
+	uint32_t compressed_block_size = detexGetCompressedBlockSize(texture->format);
+	int pixel_size = detexGetPixelSize(pixel_format);
+	uint32_t block_size = pixel_size * 16;
+	int x_end = x + width;
+	int y_end = y + height;
+	int bx_start = x / 4;
+	int bx_end = (x_end + 3) / 4;
+	bool result = true;
+	for (int by = y / 4; by < (y_end + 3) / 4; by++) {
+		// Range of pixel rows within the block row that lie inside the rectangle.
+		int row_start = y > by * 4 ? y - by * 4 : 0;
+		int row_end = y_end < by * 4 + 4 ? y_end - by * 4 : 4;
+		const uint8_t *data = texture->data + ((size_t)by * texture->width_in_blocks + bx_start) *
+			compressed_block_size;
+		for (int bx = bx_start; bx < bx_end; bx += BLOCKS_PER_BATCH) {
+			int nu_blocks = bx_end - bx;
+			if (nu_blocks > BLOCKS_PER_BATCH)
+				nu_blocks = BLOCKS_PER_BATCH;
+			if (!DecompressAndConvertBlockRun(data, texture->format, nu_blocks, run_buffer,
+			pixel_format))
+				result = false;
+			for (int i = 0; i < nu_blocks; i++) {
+				int block_x = (bx + i) * 4;
+				// Range of pixel columns within the block that lie inside the rectangle.
+				int column_start = x > block_x ? x - block_x : 0;
+				int column_end = x_end < block_x + 4 ? x_end - block_x : 4;
+				uint8_t *pixelp = pixel_buffer + (size_t)(by * 4 + row_start - y) * row_stride +
+					(size_t)(block_x + column_start - x) * pixel_size;
+				const uint8_t *blockp = run_buffer + i * block_size + column_start * pixel_size;
+				for (int row = row_start; row < row_end; row++) {
+					memcpy(pixelp, blockp + row * 4 * pixel_size,
+						(column_end - column_start) * pixel_size);
+					pixelp += row_stride;
+				}
+			}
+			data += nu_blocks * compressed_block_size;
+		}
+	}
+	return result;
+}
+
+// Decompress the block rows [y_start, y_end) of a texture into a linear image. pixel_buffer
+// points to the start of the whole image, in which consecutive pixel rows are row_stride
+// bytes apart. Returns false if any block failed to decompress; failed blocks are cleared
+// to zero.
+static bool DecompressLinearBlockRows(const detexTexture *texture, uint8_t * DETEX_RESTRICT pixel_buffer,
+size_t row_stride, uint32_t pixel_format, int y_start, int y_end) {
+	int y = y_start * 4;
+	int height = (y_end * 4 < texture->height ? y_end * 4 : texture->height) - y;
+	return DecompressLinearRegion(texture, 0, y, texture->width, height,
+		pixel_buffer + (size_t)y * row_stride, row_stride, pixel_format);
+}
+
+// Check the row stride argument of a decompression function and substitute the packed
+// row size when it is zero. Returns false if the row stride is too small.
+static bool GetRowStride(const char *func_name, int row_stride, size_t row_size,
+size_t *row_stride_out) {
+	if (row_stride == 0)
+		*row_stride_out = row_size;
+	else if (row_stride < 0 || (size_t)row_stride < row_size) {
+		detexSetErrorMessage("%s: Row stride %d is smaller than the row size %zu", func_name,
+			row_stride, row_size);
+		return false;
+	}
+	else
+		*row_stride_out = row_stride;
+	return true;
+}
+
+static DETEX_INLINE_ONLY size_t GetTiledRowSize(const detexTexture *texture, uint32_t pixel_format) {
+	return (size_t)texture->width_in_blocks * detexGetPixelSize(pixel_format) * 16;
+}
+
+static DETEX_INLINE_ONLY size_t GetLinearRowSize(const detexTexture *texture, uint32_t pixel_format) {
+	return (size_t)texture->width * detexGetPixelSize(pixel_format);
+}
+
+// Convert the pixel rows of an uncompressed texture into an image with the given row stride.
+static bool ConvertUncompressedRows(const detexTexture *texture, int x, int y, int width, int height,
+uint8_t * DETEX_RESTRICT pixel_buffer, size_t row_stride, uint32_t pixel_format) {
+	uint32_t source_pixel_format = detexGetPixelFormat(texture->format);
+	int source_pixel_size = detexGetPixelSize(source_pixel_format);
+	if (x == 0 && width == texture->width && row_stride == (size_t)width * detexGetPixelSize(pixel_format))
+		// The rows are contiguous in both buffers.
+		return detexConvertPixels(texture->data + (size_t)y * width * source_pixel_size,
+			width * height, source_pixel_format, pixel_buffer, pixel_format);
+	for (int row = 0; row < height; row++)
+		if (!detexConvertPixels(texture->data + ((size_t)(y + row) * texture->width + x) *
+		source_pixel_size, width, source_pixel_format,
+		pixel_buffer + (size_t)row * row_stride, pixel_format))
+			return false;
+	return true;
+}
+
 /*
  * Decode texture function (tiled). Decode an entire compressed texture into an
  * array of image buffer tiles (corresponding to compressed blocks), converting
@@ -76,25 +326,26 @@ uint32_t pixel_format) {
  */
 bool detexDecompressTextureTiled(const detexTexture *texture,
 uint8_t * DETEX_RESTRICT pixel_buffer, uint32_t pixel_format) {
+	return detexDecompressTextureTiledStride(texture, pixel_buffer, 0, pixel_format);
+}
+
+/*
+ * Version of detexDecompressTextureTiled with consecutive rows of tiles stored
+ * row_stride bytes apart in pixel_buffer.
+ */
+bool detexDecompressTextureTiledStride(const detexTexture *texture,
+uint8_t * DETEX_RESTRICT pixel_buffer, int row_stride, uint32_t pixel_format) {
 	if (!detexFormatIsCompressed(texture->format)) {
-		detexSetErrorMessage("detexDecompressTextureTiled: Cannot handle uncompressed texture format");
+		detexSetErrorMessage("detexDecompressTextureTiledStride: Cannot handle uncompressed "
+			"texture format");
 		return false;
 	}
-	const uint8_t *data = texture->data;
-	bool result = true;
-	for (int y = 0; y < texture->height_in_blocks; y++)
-		for (int x = 0; x < texture->width_in_blocks; x++) {
-			bool r = detexDecompressBlock(data, texture->format,
-				DETEX_MODE_MASK_ALL, 0, pixel_buffer, pixel_format);
-			uint32_t block_size = detexGetPixelSize(pixel_format) * 16;
-			if (!r) {
-				result = false;
-				memset(pixel_buffer, 0, block_size);
-			}
-			data += detexGetCompressedBlockSize(texture->format);
-			pixel_buffer += block_size;
-		}
-	return result;
+	size_t stride;
+	if (!GetRowStride("detexDecompressTextureTiledStride", row_stride, GetTiledRowSize(texture,
+	pixel_format), &stride))
+		return false;
+	return DecompressTiledBlockRows(texture, pixel_buffer, stride, pixel_format, 0,
+		texture->height_in_blocks);
 }
 
 /*
@@ -104,43 +355,236 @@ uint8_t * DETEX_RESTRICT pixel_buffer, uint32_t pixel_format) {
  */
 bool detexDecompressTextureLinear(const detexTexture *texture,
 uint8_t * DETEX_RESTRICT pixel_buffer, uint32_t pixel_format) {
-	uint8_t block_buffer[DETEX_MAX_BLOCK_SIZE];
-	if (!detexFormatIsCompressed(texture->format)) {
-		return detexConvertPixels(texture->data, texture->width * texture->height,
-			detexGetPixelFormat(texture->format), pixel_buffer, pixel_format);
+	return detexDecompressTextureLinearStride(texture, pixel_buffer, 0, pixel_format);
+}
+
+/*
+ * Version of detexDecompressTextureLinear with consecutive pixel rows stored
+ * row_stride bytes apart in pixel_buffer.
+ */
+bool detexDecompressTextureLinearStride(const detexTexture *texture,
+uint8_t * DETEX_RESTRICT pixel_buffer, int row_stride, uint32_t pixel_format) {
+	size_t stride;
+	if (!GetRowStride("detexDecompressTextureLinearStride", row_stride, GetLinearRowSize(texture,
+	pixel_format), &stride))
+		return false;
+	if (!detexFormatIsCompressed(texture->format))
+		return ConvertUncompressedRows(texture, 0, 0, texture->width, texture->height,
+			pixel_buffer, stride, pixel_format);
+	return DecompressLinearBlockRows(texture, pixel_buffer, stride, pixel_format, 0,
+		texture->height_in_blocks);
+}
+
+/*
+ * Decode a rectangular region of a texture into an image buffer, converting
+ * into the given pixel format. Only the compressed blocks that overlap the
+ * region are decompressed.
+ */
+bool detexDecompressTextureRegion(const detexTexture *texture, int x, int y, int width, int height,
+uint8_t * DETEX_RESTRICT pixel_buffer, int row_stride, uint32_t pixel_format) {
+	if (x < 0 || y < 0 || width < 0 || height < 0 || x + width > texture->width ||
+	y + height > texture->height) {
+		detexSetErrorMessage("detexDecompressTextureRegion: Region (%d, %d, %d x %d) is outside "
+			"the texture (%d x %d)", x, y, width, height, texture->width, texture->height);
+		return false;
 	}
-	const uint8_t *data = texture->data;
-	int pixel_size = detexGetPixelSize(pixel_format);
-	bool result = true;
-	for (int y = 0; y < texture->height_in_blocks; y++) {
-		int nu_rows;
-		if (y * 4 + 3 >= texture->height)
-			nu_rows = texture->height - y * 4;
+	size_t stride;
+	if (!GetRowStride("detexDecompressTextureRegion", row_stride, (size_t)width *
+	detexGetPixelSize(pixel_format), &stride))
+		return false;
+	if (width == 0 || height == 0)
+		return true;
+	if (!detexFormatIsCompressed(texture->format))
+		return ConvertUncompressedRows(texture, x, y, width, height, pixel_buffer, stride,
+			pixel_format);
+	return DecompressLinearRegion(texture, x, y, width, height, pixel_buffer, stride,
+		pixel_format);
+}
+
+// Parallel decompression. The block rows of the texture are split into contiguous bands,
+// each of which is decoded by the same code as the serial path, so that the output is
+// identical.
+
+typedef bool (*DecompressBlockRowsFuncType)(const detexTexture *texture, uint8_t *pixel_buffer,
+	size_t row_stride, uint32_t pixel_format, int y_start, int y_end);
+
+typedef struct {
+	DecompressBlockRowsFuncType func;
+	const detexTexture *texture;
+	uint8_t *pixel_buffer;
+	size_t row_stride;
+	uint32_t pixel_format;
+	int nu_bands;
+	// HDR parameters in effect for the calling thread, which are thread-local.
+	detexHDRParameters hdr_parameters;
+	bool *band_result;
+} ParallelDecompressionInfo;
+
+typedef struct {
+	ParallelDecompressionInfo *info;
+	int band;
+} ParallelDecompressionThreadInfo;
+
+static void DecompressBand(void *data, int band) {
+	ParallelDecompressionInfo *info = (ParallelDecompressionInfo *)data;
+	int height_in_blocks = info->texture->height_in_blocks;
+	int y_start = (int)((int64_t)band * height_in_blocks / info->nu_bands);
+	int y_end = (int)((int64_t)(band + 1) * height_in_blocks / info->nu_bands);
+	// Use the parameters of the caller without changing those of a pool thread.
+	const detexHDRParameters *previous_params = detexSetActiveHDRParameters(&info->hdr_parameters);
+	info->band_result[band] = info->func(info->texture, info->pixel_buffer, info->row_stride,
+		info->pixel_format, y_start, y_end);
+	detexSetActiveHDRParameters(previous_params);
+}
+
+static void *DecompressBandThread(void *data) {
+	ParallelDecompressionThreadInfo *thread_info = (ParallelDecompressionThreadInfo *)data;
+	DecompressBand(thread_info->info, thread_info->band);
+	// Failures are reported through band_result; the calling thread sets the error message.
+	detexFreeErrorMessage();
+	return NULL;
+}
+
+// Run the bands using either the caller-supplied worker pool or nu_bands - 1 newly created
+// threads, with the calling thread decoding the first band.
+static void RunBands(ParallelDecompressionInfo *info, const detexWorkerPool *pool) {
+	if (pool != NULL) {
+		pool->dispatch(pool->pool_data, info->nu_bands, DecompressBand, info);
+		return;
+	}
+	pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * info->nu_bands);
+	bool *thread_created = (bool *)malloc(sizeof(bool) * info->nu_bands);
+	ParallelDecompressionThreadInfo *thread_info = (ParallelDecompressionThreadInfo *)
+		malloc(sizeof(ParallelDecompressionThreadInfo) * info->nu_bands);
+	if (threads == NULL || thread_created == NULL || thread_info == NULL) {
+		// Out of memory; decode all bands on the calling thread.
+		for (int i = 0; i < info->nu_bands; i++)
+			DecompressBand(info, i);
+		free(thread_info);
+		free(thread_created);
+		free(threads);
+		return;
+	}
+	for (int i = 1; i < info->nu_bands; i++) {
+		thread_info[i].info = info;
+		thread_info[i].band = i;
+		thread_created[i] = (pthread_create(&threads[i], NULL, DecompressBandThread,
+			&thread_info[i]) == 0);
+	}
+	DecompressBand(info, 0);
+	for (int i = 1; i < info->nu_bands; i++)
+		if (thread_created[i])
+			pthread_join(threads[i], NULL);
 		else
-			nu_rows = 4;
-		for (int x = 0; x < texture->width_in_blocks; x++) {
-			bool r = detexDecompressBlock(data, texture->format,
-				DETEX_MODE_MASK_ALL, 0, block_buffer, pixel_format);
-			uint32_t block_size = detexGetPixelSize(pixel_format) * 16;
-			if (!r) {
-				result = false;
-				memset(block_buffer, 0, block_size);
-			}
-			uint8_t *pixelp = pixel_buffer +
-				y * 4 * texture->width * pixel_size +
-				+ x * 4 * pixel_size;
-			int nu_columns;
-			if (x * 4 + 3  >= texture->width)
-				nu_columns = texture->width - x * 4;
-			else
-				nu_columns = 4;
-			for (int row = 0; row < nu_rows; row++)
-				memcpy(pixelp + row * texture->width * pixel_size,
-					block_buffer + row * 4 * pixel_size,
-					nu_columns * pixel_size);
-			data += detexGetCompressedBlockSize(texture->format);
+			// Thread creation failed; decode the band on the calling thread.
+			DecompressBand(info, i);
+	free(thread_info);
+	free(thread_created);
+	free(threads);
+}
+
+static bool DecompressTextureParallel(const char *func_name, DecompressBlockRowsFuncType func,
+const detexTexture *texture, uint8_t *pixel_buffer, size_t row_stride, uint32_t pixel_format,
+int nu_threads, const detexWorkerPool *pool) {
+	if (nu_threads <= 0) {
+		long nu_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nu_threads = nu_cpus > 0 ? (int)nu_cpus : 1;
+	}
+	if (nu_threads > texture->height_in_blocks)
+		nu_threads = texture->height_in_blocks;
+	if (nu_threads <= 1 && pool == NULL)
+		return func(texture, pixel_buffer, row_stride, pixel_format, 0, texture->height_in_blocks);
+	if (nu_threads < 1)
+		nu_threads = 1;
+	ParallelDecompressionInfo info;
+	info.func = func;
+	info.texture = texture;
+	info.pixel_buffer = pixel_buffer;
+	info.row_stride = row_stride;
+	info.pixel_format = pixel_format;
+	info.nu_bands = nu_threads;
+	info.hdr_parameters = *detexGetHDRParameters();
+	info.band_result = (bool *)malloc(sizeof(bool) * nu_threads);
+	if (info.band_result == NULL)
+		// Out of memory; use the serial path.
+		return func(texture, pixel_buffer, row_stride, pixel_format, 0, texture->height_in_blocks);
+	RunBands(&info, pool);
+	bool result = true;
+	int first_failed_band = - 1;
+	int nu_failed_bands = 0;
+	for (int i = 0; i < nu_threads; i++)
+		if (!info.band_result[i]) {
+			result = false;
+			if (first_failed_band < 0)
+				first_failed_band = i;
+			nu_failed_bands++;
 		}
+	free(info.band_result);
+	if (!result) {
+		// Error messages are thread-local, so report the failure from the calling thread.
+		int y_start = (int)((int64_t)first_failed_band * texture->height_in_blocks / nu_threads);
+		detexSetErrorMessage("%s: Decompression failed for %d of %d bands (first failure in band "
+			"starting at block row %d)", func_name, nu_failed_bands, nu_threads, y_start);
 	}
 	return result;
 }
 
+/*
+ * Parallel version of detexDecompressTextureTiled. The texture is split into
+ * bands of block rows which are decoded concurrently; the output is identical
+ * to that of the serial function.
+ */
+bool detexDecompressTextureTiledParallel(const detexTexture *texture,
+uint8_t * DETEX_RESTRICT pixel_buffer, uint32_t pixel_format, int nu_threads,
+const detexWorkerPool *pool) {
+	return detexDecompressTextureTiledStrideParallel(texture, pixel_buffer, 0, pixel_format,
+		nu_threads, pool);
+}
+
+/*
+ * Parallel version of detexDecompressTextureTiledStride.
+ */
+bool detexDecompressTextureTiledStrideParallel(const detexTexture *texture,
+uint8_t * DETEX_RESTRICT pixel_buffer, int row_stride, uint32_t pixel_format, int nu_threads,
+const detexWorkerPool *pool) {
+	if (!detexFormatIsCompressed(texture->format)) {
+		detexSetErrorMessage("detexDecompressTextureTiledStrideParallel: Cannot handle "
+			"uncompressed texture format");
+		return false;
+	}
+	size_t stride;
+	if (!GetRowStride("detexDecompressTextureTiledStrideParallel", row_stride,
+	GetTiledRowSize(texture, pixel_format), &stride))
+		return false;
+	return DecompressTextureParallel("detexDecompressTextureTiledStrideParallel",
+		DecompressTiledBlockRows, texture, pixel_buffer, stride, pixel_format, nu_threads, pool);
+}
+
+/*
+ * Parallel version of detexDecompressTextureLinear. The texture is split into
+ * bands of block rows which are decoded concurrently; the output is identical
+ * to that of the serial function.
+ */
+bool detexDecompressTextureLinearParallel(const detexTexture *texture,
+uint8_t * DETEX_RESTRICT pixel_buffer, uint32_t pixel_format, int nu_threads,
+const detexWorkerPool *pool) {
+	return detexDecompressTextureLinearStrideParallel(texture, pixel_buffer, 0, pixel_format,
+		nu_threads, pool);
+}
+
+/*
+ * Parallel version of detexDecompressTextureLinearStride.
+ */
+bool detexDecompressTextureLinearStrideParallel(const detexTexture *texture,
+uint8_t * DETEX_RESTRICT pixel_buffer, int row_stride, uint32_t pixel_format, int nu_threads,
+const detexWorkerPool *pool) {
+	size_t stride;
+	if (!GetRowStride("detexDecompressTextureLinearStrideParallel", row_stride,
+	GetLinearRowSize(texture, pixel_format), &stride))
+		return false;
+	if (!detexFormatIsCompressed(texture->format))
+		return ConvertUncompressedRows(texture, 0, 0, texture->width, texture->height,
+			pixel_buffer, stride, pixel_format);
+	return DecompressTextureParallel("detexDecompressTextureLinearStrideParallel",
+		DecompressLinearBlockRows, texture, pixel_buffer, stride, pixel_format, nu_threads, pool);
+}